@@ -0,0 +1,532 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+// 二进制 DAG 文件格式（小端，各段 8 字节对齐）
+//
+//   [DagFileHeader]
+//   [offsets   ] uint32[n + 1]    CSR 行偏移
+//   [targets   ] uint32[m]        CSR 后继节点
+//   [meta      ] DagNodeMeta[n]   每个节点的元数据，名字指向字符串区
+//   [name index] uint32[cap]      名字 -> 节点号的开放寻址哈希表，空槽为 kEmptySlot
+//   [strings   ] char[]           所有任务名，每个以 '\0' 结尾（驻留，一个名字只存一份）
+//
+// 加载时 mmap 后校验头部，再顺序扫一遍各段（O(n+m)，不分配），节点号就是数组下标
+const char kDagMagic[8] = {'D', 'A', 'G', 'B', 'I', 'N', '\0', '\0'};
+const uint32_t kDagVersion = 1;
+const uint32_t kEmptySlot = UINT32_MAX;
+
+struct DagFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t node_count;
+    uint64_t edge_count;
+    uint64_t offsets_pos;
+    uint64_t targets_pos;
+    uint64_t meta_pos;
+    uint64_t index_pos;
+    uint64_t index_capacity;
+    uint64_t strings_pos;
+    uint64_t strings_size;
+    uint64_t file_size;
+};
+
+struct DagNodeMeta
+{
+    uint32_t name_pos;    // 在字符串区中的偏移
+    uint32_t name_len;
+    int32_t priority;
+    uint32_t cost_us;     // 预估耗时（微秒），用于关键路径等调度策略
+};
+
+static_assert(sizeof(DagFileHeader) == 96, "DagFileHeader layout changed");
+static_assert(sizeof(DagNodeMeta) == 16, "DagNodeMeta layout changed");
+
+// FNV-1a，写入和查找两端必须一致
+inline uint32_t hashName(const char* data, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; ++i)
+    {
+        h ^= uint8_t(data[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+inline uint64_t alignUp(uint64_t pos) { return (pos + 7) & ~uint64_t(7); }
+
+// 写入端：接口和 StringDAGScheduler 一致，离线把字符串边表转成二进制文件
+class DagFileWriter
+{
+public:
+    void addDependency(const string& from, const string& to)
+    {
+        uint32_t u = intern(from);
+        uint32_t v = intern(to);
+        _edges.emplace_back(u, v);
+    }
+
+    void setMeta(const string& task, int32_t priority, uint32_t cost_us)
+    {
+        uint32_t id = intern(task);
+        _meta[id].priority = priority;
+        _meta[id].cost_us = cost_us;
+    }
+
+    void write(const string& path) const
+    {
+        const uint64_t n = _names.size();
+        const uint64_t m = _edges.size();
+        if (n >= kEmptySlot || m >= UINT32_MAX)
+        {
+            throw runtime_error("图太大，超出 32 位下标范围");
+        }
+
+        // CSR：计数排序
+        vector<uint32_t> offsets(n + 1, 0);
+        for (auto& e : _edges) offsets[e.first + 1]++;
+        for (uint64_t i = 0; i < n; ++i) offsets[i + 1] += offsets[i];
+        vector<uint32_t> targets(m);
+        vector<uint32_t> pos(offsets.begin(), offsets.end() - 1);
+        for (auto& e : _edges) targets[pos[e.first]++] = e.second;
+
+        // 字符串区与名字索引
+        string strings;
+        vector<DagNodeMeta> meta(_meta);
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            meta[i].name_pos = uint32_t(strings.size());
+            meta[i].name_len = uint32_t(_names[i].size());
+            strings += _names[i];
+            strings.push_back('\0');
+        }
+        uint64_t capacity = 1;
+        while (capacity < n * 2) capacity <<= 1;
+        vector<uint32_t> index(capacity, kEmptySlot);
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            uint64_t slot = hashName(_names[i].data(), _names[i].size()) & (capacity - 1);
+            while (index[slot] != kEmptySlot) slot = (slot + 1) & (capacity - 1);
+            index[slot] = uint32_t(i);
+        }
+
+        DagFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, kDagMagic, sizeof(kDagMagic));
+        header.version = kDagVersion;
+        header.header_size = sizeof(DagFileHeader);
+        header.node_count = n;
+        header.edge_count = m;
+        header.offsets_pos = alignUp(sizeof(DagFileHeader));
+        header.targets_pos = alignUp(header.offsets_pos + offsets.size() * sizeof(uint32_t));
+        header.meta_pos = alignUp(header.targets_pos + targets.size() * sizeof(uint32_t));
+        header.index_pos = alignUp(header.meta_pos + meta.size() * sizeof(DagNodeMeta));
+        header.index_capacity = capacity;
+        header.strings_pos = alignUp(header.index_pos + index.size() * sizeof(uint32_t));
+        header.strings_size = strings.size();
+        header.file_size = header.strings_pos + strings.size();
+
+        // 先写临时文件再改名，避免读到写了一半的文件
+        string tmp = path + ".tmp";
+        ofstream ofs(tmp, ios::binary | ios::trunc);
+        if (!ofs)
+        {
+            throw runtime_error("无法写入文件: " + tmp);
+        }
+        auto writeAt = [&ofs](uint64_t pos, const void* data, size_t size) {
+            static const char zeros[8] = {0};
+            uint64_t cur = uint64_t(ofs.tellp());
+            ofs.write(zeros, pos - cur);
+            ofs.write(static_cast<const char*>(data), size);
+        };
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeAt(header.offsets_pos, offsets.data(), offsets.size() * sizeof(uint32_t));
+        writeAt(header.targets_pos, targets.data(), targets.size() * sizeof(uint32_t));
+        writeAt(header.meta_pos, meta.data(), meta.size() * sizeof(DagNodeMeta));
+        writeAt(header.index_pos, index.data(), index.size() * sizeof(uint32_t));
+        writeAt(header.strings_pos, strings.data(), strings.size());
+        ofs.close();
+        if (!ofs || rename(tmp.c_str(), path.c_str()) != 0)
+        {
+            throw runtime_error("写入文件失败: " + path);
+        }
+    }
+
+private:
+    uint32_t intern(const string& name)
+    {
+        auto it = _ids.find(name);
+        if (it != _ids.end()) return it->second;
+        uint32_t id = uint32_t(_names.size());
+        _ids.emplace(name, id);
+        _names.push_back(name);
+        _meta.push_back(DagNodeMeta{0, 0, 0, 0});
+        return id;
+    }
+
+private:
+    unordered_map<string, uint32_t> _ids;
+    vector<string> _names;
+    vector<DagNodeMeta> _meta;
+    vector<pair<uint32_t, uint32_t> > _edges;
+};
+
+// 读取端：mmap 整个文件，所有访问都直接落在映射内存上
+class MappedDag
+{
+public:
+    explicit MappedDag(const string& path)
+    {
+        _fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (_fd < 0)
+        {
+            throw runtime_error("无法打开文件: " + path);
+        }
+        struct stat st;
+        if (fstat(_fd, &st) != 0 || size_t(st.st_size) < sizeof(DagFileHeader))
+        {
+            close(_fd);
+            throw runtime_error("文件过小: " + path);
+        }
+        _size = size_t(st.st_size);
+        void* addr = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+        if (addr == MAP_FAILED)
+        {
+            close(_fd);
+            throw runtime_error("mmap 失败: " + path);
+        }
+        _base = static_cast<const char*>(addr);
+        _header = reinterpret_cast<const DagFileHeader*>(_base);
+        try
+        {
+            validate();
+            validateData();
+        }
+        catch (...)
+        {
+            munmap(const_cast<char*>(_base), _size);
+            close(_fd);
+            throw;
+        }
+    }
+
+    ~MappedDag()
+    {
+        munmap(const_cast<char*>(_base), _size);
+        close(_fd);
+    }
+
+    MappedDag(const MappedDag&) = delete;
+    MappedDag& operator=(const MappedDag&) = delete;
+
+    uint32_t nodeCount() const { return uint32_t(_header->node_count); }
+    uint64_t edgeCount() const { return _header->edge_count; }
+    const uint32_t* offsets() const { return section<uint32_t>(_header->offsets_pos); }
+    const uint32_t* targets() const { return section<uint32_t>(_header->targets_pos); }
+    const DagNodeMeta& meta(uint32_t id) const { return section<DagNodeMeta>(_header->meta_pos)[id]; }
+
+    // 任务名直接指向映射内存，以 '\0' 结尾
+    const char* name(uint32_t id) const
+    {
+        return _base + _header->strings_pos + meta(id).name_pos;
+    }
+
+    // 按名字查节点号，找不到返回 kEmptySlot
+    uint32_t find(const string& task) const
+    {
+        const uint32_t* index = section<uint32_t>(_header->index_pos);
+        uint64_t mask = _header->index_capacity - 1;
+        uint64_t slot = hashName(task.data(), task.size()) & mask;
+        while (index[slot] != kEmptySlot)
+        {
+            uint32_t id = index[slot];
+            if (meta(id).name_len == task.size() && memcmp(name(id), task.data(), task.size()) == 0)
+            {
+                return id;
+            }
+            slot = (slot + 1) & mask;
+        }
+        return kEmptySlot;
+    }
+
+private:
+    template<typename T>
+    const T* section(uint64_t pos) const { return reinterpret_cast<const T*>(_base + pos); }
+
+    // 段 [pos, pos + count * elem) 是否在 [begin, limit) 内且 8 字节对齐，乘法和加法都先检查溢出
+    static bool sectionFits(uint64_t pos, uint64_t count, uint64_t elem, uint64_t begin, uint64_t limit)
+    {
+        if (pos < begin || pos > limit || pos % 8 != 0) return false;
+        return count <= (limit - pos) / elem;
+    }
+
+    // 头部和各段边界，O(1)
+    void validate() const
+    {
+        const DagFileHeader& h = *_header;
+        if (memcmp(h.magic, kDagMagic, sizeof(kDagMagic)) != 0)
+        {
+            throw runtime_error("不是 DAG 二进制文件");
+        }
+        if (h.version != kDagVersion || h.header_size != sizeof(DagFileHeader))
+        {
+            throw runtime_error("DAG 文件版本不兼容");
+        }
+        // 与写入端相同的 32 位下标限制，之后 node_count + 1、index_capacity 等都不会溢出
+        if (h.file_size != _size || h.node_count >= kEmptySlot || h.edge_count >= UINT32_MAX
+            || h.index_capacity <= h.node_count || (h.index_capacity & (h.index_capacity - 1)) != 0
+            || !sectionFits(h.offsets_pos, h.node_count + 1, sizeof(uint32_t), sizeof(DagFileHeader), _size)
+            || !sectionFits(h.targets_pos, h.edge_count, sizeof(uint32_t), h.offsets_pos + (h.node_count + 1) * sizeof(uint32_t), _size)
+            || !sectionFits(h.meta_pos, h.node_count, sizeof(DagNodeMeta), h.targets_pos + h.edge_count * sizeof(uint32_t), _size)
+            || !sectionFits(h.index_pos, h.index_capacity, sizeof(uint32_t), h.meta_pos + h.node_count * sizeof(DagNodeMeta), _size)
+            || !sectionFits(h.strings_pos, h.strings_size, 1, h.index_pos + h.index_capacity * sizeof(uint32_t), _size))
+        {
+            throw runtime_error("DAG 文件已损坏");
+        }
+    }
+
+    // 扫一遍各段内容，之后 scheduleMapped、name、find 按下标访问都不会越界
+    //   - offsets 从 0 开始单调不减，最后一项等于 edge_count
+    //   - targets 都小于 node_count
+    //   - 每个名字落在字符串区内并以 '\0' 结尾
+    //   - 名字索引只含合法节点号，且恰好 node_count 个非空槽（容量更大，find 总能遇到空槽停下）
+    void validateData() const
+    {
+        const DagFileHeader& h = *_header;
+        const uint64_t n = h.node_count;
+        const uint32_t* offs = offsets();
+        if (offs[0] != 0 || offs[n] != h.edge_count)
+        {
+            throw runtime_error("DAG 文件已损坏：CSR 偏移");
+        }
+        for (uint64_t u = 0; u < n; ++u)
+        {
+            if (offs[u] > offs[u + 1]) throw runtime_error("DAG 文件已损坏：CSR 偏移");
+        }
+        const uint32_t* tgts = targets();
+        for (uint64_t i = 0; i < h.edge_count; ++i)
+        {
+            if (tgts[i] >= n) throw runtime_error("DAG 文件已损坏：后继节点越界");
+        }
+        const char* strings = _base + h.strings_pos;
+        for (uint64_t u = 0; u < n; ++u)
+        {
+            const DagNodeMeta& m = meta(uint32_t(u));
+            if (m.name_pos >= h.strings_size || m.name_len >= h.strings_size - m.name_pos
+                || strings[m.name_pos + m.name_len] != '\0')
+            {
+                throw runtime_error("DAG 文件已损坏：任务名越界");
+            }
+        }
+        const uint32_t* index = section<uint32_t>(h.index_pos);
+        uint64_t used = 0;
+        for (uint64_t slot = 0; slot < h.index_capacity; ++slot)
+        {
+            if (index[slot] == kEmptySlot) continue;
+            if (index[slot] >= n) throw runtime_error("DAG 文件已损坏：名字索引越界");
+            ++used;
+        }
+        if (used != n)
+        {
+            throw runtime_error("DAG 文件已损坏：名字索引");
+        }
+    }
+
+private:
+    int _fd = -1;
+    size_t _size = 0;
+    const char* _base = nullptr;
+    const DagFileHeader* _header = nullptr;
+};
+
+// 直接在映射内存上做 Kahn 拓扑排序，唯一的分配是入度表和结果
+vector<uint32_t> scheduleMapped(const MappedDag& dag)
+{
+    const uint32_t n = dag.nodeCount();
+    const uint32_t* offsets = dag.offsets();
+    const uint32_t* targets = dag.targets();
+    vector<uint32_t> indegree(n, 0);
+    for (uint64_t i = 0; i < dag.edgeCount(); ++i) indegree[targets[i]]++;
+
+    vector<uint32_t> order;
+    order.reserve(n);
+    for (uint32_t u = 0; u < n; ++u)
+    {
+        if (indegree[u] == 0) order.push_back(u);
+    }
+    for (size_t head = 0; head < order.size(); ++head)
+    {
+        uint32_t u = order[head];
+        for (uint32_t i = offsets[u]; i < offsets[u + 1]; ++i)
+        {
+            if (--indegree[targets[i]] == 0) order.push_back(targets[i]);
+        }
+    }
+    if (order.size() != n)
+    {
+        throw runtime_error("存在循环依赖！");
+    }
+    return order;
+}
+
+// 转换器：文本边表（每行 "前置任务 后续任务"，# 开头为注释）-> 二进制文件
+void convertEdgeList(const string& text_path, const string& bin_path)
+{
+    ifstream ifs(text_path);
+    if (!ifs)
+    {
+        throw runtime_error("无法打开文件: " + text_path);
+    }
+    DagFileWriter writer;
+    string line;
+    while (getline(ifs, line))
+    {
+        if (line.empty() || line[0] == '#') continue;
+        istringstream iss(line);
+        string from, to;
+        if (!(iss >> from >> to))
+        {
+            throw runtime_error("格式错误: " + line);
+        }
+        writer.addDependency(from, to);
+    }
+    writer.write(bin_path);
+}
+
+double elapsedMs(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+void test1()
+{
+    string text_path = "/tmp/dag_edges.txt";
+    string bin_path = "/tmp/dag_edges.dagbin";
+    {
+        ofstream ofs(text_path);
+        ofs << "# 前置任务 后续任务\n"
+            << "编译 链接\n"
+            << "清理数据 预处理\n"
+            << "预处理 编译\n"
+            << "下载依赖 编译\n";
+    }
+    convertEdgeList(text_path, bin_path);
+
+    MappedDag dag(bin_path);
+    cout << "调度顺序：";
+    for (uint32_t id : scheduleMapped(dag))
+    {
+        cout << dag.name(id) << " → ";
+    }
+    cout << "结束" << endl;
+    cout << "find(编译) = " << dag.find("编译") << ", find(打包) = "
+         << (dag.find("打包") == kEmptySlot ? "不存在" : "存在") << endl;
+
+    // 改坏一个后继节点号：加载时就被拒绝，不会在调度时越界写入度表
+    {
+        fstream fs(bin_path, ios::in | ios::out | ios::binary);
+        DagFileHeader header;
+        fs.read(reinterpret_cast<char*>(&header), sizeof(header));
+        uint32_t bad = uint32_t(header.node_count) + 100;
+        fs.seekp(header.targets_pos);
+        fs.write(reinterpret_cast<const char*>(&bad), sizeof(bad));
+    }
+    try
+    {
+        MappedDag corrupt(bin_path);
+        cout << "损坏的文件被加载了！" << endl;
+    }
+    catch (const runtime_error& e)
+    {
+        cout << "加载损坏的文件: " << e.what() << endl;
+    }
+    remove(text_path.c_str());
+    remove(bin_path.c_str());
+}
+
+// 启动耗时基准：字符串逐边构建 vs mmap 加载
+// 用法：dag_binary [节点数] [边数]，默认 2000000 4000000
+void bench(uint32_t n, size_t m)
+{
+    mt19937_64 rng(42);
+    uniform_int_distribution<uint32_t> dist(0, n - 1);
+    vector<pair<uint32_t, uint32_t> > edges;
+    edges.reserve(m);
+    while (edges.size() < m)
+    {
+        uint32_t a = dist(rng);
+        uint32_t b = dist(rng);
+        if (a == b) continue;
+        edges.emplace_back(min(a, b), max(a, b));
+    }
+    vector<string> names(n);
+    for (uint32_t i = 0; i < n; ++i) names[i] = "task_" + to_string(i);
+
+    // 现状：和 StringDAGScheduler 一样逐边哈希字符串建图
+    auto start = chrono::steady_clock::now();
+    {
+        unordered_map<string, int> inDegree;
+        unordered_map<string, vector<string> > adj;
+        unordered_map<string, bool> knownTasks;
+        for (auto& e : edges)
+        {
+            adj[names[e.first]].push_back(names[e.second]);
+            inDegree[names[e.second]]++;
+            knownTasks[names[e.first]] = true;
+            knownTasks[names[e.second]] = true;
+        }
+        cout << "string build:  " << elapsedMs(start) << " ms (" << knownTasks.size() << " tasks)" << endl;
+        start = chrono::steady_clock::now();
+    }
+    cout << "string free:   " << elapsedMs(start) << " ms" << endl;
+
+    string bin_path = "/tmp/dag_bench.dagbin";
+    start = chrono::steady_clock::now();
+    {
+        DagFileWriter writer;
+        for (auto& e : edges) writer.addDependency(names[e.first], names[e.second]);
+        writer.write(bin_path);
+    }
+    cout << "convert:       " << elapsedMs(start) << " ms (offline)" << endl;
+
+    start = chrono::steady_clock::now();
+    MappedDag dag(bin_path);
+    cout << "mmap load:     " << elapsedMs(start) << " ms (" << dag.nodeCount() << " nodes, "
+         << dag.edgeCount() << " edges)" << endl;
+
+    start = chrono::steady_clock::now();
+    vector<uint32_t> order = scheduleMapped(dag);
+    cout << "first schedule:" << elapsedMs(start) << " ms (" << order.size() << " tasks)" << endl;
+    remove(bin_path.c_str());
+}
+
+int main(int argc, char** argv)
+{
+    test1();
+
+    uint32_t n = argc > 1 ? uint32_t(strtoul(argv[1], nullptr, 10)) : 2000000;
+    size_t m = argc > 2 ? size_t(strtoull(argv[2], nullptr, 10)) : 4000000;
+    bench(n, m);
+    return 0;
+}
@@ -0,0 +1,483 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// CSR（压缩稀疏行）图：节点用 0..n-1 的整数编号
+// offsets[u]..offsets[u+1] 是 u 的后继在 targets 中的区间，整张图只有两块连续内存
+struct CsrGraph
+{
+    uint32_t n = 0;
+    vector<uint32_t> offsets;
+    vector<uint32_t> targets;
+
+    // 由边表构建：先统计出度，再前缀和，最后按位置回填（计数排序，O(V+E)）
+    static CsrGraph fromEdges(uint32_t n, const vector<pair<uint32_t, uint32_t> >& edges)
+    {
+        CsrGraph g;
+        g.n = n;
+        g.offsets.assign(n + 1, 0);
+        for (auto& e : edges) g.offsets[e.first + 1]++;
+        for (uint32_t i = 0; i < n; ++i) g.offsets[i + 1] += g.offsets[i];
+        g.targets.resize(edges.size());
+        vector<uint32_t> pos(g.offsets.begin(), g.offsets.end() - 1);
+        for (auto& e : edges) g.targets[pos[e.first]++] = e.second;
+        return g;
+    }
+
+    uint32_t begin(uint32_t u) const { return offsets[u]; }
+    uint32_t end(uint32_t u) const { return offsets[u + 1]; }
+    size_t edgeCount() const { return targets.size(); }
+};
+
+// 迭代版 DFS 拓扑排序：用显式栈保存 (节点, 下一条边的位置)，深图不会爆栈
+// 返回 false 表示有环
+bool topoDfs(const CsrGraph& g, vector<uint32_t>& order)
+{
+    // 0=未访问, 1=访问中, 2=已完成
+    vector<uint8_t> state(g.n, 0);
+    vector<pair<uint32_t, uint32_t> > stack;
+    order.clear();
+    order.reserve(g.n);
+    for (uint32_t root = 0; root < g.n; ++root)
+    {
+        if (state[root] != 0) continue;
+        state[root] = 1;
+        stack.emplace_back(root, g.begin(root));
+        while (!stack.empty())
+        {
+            uint32_t u = stack.back().first;
+            uint32_t& it = stack.back().second;
+            if (it < g.end(u))
+            {
+                uint32_t v = g.targets[it++];
+                if (state[v] == 1) return false;
+                if (state[v] == 0)
+                {
+                    state[v] = 1;
+                    stack.emplace_back(v, g.begin(v));
+                }
+                continue;
+            }
+            state[u] = 2;
+            order.push_back(u);
+            stack.pop_back();
+        }
+    }
+    reverse(order.begin(), order.end());
+    return true;
+}
+
+// 串行 Kahn，作为对照组
+bool topoKahn(const CsrGraph& g, vector<uint32_t>& order)
+{
+    vector<uint32_t> indegree(g.n, 0);
+    for (uint32_t v : g.targets) indegree[v]++;
+    order.clear();
+    order.reserve(g.n);
+    for (uint32_t u = 0; u < g.n; ++u)
+    {
+        if (indegree[u] == 0) order.push_back(u);
+    }
+    // order 本身就是队列：head 之前的已处理，之后的待处理
+    for (size_t head = 0; head < order.size(); ++head)
+    {
+        uint32_t u = order[head];
+        for (uint32_t i = g.begin(u); i < g.end(u); ++i)
+        {
+            if (--indegree[g.targets[i]] == 0) order.push_back(g.targets[i]);
+        }
+    }
+    return order.size() == g.n;
+}
+
+// 迭代版 Tarjan 强连通分量，只返回真正构成环的分量（大小>1 或有自环）
+// only 非空时只在 only[u] 为 true 的节点上求解
+vector<vector<uint32_t> > findCycles(const CsrGraph& g, const vector<bool>& only = {})
+{
+    const uint32_t kNone = UINT32_MAX;
+    vector<uint32_t> index(g.n, kNone);
+    vector<uint32_t> lowlink(g.n, 0);
+    vector<bool> on_stack(g.n, false);
+    vector<uint32_t> scc_stack;
+    vector<pair<uint32_t, uint32_t> > call_stack;
+    vector<vector<uint32_t> > cycles;
+    uint32_t counter = 0;
+
+    auto skip = [&only](uint32_t u) { return !only.empty() && !only[u]; };
+
+    for (uint32_t root = 0; root < g.n; ++root)
+    {
+        if (index[root] != kNone || skip(root)) continue;
+        index[root] = lowlink[root] = counter++;
+        scc_stack.push_back(root);
+        on_stack[root] = true;
+        call_stack.emplace_back(root, g.begin(root));
+        while (!call_stack.empty())
+        {
+            uint32_t u = call_stack.back().first;
+            uint32_t& it = call_stack.back().second;
+            if (it < g.end(u))
+            {
+                uint32_t v = g.targets[it++];
+                if (skip(v)) continue;
+                if (index[v] == kNone)
+                {
+                    index[v] = lowlink[v] = counter++;
+                    scc_stack.push_back(v);
+                    on_stack[v] = true;
+                    call_stack.emplace_back(v, g.begin(v));
+                }
+                else if (on_stack[v])
+                {
+                    lowlink[u] = min(lowlink[u], index[v]);
+                }
+                continue;
+            }
+            call_stack.pop_back();
+            if (!call_stack.empty())
+            {
+                uint32_t parent = call_stack.back().first;
+                lowlink[parent] = min(lowlink[parent], lowlink[u]);
+            }
+            if (lowlink[u] != index[u]) continue;
+
+            // u 是分量的根，弹出整个分量
+            vector<uint32_t> scc;
+            uint32_t w;
+            do
+            {
+                w = scc_stack.back();
+                scc_stack.pop_back();
+                on_stack[w] = false;
+                scc.push_back(w);
+            } while (w != u);
+            bool self_loop = false;
+            if (scc.size() == 1)
+            {
+                for (uint32_t i = g.begin(u); i < g.end(u); ++i)
+                {
+                    if (g.targets[i] == u) self_loop = true;
+                }
+            }
+            if (scc.size() > 1 || self_loop) cycles.push_back(move(scc));
+        }
+    }
+    return cycles;
+}
+
+// 常驻工作线程组：每一层由主线程发布任务，所有线程（包括主线程）按块领取
+class LevelWorkers
+{
+public:
+    explicit LevelWorkers(int num_threads)
+    {
+        for (int i = 1; i < num_threads; ++i)
+        {
+            _threads.emplace_back([this, i]() { WorkerLoop(i); });
+        }
+    }
+
+    ~LevelWorkers()
+    {
+        {
+            lock_guard<mutex> lock(_mutex);
+            _stop = true;
+        }
+        _cv.notify_all();
+        for (auto& t : _threads) t.join();
+    }
+
+    int size() const { return int(_threads.size()) + 1; }
+
+    // 并行执行 job(worker_id, begin, end)，把 [0, count) 按 chunk 切块动态领取
+    void parallelFor(size_t count, size_t chunk, function<void(int, size_t, size_t)> job)
+    {
+        {
+            lock_guard<mutex> lock(_mutex);
+            _job = move(job);
+            _count = count;
+            _chunk = chunk;
+            _next.store(0, memory_order_relaxed);
+            _running = int(_threads.size());
+            ++_generation;
+        }
+        _cv.notify_all();
+        RunChunks(0);
+        unique_lock<mutex> lock(_mutex);
+        _done_cv.wait(lock, [this]() { return _running == 0; });
+    }
+
+private:
+    void WorkerLoop(int id)
+    {
+        uint64_t seen = 0;
+        while (true)
+        {
+            {
+                unique_lock<mutex> lock(_mutex);
+                _cv.wait(lock, [this, seen]() { return _stop || _generation != seen; });
+                if (_stop) return;
+                seen = _generation;
+            }
+            RunChunks(id);
+            lock_guard<mutex> lock(_mutex);
+            if (--_running == 0) _done_cv.notify_one();
+        }
+    }
+
+    void RunChunks(int id)
+    {
+        while (true)
+        {
+            size_t begin = _next.fetch_add(_chunk, memory_order_relaxed);
+            if (begin >= _count) return;
+            _job(id, begin, min(begin + _chunk, _count));
+        }
+    }
+
+private:
+    vector<thread> _threads;
+    mutex _mutex;
+    condition_variable _cv;
+    condition_variable _done_cv;
+    function<void(int, size_t, size_t)> _job;
+    size_t _count = 0;
+    size_t _chunk = 1;
+    atomic<size_t> _next{0};
+    int _running = 0;
+    uint64_t _generation = 0;
+    bool _stop = false;
+};
+
+// 分层并行 Kahn：同一层的节点互不依赖，可以直接并行执行
+// 每层的前沿按块分给各线程，后继入度用原子减，减到 0 的线程负责把它放进下一层
+class LevelScheduler
+{
+public:
+    // 前沿小于该值时串行处理，避免深而窄的图在每层都付出同步开销
+    static const size_t kParallelThreshold = 4096;
+    static const size_t kChunk = 1024;
+
+    explicit LevelScheduler(int num_threads) : _workers(max(1, num_threads)) {}
+
+    // 成功返回 true，levels 为分层结果；有环返回 false，cycles 为环上的强连通分量
+    bool schedule(const CsrGraph& g, vector<vector<uint32_t> >& levels, vector<vector<uint32_t> >& cycles)
+    {
+        levels.clear();
+        cycles.clear();
+        vector<atomic<uint32_t> > indegree(g.n);
+        for (auto& d : indegree) d.store(0, memory_order_relaxed);
+        for (uint32_t v : g.targets) indegree[v].fetch_add(1, memory_order_relaxed);
+
+        vector<uint32_t> frontier;
+        for (uint32_t u = 0; u < g.n; ++u)
+        {
+            if (indegree[u].load(memory_order_relaxed) == 0) frontier.push_back(u);
+        }
+
+        vector<vector<uint32_t> > local_next(_workers.size());
+        size_t scheduled = 0;
+        while (!frontier.empty())
+        {
+            scheduled += frontier.size();
+            vector<uint32_t> next;
+            if (frontier.size() < kParallelThreshold || _workers.size() == 1)
+            {
+                for (uint32_t u : frontier) Relax(g, indegree, u, next);
+            }
+            else
+            {
+                _workers.parallelFor(frontier.size(), kChunk,
+                    [&](int id, size_t begin, size_t end) {
+                        for (size_t i = begin; i < end; ++i)
+                        {
+                            Relax(g, indegree, frontier[i], local_next[id]);
+                        }
+                    });
+                for (auto& part : local_next)
+                {
+                    next.insert(next.end(), part.begin(), part.end());
+                    part.clear();
+                }
+            }
+            levels.push_back(move(frontier));
+            frontier = move(next);
+        }
+
+        if (scheduled == g.n) return true;
+
+        // 入度没减到 0 的节点要么在环上，要么在环的下游；只在它们之中找环
+        vector<bool> remain(g.n, false);
+        for (uint32_t u = 0; u < g.n; ++u)
+        {
+            remain[u] = indegree[u].load(memory_order_relaxed) != 0;
+        }
+        cycles = findCycles(g, remain);
+        return false;
+    }
+
+    // 按层执行：层内并行，层间串行
+    void runLevels(const vector<vector<uint32_t> >& levels, function<void(uint32_t)> func)
+    {
+        for (auto& level : levels)
+        {
+            _workers.parallelFor(level.size(), 64, [&](int, size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) func(level[i]);
+            });
+        }
+    }
+
+private:
+    static void Relax(const CsrGraph& g, vector<atomic<uint32_t> >& indegree, uint32_t u, vector<uint32_t>& next)
+    {
+        for (uint32_t i = g.begin(u); i < g.end(u); ++i)
+        {
+            uint32_t v = g.targets[i];
+            if (indegree[v].fetch_sub(1, memory_order_acq_rel) == 1) next.push_back(v);
+        }
+    }
+
+    LevelWorkers _workers;
+};
+
+// 随机 DAG：只生成 rank 小的指向 rank 大的边保证无环，再随机打乱编号
+// 少于 2 个节点时连不出边，要求 m > 0 直接拒绝；m 超过 n 个节点最多能有的 n*(n-1)/2 条边时截到这个数
+CsrGraph randomDag(uint32_t n, size_t m, uint32_t seed)
+{
+    if (n < 2)
+    {
+        if (m > 0) throw invalid_argument("randomDag: need at least 2 nodes to generate edges");
+        return CsrGraph::fromEdges(n, {});
+    }
+    m = size_t(min<uint64_t>(m, uint64_t(n) * (n - 1) / 2));
+    mt19937_64 rng(seed);
+    vector<uint32_t> label(n);
+    for (uint32_t i = 0; i < n; ++i) label[i] = i;
+    shuffle(label.begin(), label.end(), rng);
+
+    vector<pair<uint32_t, uint32_t> > edges;
+    edges.reserve(m);
+    uniform_int_distribution<uint32_t> dist(0, n - 1);
+    while (edges.size() < m)
+    {
+        uint32_t a = dist(rng);
+        uint32_t b = dist(rng);
+        if (a == b) continue;
+        if (a > b) swap(a, b);
+        edges.emplace_back(label[a], label[b]);
+    }
+    return CsrGraph::fromEdges(n, edges);
+}
+
+bool checkOrder(const CsrGraph& g, const vector<uint32_t>& order)
+{
+    if (order.size() != g.n) return false;
+    vector<uint32_t> pos(g.n);
+    for (uint32_t i = 0; i < order.size(); ++i) pos[order[i]] = i;
+    for (uint32_t u = 0; u < g.n; ++u)
+    {
+        for (uint32_t i = g.begin(u); i < g.end(u); ++i)
+        {
+            if (pos[u] >= pos[g.targets[i]]) return false;
+        }
+    }
+    return true;
+}
+
+double elapsedMs(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+void test1()
+{
+    // 0 → 2 → 3 → 4，1 → 2，以及一个环 5 → 6 → 7 → 5 和环下游的 8
+    vector<pair<uint32_t, uint32_t> > edges = {
+        {0, 2}, {1, 2}, {2, 3}, {3, 4}, {5, 6}, {6, 7}, {7, 5}, {7, 8}};
+
+    CsrGraph dag = CsrGraph::fromEdges(5, {edges.begin(), edges.begin() + 4});
+    LevelScheduler scheduler(2);
+    vector<vector<uint32_t> > levels, cycles;
+    scheduler.schedule(dag, levels, cycles);
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        cout << "level " << i << ":";
+        for (uint32_t u : levels[i]) cout << " " << u;
+        cout << endl;
+    }
+
+    CsrGraph cyclic = CsrGraph::fromEdges(9, edges);
+    if (!scheduler.schedule(cyclic, levels, cycles))
+    {
+        for (auto& scc : cycles)
+        {
+            cout << "检测到循环依赖:";
+            for (uint32_t u : scc) cout << " " << u;
+            cout << endl;
+        }
+    }
+
+    // 一百万个节点的链，递归 DFS 在这里会爆栈
+    const uint32_t chain = 1000000;
+    vector<pair<uint32_t, uint32_t> > chain_edges;
+    for (uint32_t i = 0; i + 1 < chain; ++i) chain_edges.emplace_back(i, i + 1);
+    CsrGraph deep = CsrGraph::fromEdges(chain, chain_edges);
+    vector<uint32_t> order;
+    cout << "deep chain dfs: " << (topoDfs(deep, order) && checkOrder(deep, order) ? "ok" : "fail") << endl;
+}
+
+// 基准：默认 1M 节点、10M 条边的随机 DAG
+// 用法：dag_csr [节点数] [边数] [线程数]
+void bench(uint32_t n, size_t m, int threads)
+{
+    auto start = chrono::steady_clock::now();
+    CsrGraph g = randomDag(n, m, 42);
+    cout << "build " << n << " nodes " << g.edgeCount() << " edges: " << elapsedMs(start) << " ms" << endl;
+
+    vector<uint32_t> order;
+    start = chrono::steady_clock::now();
+    bool ok = topoKahn(g, order);
+    cout << "serial kahn:    " << elapsedMs(start) << " ms " << (ok && checkOrder(g, order) ? "ok" : "fail") << endl;
+
+    start = chrono::steady_clock::now();
+    ok = topoDfs(g, order);
+    cout << "iterative dfs:  " << elapsedMs(start) << " ms " << (ok && checkOrder(g, order) ? "ok" : "fail") << endl;
+
+    LevelScheduler scheduler(threads);
+    vector<vector<uint32_t> > levels, cycles;
+    start = chrono::steady_clock::now();
+    ok = scheduler.schedule(g, levels, cycles);
+    double ms = elapsedMs(start);
+    order.clear();
+    for (auto& level : levels) order.insert(order.end(), level.begin(), level.end());
+    cout << "level kahn x" << threads << ": " << ms << " ms " << (ok && checkOrder(g, order) ? "ok" : "fail")
+         << " levels=" << levels.size() << endl;
+
+    atomic<uint64_t> executed{0};
+    start = chrono::steady_clock::now();
+    scheduler.runLevels(levels, [&executed](uint32_t) { executed.fetch_add(1, memory_order_relaxed); });
+    cout << "run levels:     " << elapsedMs(start) << " ms executed=" << executed << endl;
+}
+
+int main(int argc, char** argv)
+{
+    test1();
+
+    uint32_t n = argc > 1 ? uint32_t(strtoul(argv[1], nullptr, 10)) : 1000000;
+    size_t m = argc > 2 ? size_t(strtoull(argv[2], nullptr, 10)) : 10000000;
+    int threads = argc > 3 ? atoi(argv[3]) : int(max(1u, thread::hardware_concurrency()));
+    bench(n, m, threads);
+    return 0;
+}
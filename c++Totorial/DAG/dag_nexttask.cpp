@@ -6,79 +6,410 @@
 #include <vector>
 #include <queue>
 #include <algorithm>
+#include <stdexcept>
+#include <chrono>
+#include <random>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 using namespace std;
 
-class stringDfsScheduler
+// 任务名驻留：把任务名映射成从 0 开始的稠密编号
+// 只有在名字进出的边界处才查哈希表，调度器内部的状态全部是按编号索引的数组
+// 哈希表采用开放寻址 + 线性探测，槽位里只存编号，并缓存每个名字的哈希值以减少字符串比较
+class TaskInterner
 {
 public:
-    void addDependency(const string& from, const string& to)
+    static constexpr uint32_t kNotFound = UINT32_MAX;
+
+    uint32_t intern(const string& name)
     {
-        adj[from].push_back(to);
-        knownTasks[from] = true;
-        knownTasks[to] = true;
+        uint64_t h = hash<string>()(name);
+        size_t slot = probe(name, h);
+        if (_slots[slot] != kEmpty) return _slots[slot];
+
+        uint32_t id = uint32_t(_names.size());
+        _names.push_back(name);
+        _hashes.push_back(h);
+        _slots[slot] = id;
+        // 装载因子超过 1/2 时扩容
+        if (_names.size() * 2 > _slots.size()) rehash(_slots.size() * 2);
+        return id;
     }
 
-    vector<string> schedule()
+    uint32_t find(const string& name) const
     {
-        for (auto& task : knownTasks)
+        if (_names.empty()) return kNotFound;
+        uint64_t h = hash<string>()(name);
+        size_t slot = probe(name, h);
+        return _slots[slot] == kEmpty ? kNotFound : _slots[slot];
+    }
+
+    const string& name(uint32_t id) const { return _names[id]; }
+    size_t size() const { return _names.size(); }
+
+private:
+    static constexpr uint32_t kEmpty = UINT32_MAX;
+
+    // 返回名字所在的槽位，不存在时返回应插入的空槽
+    size_t probe(const string& name, uint64_t h) const
+    {
+        size_t mask = _slots.size() - 1;
+        size_t slot = h & mask;
+        while (_slots[slot] != kEmpty)
+        {
+            uint32_t id = _slots[slot];
+            if (_hashes[id] == h && _names[id] == name) break;
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    void rehash(size_t capacity)
+    {
+        _slots.assign(capacity, kEmpty);
+        size_t mask = capacity - 1;
+        for (uint32_t id = 0; id < _names.size(); ++id)
         {
-            if (visited[task.first] == 0)
+            size_t slot = _hashes[id] & mask;
+            while (_slots[slot] != kEmpty) slot = (slot + 1) & mask;
+            _slots[slot] = id;
+        }
+    }
+
+private:
+    vector<uint32_t> _slots = vector<uint32_t>(16, kEmpty);
+    vector<string> _names;
+    vector<uint64_t> _hashes;
+};
+
+// 在线拓扑序维护（Pearce-Kelly 算法）
+// 每插入一条边 x -> y，只在 ord[y] < ord[x] 时才需要调整，并且只重排 [ord[y], ord[x]] 区间内受影响的节点
+// 插入会成环的边时返回 false，图保持不变；当前拓扑序随时 O(1) 可得
+// 节点用 TaskInterner 分配的编号，新节点排在拓扑序末尾
+class OnlineTopoOrder
+{
+public:
+    bool addEdge(uint32_t x, uint32_t y)
+    {
+        if (x == y) return false;
+        reserve(max(x, y) + 1);
+        uint32_t lb = ord[y];
+        uint32_t ub = ord[x];
+        if (lb < ub)
+        {
+            // 先向前搜索：从 y 出发只走 ord <= ub 的节点，碰到 x 说明成环
+            vector<uint32_t> deltaF;
+            if (!searchForward(y, ub, x, deltaF)) return false;
+            // 再向后搜索：从 x 出发沿入边只走 ord > lb 的节点
+            vector<uint32_t> deltaB;
+            searchBackward(x, lb, deltaB);
+            reorder(deltaB, deltaF);
+        }
+        out[x].push_back(y);
+        in[y].push_back(x);
+        return true;
+    }
+
+    // 当前拓扑序（节点编号），O(1) 获取
+    const vector<uint32_t>& currentOrder() const { return nodeAt; }
+    size_t size() const { return nodeAt.size(); }
+
+private:
+    void reserve(uint32_t count)
+    {
+        for (uint32_t id = uint32_t(ord.size()); id < count; ++id)
+        {
+            ord.push_back(id);
+            nodeAt.push_back(id);
+        }
+        out.resize(ord.size());
+        in.resize(ord.size());
+        mark.resize(ord.size(), false);
+    }
+
+    bool searchForward(uint32_t start, uint32_t ub, uint32_t target, vector<uint32_t>& deltaF)
+    {
+        vector<uint32_t> stack{start};
+        mark[start] = true;
+        bool ok = true;
+        while (!stack.empty() && ok)
+        {
+            uint32_t n = stack.back();
+            stack.pop_back();
+            deltaF.push_back(n);
+            for (uint32_t w : out[n])
             {
-                dfs(task.first);
+                if (w == target)
+                {
+                    ok = false;
+                    break;
+                }
+                if (!mark[w] && ord[w] < ub)
+                {
+                    mark[w] = true;
+                    stack.push_back(w);
+                }
             }
         }
+        // 清理标记（成环时还要把栈里已标记但未出栈的节点一起清掉）
+        for (uint32_t n : deltaF) mark[n] = false;
+        for (uint32_t n : stack) mark[n] = false;
+        return ok;
+    }
 
-        // 检查是否所有任务都被处理
-        if (result.size() != knownTasks.size()) {
-            throw runtime_error("存在未注册的独立任务或循环依赖");
+    void searchBackward(uint32_t start, uint32_t lb, vector<uint32_t>& deltaB)
+    {
+        vector<uint32_t> stack{start};
+        mark[start] = true;
+        while (!stack.empty())
+        {
+            uint32_t n = stack.back();
+            stack.pop_back();
+            deltaB.push_back(n);
+            for (uint32_t w : in[n])
+            {
+                if (!mark[w] && lb < ord[w])
+                {
+                    mark[w] = true;
+                    stack.push_back(w);
+                }
+            }
         }
+        for (uint32_t n : deltaB) mark[n] = false;
+    }
 
-        // 反转结果得到拓扑顺序
-        reverse(result.begin(), result.end());
-        return result;
+    // 把 deltaB（x 的祖先）整体排在 deltaF（y 的后代）之前，复用它们原来占据的位置
+    void reorder(vector<uint32_t>& deltaB, vector<uint32_t>& deltaF)
+    {
+        auto byOrd = [this](uint32_t a, uint32_t b) { return ord[a] < ord[b]; };
+        sort(deltaB.begin(), deltaB.end(), byOrd);
+        sort(deltaF.begin(), deltaF.end(), byOrd);
+
+        vector<uint32_t> nodes;
+        vector<uint32_t> slots;
+        nodes.reserve(deltaB.size() + deltaF.size());
+        for (uint32_t n : deltaB) nodes.push_back(n);
+        for (uint32_t n : deltaF) nodes.push_back(n);
+        for (uint32_t n : nodes) slots.push_back(ord[n]);
+        sort(slots.begin(), slots.end());
+
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            ord[nodes[i]] = slots[i];
+            nodeAt[slots[i]] = nodes[i];
+        }
     }
+
 private:
-    void dfs(const string& task)
+    vector<uint32_t> ord;                // 编号 -> 拓扑序中的位置
+    vector<uint32_t> nodeAt;             // 位置 -> 编号，即当前拓扑序
+    vector<vector<uint32_t> > out;       // 出边
+    vector<vector<uint32_t> > in;        // 入边
+    vector<bool> mark;                   // 搜索时的访问标记
+};
+
+// 按名字插入边 from -> to，成功时 u、v 为两端的编号
+// 先确认不成环，再给新名字分配编号：被拒绝的边不会留下没有任何边的幽灵任务
+// 新任务还没有边，含新任务的边只有自环会成环，两端都已存在时才需要在线拓扑序判断
+bool internEdge(TaskInterner& tasks, OnlineTopoOrder& online, const string& from, const string& to,
+                uint32_t& u, uint32_t& v)
+{
+    if (from == to) return false;
+    u = tasks.find(from);
+    v = tasks.find(to);
+    if (u != TaskInterner::kNotFound && v != TaskInterner::kNotFound) return online.addEdge(u, v);
+    u = tasks.intern(from);
+    v = tasks.intern(to);
+    return online.addEdge(u, v);
+}
+
+class stringDfsScheduler
+{
+public:
+    // 成环的边会被立即拒绝（抛异常），不会加入图中
+    void addDependency(const string& from, const string& to)
     {
-        if (visited[task] == 1)
+        uint32_t u, v;
+        if (!internEdge(tasks, online, from, to, u, v))
         {
-            throw runtime_error("检测到循环依赖: " + task);
+            throw runtime_error("检测到循环依赖: " + from + " -> " + to);
         }
-        if (visited[task] == 2)
+        if (adj.size() < tasks.size()) adj.resize(tasks.size());
+        adj[u].push_back(v);
+    }
+
+    // 在线维护的拓扑序，O(1) 获取
+    const vector<uint32_t>& currentOrder() const { return online.currentOrder(); }
+    const string& taskName(uint32_t id) const { return tasks.name(id); }
+
+    vector<string> schedule()
+    {
+        const uint32_t n = uint32_t(tasks.size());
+        adj.resize(n);
+        visited.assign(n, 0);
+        result.clear();
+        result.reserve(n);
+        for (uint32_t task = 0; task < n; ++task)
         {
-            return;
+            if (visited[task] == 0)
+            {
+                dfs(task);
+            }
+        }
+
+        // 检查是否所有任务都被处理
+        if (result.size() != n) {
+            throw runtime_error("存在未注册的独立任务或循环依赖");
         }
 
-        for (auto& next : adj[task])
+        // 反转结果得到拓扑顺序，只在出口处把编号换回名字
+        vector<string> order;
+        order.reserve(n);
+        for (auto it = result.rbegin(); it != result.rend(); ++it)
         {
-            dfs(next);
+            order.push_back(tasks.name(*it));
         }
+        return order;
+    }
+private:
+    // 迭代版 DFS：显式栈保存 (任务, 下一个后继的下标)，深图不会爆栈
+    void dfs(uint32_t root)
+    {
+        vector<pair<uint32_t, uint32_t> > stack;
+        visited[root] = 1;
+        stack.emplace_back(root, 0);
+        while (!stack.empty())
+        {
+            uint32_t task = stack.back().first;
+            uint32_t& next_index = stack.back().second;
+            const vector<uint32_t>& nexts = adj[task];
+            if (next_index < nexts.size())
+            {
+                uint32_t next = nexts[next_index++];
+                if (visited[next] == 1)
+                {
+                    throw runtime_error("检测到循环依赖: " + tasks.name(next));
+                }
+                if (visited[next] == 0)
+                {
+                    visited[next] = 1;
+                    stack.emplace_back(next, 0);
+                }
+                continue;
+            }
 
-        visited[task] = 2;
-        result.push_back(task);
+            visited[task] = 2;
+            result.push_back(task);
+            stack.pop_back();
+        }
     }
 
 private:
+    TaskInterner tasks;
+    // 以下状态都按任务编号索引
     // 任务状态：0=未访问, 1=访问中, 2=已完成
-    unordered_map<string, int> visited;
+    vector<uint8_t> visited;
     // 邻接表：记录每个任务的后继任务
-    unordered_map<string, vector<string> > adj;
-    unordered_map<string, bool> knownTasks;
-    vector<string> result;
+    vector<vector<uint32_t> > adj;
+    vector<uint32_t> result;
+    OnlineTopoOrder online;
 };
 
 class StringDAGScheduler
 {
 private:
+    TaskInterner tasks;
+    // 以下状态都按任务编号索引
     // 存储每个任务的入度
-    unordered_map<string, int> inDegree;
+    vector<int> inDegree;
     // 邻接表：记录每个任务的后继任务
+    vector<vector<uint32_t> > adj;
+    // 在线维护的拓扑序
+    OnlineTopoOrder online;
+    bool trackOrder;
+    
+public:
+    // trackOrder 为 false 时不维护在线拓扑序：成环的边要到 schedule() 才发现，currentOrder() 为空
+    explicit StringDAGScheduler(bool trackOrder = true) : trackOrder(trackOrder) {}
+
+    // 添加边：from -> to，维护在线拓扑序时成环的边会被立即拒绝（抛异常）
+    void addDependency(const string& from, const string& to) {
+        uint32_t u, v;
+        if (!trackOrder) {
+            u = tasks.intern(from);
+            v = tasks.intern(to);
+        } else if (!internEdge(tasks, online, from, to, u, v)) {
+            throw runtime_error("检测到循环依赖: " + from + " -> " + to);
+        }
+        if (adj.size() < tasks.size()) {
+            adj.resize(tasks.size());
+            inDegree.resize(tasks.size(), 0);
+        }
+        adj[u].push_back(v);
+        inDegree[v]++;
+    }
+
+    // 在线维护的拓扑序，O(1) 获取
+    const vector<uint32_t>& currentOrder() const { return online.currentOrder(); }
+    const string& taskName(uint32_t id) const { return tasks.name(id); }
+
+    // 拓扑排序调度
+    vector<string> schedule() {
+        const uint32_t n = uint32_t(tasks.size());
+        adj.resize(n);
+        inDegree.resize(n, 0);
+        // 拷贝一份入度，schedule 可以重复调用
+        vector<int> degree(inDegree);
+        // 结果数组本身就是队列：head 之前的已处理，之后的待处理
+        vector<uint32_t> queue;
+        queue.reserve(n);
+
+        // 初始化队列（入度为0的任务）
+        for (uint32_t task = 0; task < n; ++task) {
+            if (degree[task] == 0) {
+                queue.push_back(task);
+            }
+        }
+
+        // 处理队列
+        for (size_t head = 0; head < queue.size(); ++head) {
+            uint32_t u = queue[head];
+            // 更新后继任务的入度
+            for (uint32_t v : adj[u]) {
+                if (--degree[v] == 0) {
+                    queue.push_back(v);
+                }
+            }
+        }
+
+        // 环检测
+        if (queue.size() != n) {
+            throw runtime_error("存在循环依赖或未注册的任务！");
+        }
+
+        vector<string> result;
+        result.reserve(n);
+        for (uint32_t u : queue) {
+            result.push_back(tasks.name(u));
+        }
+        return result;
+    }
+};
+
+// 改造前的实现：每个状态一张 unordered_map<string, ...>，保留作性能对照
+class LegacyStringDAGScheduler
+{
+private:
+    unordered_map<string, int> inDegree;
     unordered_map<string, vector<string> > adj;
-    // 所有已知的任务集合（避免重复计数）
     unordered_map<string, bool> knownTasks;
-    
+
 public:
-    // 添加边：from -> to
     void addDependency(const string& from, const string& to) {
         adj[from].push_back(to);
         inDegree[to]++;
@@ -86,42 +417,73 @@ public:
         knownTasks[to] = true;
     }
 
-    // 拓扑排序调度
     vector<string> schedule() {
         queue<string> q;
         vector<string> result;
-
-        // 初始化队列（入度为0的任务）
         for (const auto& pair : knownTasks) {
             const string& task = pair.first;
             if (inDegree[task] == 0) {
                 q.push(task);
             }
         }
-
-        // 处理队列
         while (!q.empty()) {
             string u = q.front();
             q.pop();
             result.push_back(u);
-
-            // 更新后继任务的入度
             for (const string& v : adj[u]) {
                 if (--inDegree[v] == 0) {
                     q.push(v);
                 }
             }
         }
-
-        // 环检测
         if (result.size() != knownTasks.size()) {
             throw runtime_error("存在循环依赖或未注册的任务！");
         }
-
         return result;
     }
 };
 
+// 用 perf_event_open 统计缓存未命中次数，不支持时（容器、权限不足）返回 -1
+class CacheMissCounter
+{
+public:
+    CacheMissCounter()
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        _fd = int(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+    ~CacheMissCounter()
+    {
+        if (_fd >= 0) close(_fd);
+    }
+
+    void start()
+    {
+        if (_fd < 0) return;
+        ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    long long stop()
+    {
+        if (_fd < 0) return -1;
+        ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long count = 0;
+        if (read(_fd, &count, sizeof(count)) != sizeof(count)) return -1;
+        return count;
+    }
+
+private:
+    int _fd = -1;
+};
+
 void test1()
 {
     stringDfsScheduler scheduler1;
@@ -142,12 +504,12 @@ void test1()
     }
 
     // 示例2：循环依赖
+    // 成环的边在 addDependency 时就会被拒绝
     stringDfsScheduler scheduler2;
-    scheduler2.addDependency("A", "B");
-    scheduler2.addDependency("B", "C");
-    scheduler2.addDependency("C", "A"); // 形成循环
-
     try {
+        scheduler2.addDependency("A", "B");
+        scheduler2.addDependency("B", "C");
+        scheduler2.addDependency("C", "A"); // 形成循环
         scheduler2.schedule();
     } catch (const exception& e) {
         cout << "\n测试循环依赖：" << e.what() << endl;
@@ -176,8 +538,137 @@ void test2()
         cerr << "错误：" << e.what() << endl;
     }
 }
+// 在线环检测：插入边时立即拒绝成环的边，拓扑序随时可用
+void test3()
+{
+    StringDAGScheduler scheduler;
+    scheduler.addDependency("编译", "链接");
+    scheduler.addDependency("预处理", "编译");
+    scheduler.addDependency("清理数据", "预处理");
+    scheduler.addDependency("下载依赖", "编译");
+    try {
+        scheduler.addDependency("链接", "清理数据");
+    } catch (const exception& e) {
+        cout << "拒绝插入：" << e.what() << endl;
+    }
+    // 被拒绝的边里的新名字不会留在图里
+    try {
+        scheduler.addDependency("打包", "打包");
+    } catch (const exception& e) {
+        cout << "拒绝插入：" << e.what() << endl;
+    }
+    cout << "当前顺序：";
+    for (uint32_t id : scheduler.currentOrder()) {
+        cout << scheduler.taskName(id) << " → ";
+    }
+    cout << "结束" << endl;
+
+    // 交互式编辑：随机插入大量边，对比每次插入后全量重排的耗时
+    const int num_tasks = 2000;
+    const int num_edges = 20000;
+    mt19937 rng(7);
+    uniform_int_distribution<int> dist(0, num_tasks - 1);
+    vector<pair<string, string> > edges;
+    for (int i = 0; i < num_edges; ++i) {
+        edges.emplace_back("t" + to_string(dist(rng)), "t" + to_string(dist(rng)));
+    }
+
+    TaskInterner names;
+    OnlineTopoOrder online;
+    vector<bool> accepted;
+    int rejected = 0;
+    auto start = chrono::steady_clock::now();
+    for (auto& edge : edges) {
+        bool ok = online.addEdge(names.intern(edge.first), names.intern(edge.second));
+        accepted.push_back(ok);
+        if (!ok) rejected++;
+    }
+    double online_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    // 校验：所有被接受的边都满足 from 在 to 之前
+    vector<size_t> pos(names.size());
+    for (size_t i = 0; i < online.currentOrder().size(); ++i) pos[online.currentOrder()[i]] = i;
+    bool valid = true;
+    for (size_t i = 0; i < edges.size(); ++i) {
+        if (accepted[i] && pos[names.find(edges[i].first)] >= pos[names.find(edges[i].second)]) valid = false;
+    }
+    cout << "online insert " << num_edges << " edges: " << online_ms << " ms, rejected " << rejected
+         << (valid ? ", order ok" : ", order broken") << endl;
+
+    // 全量方式：每插入一条边都重新跑一次 Kahn，只测前 1000 条
+    const int full_edges = 1000;
+    start = chrono::steady_clock::now();
+    {
+        vector<pair<string, string> > kept;
+        for (int i = 0; i < full_edges; ++i) {
+            if (!accepted[i]) continue;
+            kept.push_back(edges[i]);
+            LegacyStringDAGScheduler full;
+            for (auto& edge : kept) full.addDependency(edge.first, edge.second);
+            full.schedule();
+        }
+    }
+    double full_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "full re-sort " << full_edges << " edges: " << full_ms << " ms" << endl;
+}
+
+// 驻留前后对比：10 万个任务的随机 DAG，统计建图、调度耗时和缓存未命中
+// 改造前的实现没有在线拓扑序，改造后的也关掉在线拓扑序，对比只反映存储结构的差异
+// （编号按名字第一次出现的顺序分配，与拓扑序无关，即使边按任务下标排好序，在线排序也会发生重排）
+void test4()
+{
+    const int num_tasks = 100000;
+    const int num_edges = 400000;
+    mt19937 rng(11);
+    uniform_int_distribution<int> dist(0, num_tasks - 1);
+    vector<string> names(num_tasks);
+    for (int i = 0; i < num_tasks; ++i) names[i] = "task_" + to_string(i);
+    vector<pair<int, int> > edges;
+    while (edges.size() < size_t(num_edges)) {
+        int a = dist(rng);
+        int b = dist(rng);
+        if (a == b) continue;
+        edges.emplace_back(min(a, b), max(a, b));
+    }
+    sort(edges.begin(), edges.end());
+
+    CacheMissCounter counter;
+    auto run = [&](const char* label, auto& scheduler) {
+        counter.start();
+        auto start = chrono::steady_clock::now();
+        for (auto& e : edges) scheduler.addDependency(names[e.first], names[e.second]);
+        double build_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        long long build_misses = counter.stop();
+
+        counter.start();
+        start = chrono::steady_clock::now();
+        vector<string> order = scheduler.schedule();
+        double schedule_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        long long schedule_misses = counter.stop();
+
+        cout << label << " build " << build_ms << " ms, schedule " << schedule_ms << " ms";
+        if (schedule_misses >= 0) {
+            cout << ", cache misses build/schedule " << build_misses << "/" << schedule_misses;
+        } else {
+            cout << ", cache misses n/a";
+        }
+        cout << " (" << order.size() << " tasks)" << endl;
+    };
+
+    {
+        LegacyStringDAGScheduler before;
+        run("before(unordered_map):", before);
+    }
+    {
+        StringDAGScheduler after(false);
+        run("after(interned ids):  ", after);
+    }
+}
+
 int main()
 {
     test1();
+    test3();
+    test4();
     //test2();
 }
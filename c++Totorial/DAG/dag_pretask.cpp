@@ -4,6 +4,9 @@
 #include <unordered_map>
 #include <vector>
 #include <queue>
+#include <cstdint>
+#include <filesystem>
+#include "../resultCache/ResultCache.h"
 
 using namespace std;
 class module
@@ -15,7 +18,7 @@ public:
     {
         return _name;
     }
-    const std::vector<std::string> GetDeps() const
+    const std::vector<std::string>& GetDeps() const
     {
         return _deps;
     }
@@ -25,6 +28,62 @@ private:
     std::vector<std::string> _deps;
 };
 
+// 带类型输出的记忆化模块：键 = xxHash(模块名 + 版本号 + 序列化后的输入)
+// 输入不变时直接从缓存取出输出，跳过 compute()
+// 修改了计算逻辑时要递增 version，让旧结果失效
+template<typename Out>
+class memo_module : public module
+{
+public:
+    memo_module(std::string name, std::vector<std::string> deps, ResultCache* cache, uint32_t version = 1)
+        : module(name, deps), _cache(cache), _version(version) {}
+
+    void execute() override
+    {
+        string key_bytes;
+        Serialize(key_bytes, GetName());
+        Serialize(key_bytes, _version);
+        hash_inputs(key_bytes);
+        uint64_t key = xxh::hash64(key_bytes.data(), key_bytes.size());
+
+        // 缓存里的字节解不出 Out（截断、损坏）时按未命中处理，重新计算并覆盖
+        auto decode = [this](const string& value) {
+            ByteReader in(value);
+            Out output{};
+            if (!Deserialize(in, output) || !in.Done()) return false;
+            _output = move(output);
+            return true;
+        };
+        if (_cache && _cache->Get(key, decode))
+        {
+            _from_cache = true;
+            return;
+        }
+        _output = compute();
+        _from_cache = false;
+        if (_cache)
+        {
+            string value;
+            Serialize(value, _output);
+            _cache->Put(key, value);
+        }
+    }
+
+    const Out& output() const { return _output; }
+    bool from_cache() const { return _from_cache; }
+
+protected:
+    // 把所有会影响输出的输入写进 out（包括上游模块的输出）
+    virtual void hash_inputs(string& out) const = 0;
+    virtual Out compute() = 0;
+
+private:
+    ResultCache* _cache;
+    uint32_t _version;
+    Out _output{};
+    bool _from_cache = false;
+};
+
 class moduleA : public module
 {
 public:
@@ -66,17 +125,30 @@ public:
         }
     }
 private:
-    void execute(module* mod, std::unordered_map<std::string, bool>& visited)
+    // 迭代版后序遍历：依赖全部执行完后再执行自己，深图不会爆栈
+    void execute(module* root, std::unordered_map<std::string, bool>& visited)
     {
-        visited[mod->GetName()] = true;
-        for (auto& dep : mod->GetDeps())
+        std::vector<std::pair<module*, size_t> > stack;
+        visited[root->GetName()] = true;
+        stack.emplace_back(root, 0);
+        while (!stack.empty())
         {
-            if (!visited[dep])
+            module* mod = stack.back().first;
+            size_t& dep_index = stack.back().second;
+            const std::vector<std::string>& deps = mod->GetDeps();
+            if (dep_index < deps.size())
             {
-                execute(_modules[dep], visited);
+                const std::string& dep = deps[dep_index++];
+                if (!visited[dep])
+                {
+                    visited[dep] = true;
+                    stack.emplace_back(_modules[dep], 0);
+                }
+                continue;
             }
+            mod->execute();
+            stack.pop_back();
         }
-        mod->execute();
     }
 
 private:
@@ -172,8 +244,82 @@ void test2()
     e.execute_all();
 }
 
+// 记忆化演示：加载 -> 统计，两个模块都以输入内容为键缓存结果
+class load_module : public memo_module<vector<int> >
+{
+public:
+    load_module(std::string name, ResultCache* cache, const string* source)
+        : memo_module(name, {}, cache), _source(source) {}
+protected:
+    void hash_inputs(string& out) const override { Serialize(out, *_source); }
+    vector<int> compute() override
+    {
+        std::cout << "  compute " << GetName() << std::endl;
+        vector<int> values;
+        for (char ch : *_source) values.push_back(ch);
+        return values;
+    }
+private:
+    const string* _source;
+};
+
+class sum_module : public memo_module<int64_t>
+{
+public:
+    sum_module(std::string name, ResultCache* cache, const load_module* load)
+        : memo_module(name, {load->GetName()}, cache), _load(load) {}
+protected:
+    void hash_inputs(string& out) const override { Serialize(out, _load->output()); }
+    int64_t compute() override
+    {
+        std::cout << "  compute " << GetName() << std::endl;
+        int64_t sum = 0;
+        for (int v : _load->output()) sum += v;
+        return sum;
+    }
+private:
+    const load_module* _load;
+};
+
+void test3()
+{
+    string dir = (filesystem::temp_directory_path() / "dag_memo_cache").string();
+    filesystem::remove_all(dir);
+    ResultCache cache(1 << 20, dir);
+
+    string source = "hello asset";
+    load_module load("load", &cache, &source);
+    sum_module sum("sum", &cache, &load);
+    executor e;
+    e.add_module(&load);
+    e.add_module(&sum);
+
+    std::cout << "run 1:" << std::endl;
+    e.execute_all();
+    std::cout << "run 2 (same input):" << std::endl;
+    e.execute_all();
+    std::cout << "run 3 (restart, disk cache):" << std::endl;
+    cache.ClearMemory();
+    e.execute_all();
+    std::cout << "run 4 (input changed):" << std::endl;
+    source = "hello world";
+    e.execute_all();
+    std::cout << "run 5 (restart, truncated disk entries):" << std::endl;
+    for (auto& entry : filesystem::directory_iterator(dir))
+    {
+        filesystem::resize_file(entry.path(), filesystem::file_size(entry.path()) / 2);
+    }
+    cache.ClearMemory();
+    e.execute_all();
+
+    std::cout << "sum=" << sum.output() << " hits=" << cache.Hits()
+              << " disk_hits=" << cache.DiskHits() << " misses=" << cache.Misses() << std::endl;
+    filesystem::remove_all(dir);
+}
+
 int main()
 {
     test2();
+    test3();
     return 0;
 }
@@ -0,0 +1,256 @@
+#pragma once
+
+// 基准测试的公共部分：计时、延迟分位数、结果输出
+//   - 每个子系统一个可执行文件（bench_lock、bench_pool ...），都用 BenchSuite 收集结果
+//   - 每项结果有吞吐（ops/s）和单次操作延迟的分位数（p50/p90/p99/p999），延迟单位是纳秒
+//   - 结果打印成表格，加 --json <path> 时同时写成 JSON，用 bench/compare.py 比较两次运行
+//   - --quick 缩小规模，给 ctest 做冒烟测试；--filter <str> 只跑名字里含 str 的项
+//
+// 各个基准在线程里把延迟记到自己的 vector 里，结束后合并交给 BenchSuite::Add，计时路径上没有共享写
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bench
+{
+inline int64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 忙等一段时间，模拟临界区或任务里的计算
+inline void SpinFor(int64_t ns)
+{
+    if (ns <= 0) return;
+    int64_t end = NowNs() + ns;
+    while (NowNs() < end) {}
+}
+
+// 把各线程的样本合并成一个
+inline std::vector<int64_t> Merge(std::vector<std::vector<int64_t>>& per_thread)
+{
+    size_t total = 0;
+    for (auto& samples : per_thread) total += samples.size();
+    std::vector<int64_t> merged;
+    merged.reserve(total);
+    for (auto& samples : per_thread)
+    {
+        merged.insert(merged.end(), samples.begin(), samples.end());
+        std::vector<int64_t>().swap(samples);
+    }
+    return merged;
+}
+
+struct LatencySummary
+{
+    uint64_t count = 0;
+    double mean = 0;
+    int64_t min = 0;
+    int64_t p50 = 0;
+    int64_t p90 = 0;
+    int64_t p99 = 0;
+    int64_t p999 = 0;
+    int64_t max = 0;
+};
+
+// 最近秩法取分位数，样本会被排序
+inline LatencySummary Summarize(std::vector<int64_t>& samples)
+{
+    LatencySummary summary;
+    if (samples.empty()) return summary;
+    std::sort(samples.begin(), samples.end());
+    auto rank = [&samples](double q) {
+        size_t index = size_t(std::ceil(q * samples.size()));
+        return samples[std::min(samples.size() - 1, index ? index - 1 : 0)];
+    };
+    double sum = 0;
+    for (int64_t s : samples) sum += double(s);
+    summary.count = samples.size();
+    summary.mean = sum / samples.size();
+    summary.min = samples.front();
+    summary.p50 = rank(0.50);
+    summary.p90 = rank(0.90);
+    summary.p99 = rank(0.99);
+    summary.p999 = rank(0.999);
+    summary.max = samples.back();
+    return summary;
+}
+
+struct BenchResult
+{
+    std::string name;
+    uint64_t ops = 0;
+    double seconds = 0;
+    double throughput = 0;
+    std::string unit;
+    LatencySummary latency;
+};
+
+class BenchSuite
+{
+public:
+    BenchSuite(std::string suite, int argc, char** argv) : _suite(std::move(suite))
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--quick") _quick = true;
+            else if (arg == "--json" && i + 1 < argc) _json_path = argv[++i];
+            else if (arg == "--filter" && i + 1 < argc) _filter = argv[++i];
+            else if (arg == "--dir" && i + 1 < argc) _dir = argv[++i];
+            else
+            {
+                throw std::invalid_argument("Unknown argument " + arg +
+                    " (usage: [--quick] [--json path] [--filter substr] [--dir path])");
+            }
+        }
+    }
+
+    // 缩小规模的冒烟运行
+    bool Quick() const { return _quick; }
+    // 需要磁盘目录的基准用，默认空串表示由基准自己选
+    const std::string& Dir() const { return _dir; }
+    // 名字里含 --filter 给出的子串才跑
+    bool Enabled(const std::string& name) const
+    {
+        return _filter.empty() || name.find(_filter) != std::string::npos;
+    }
+    // 正式运行取 full，--quick 时取 quick
+    template<typename T>
+    T Scale(T full, T quick) const { return _quick ? quick : full; }
+
+    // ops 次操作用了 seconds 秒，samples 是单次操作的延迟（纳秒），可以为空
+    void Add(const std::string& name, uint64_t ops, double seconds, std::vector<int64_t> samples,
+             const std::string& unit = "ops/s")
+    {
+        BenchResult result;
+        result.name = name;
+        result.ops = ops;
+        result.seconds = seconds;
+        result.throughput = seconds > 0 ? ops / seconds : 0;
+        result.unit = unit;
+        result.latency = Summarize(samples);
+        PrintRow(result);
+        _results.push_back(std::move(result));
+    }
+
+    // 写 JSON，返回进程退出码
+    int Finish()
+    {
+        if (_json_path.empty()) return 0;
+        std::ofstream out(_json_path);
+        WriteJson(out);
+        if (!out)
+        {
+            std::cerr << "Cannot write " << _json_path << std::endl;
+            return 1;
+        }
+        std::cout << "results written to " << _json_path << std::endl;
+        return 0;
+    }
+
+    const std::vector<BenchResult>& Results() const { return _results; }
+
+private:
+    void PrintRow(const BenchResult& r)
+    {
+        if (!_header_printed)
+        {
+            std::cout << std::left << std::setw(52) << _suite << std::right << std::setw(14) << "throughput"
+                      << std::setw(10) << "p50 us" << std::setw(10) << "p99 us" << std::setw(10) << "p999 us"
+                      << std::setw(10) << "max us" << std::endl;
+            _header_printed = true;
+        }
+        auto us = [](int64_t ns) { return ns / 1000.0; };
+        std::cout << std::left << std::setw(52) << ("  " + r.name) << std::right << std::fixed << std::setprecision(0)
+                  << std::setw(14) << r.throughput << std::setprecision(2);
+        if (r.latency.count)
+        {
+            std::cout << std::setw(10) << us(r.latency.p50) << std::setw(10) << us(r.latency.p99)
+                      << std::setw(10) << us(r.latency.p999) << std::setw(10) << us(r.latency.max);
+        }
+        std::cout << "  " << r.unit << std::endl;
+        std::cout.unsetf(std::ios::fixed);
+    }
+
+    static std::string Escape(const std::string& s)
+    {
+        std::string out;
+        for (char c : s)
+        {
+            if (c == '"' || c == '\\') out += '\\';
+            if (static_cast<unsigned char>(c) < 0x20) out += ' ';
+            else out += c;
+        }
+        return out;
+    }
+
+    // 编译开关会改变被测组件的实现，写进结果里，比较时能看出两次运行是不是同一种构建
+    static std::string Flags()
+    {
+        std::string flags;
+#ifdef USE_PARKING_LOT
+        flags += " USE_PARKING_LOT";
+#endif
+#ifdef USE_SLAB_ALLOC
+        flags += " USE_SLAB_ALLOC";
+#endif
+#ifdef LOCK_PROFILING
+        flags += " LOCK_PROFILING";
+#endif
+#ifdef NDEBUG
+        flags += " NDEBUG";
+#endif
+        return flags.empty() ? flags : flags.substr(1);
+    }
+
+    void WriteJson(std::ostream& out) const
+    {
+        char timestamp[32];
+        std::time_t now = std::time(nullptr);
+        std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+        out << "{\n";
+        out << "  \"suite\": \"" << Escape(_suite) << "\",\n";
+        out << "  \"timestamp\": \"" << timestamp << "\",\n";
+        out << "  \"quick\": " << (_quick ? "true" : "false") << ",\n";
+        out << "  \"host\": {\"cores\": " << std::thread::hardware_concurrency()
+            << ", \"compiler\": \"" << Escape(__VERSION__) << "\", \"flags\": \"" << Flags() << "\"},\n";
+        out << "  \"results\": [";
+        for (size_t i = 0; i < _results.size(); ++i)
+        {
+            const BenchResult& r = _results[i];
+            const LatencySummary& l = r.latency;
+            out << (i ? ",\n" : "\n") << std::setprecision(6)
+                << "    {\"name\": \"" << Escape(r.name) << "\", \"ops\": " << r.ops
+                << ", \"seconds\": " << r.seconds << ", \"throughput\": " << std::fixed << std::setprecision(1)
+                << r.throughput << ", \"unit\": \"" << Escape(r.unit) << "\",\n"
+                << "     \"latency_ns\": {\"count\": " << l.count << ", \"mean\": " << l.mean
+                << ", \"min\": " << l.min << ", \"p50\": " << l.p50 << ", \"p90\": " << l.p90
+                << ", \"p99\": " << l.p99 << ", \"p999\": " << l.p999 << ", \"max\": " << l.max << "}}";
+            out.unsetf(std::ios::fixed);
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    std::string _suite;
+    bool _quick = false;
+    std::string _json_path;
+    std::string _filter;
+    std::string _dir;
+    bool _header_printed = false;
+    std::vector<BenchResult> _results;
+};
+}
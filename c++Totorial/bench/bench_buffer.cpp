@@ -0,0 +1,54 @@
+#include <memory>
+#include <thread>
+#include <vector>
+#include "Bench.h"
+#include "../buffer/DoubleGraphBuffer.h"
+#include "../buffer/SharedGraphBuffer.h"
+
+// 缓冲区在渲染线程和编码线程之间的交接速率（buffer/DoubleGraphBuffer.h、buffer/SharedGraphBuffer.h）
+// 渲染线程反复 GetDrawBuffer、记下交出时间、释放（进入缓存队列）；编码线程 GetCacheBuffer、释放（回到绘制队列）
+//   double    DoubleGraphBufferMgr，进程内互斥锁 + 条件变量
+//   shared    SharedGraphBufferMgr，共享内存里的无锁环形队列 + futex，这里两端在同一个进程里
+// 不写像素，只测交接本身；延迟是渲染端交出到编码端拿到的时间，吞吐是每秒交接的帧数
+//
+// 运行：bench_buffer [--quick] [--json path] [--filter substr]
+
+template<typename Mgr>
+void BenchHandoff(bench::BenchSuite& suite, const std::string& name, std::shared_ptr<Mgr> mgr, int frames)
+{
+    if (!suite.Enabled(name)) return;
+
+    // 两个队列都是先进先出，第 i 个交出的缓冲区就是编码端第 i 个拿到的
+    std::vector<int64_t> handed(frames);
+    std::vector<int64_t> samples(frames);
+    int64_t start = bench::NowNs();
+    std::thread consumer([&]() {
+        for (int i = 0; i < frames; ++i)
+        {
+            auto buffer = mgr->GetCacheBuffer();
+            samples[i] = bench::NowNs() - handed[i];
+        }
+    });
+    for (int i = 0; i < frames; ++i)
+    {
+        auto buffer = mgr->GetDrawBuffer();
+        handed[i] = bench::NowNs();
+    }
+    consumer.join();
+    suite.Add(name, frames, (bench::NowNs() - start) / 1e9, std::move(samples), "frames/s");
+}
+
+int main(int argc, char** argv)
+{
+    bench::BenchSuite suite("buffer", argc, argv);
+    int frames = suite.Scale(200000, 1000);
+    for (int buffers : {2, 3, 4})
+    {
+        std::string suffix = "/buffers=" + std::to_string(buffers);
+        BenchHandoff(suite, "double" + suffix,
+                     std::make_shared<DoubleGraphBufferMgr>(256, 256, GpuBufferFormat::kBGRA32, buffers), frames);
+        BenchHandoff(suite, "shared" + suffix,
+                     SharedGraphBufferMgr::Create(256, 256, GpuBufferFormat::kBGRA32, buffers), frames);
+    }
+    return suite.Finish();
+}
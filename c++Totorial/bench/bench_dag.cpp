@@ -0,0 +1,126 @@
+#include <memory>
+#include <random>
+#include <vector>
+#include "Bench.h"
+#define DAG_THREAD_POOL_NO_MAIN
+#include "../threadPool/DAGThreadPool.cpp"
+
+// DAG 调度（threadPool/DAGThreadPool.cpp 的 Executor）在合成图上的一轮调度+执行
+//   chain      n 个模块串成一条链，完全没有并行度，测的是依赖完成到下游派发的传递延迟
+//   fanout     1 个根、n-2 个并列的中间模块、1 个汇合点
+//   layered    layers 层、每层 width 个模块，每个模块随机依赖上一层的 1~3 个模块
+// 模块内忙等 work_ns，work_ns=0 时整轮时间全是调度开销
+// 延迟是一轮 ExecuteAll + Wait 的总时间，吞吐是每秒执行完的模块数；线程池 4 个工作线程
+//
+// 运行：bench_dag [--quick] [--json path] [--filter substr]
+
+class SyntheticModule : public Module
+{
+public:
+    SyntheticModule(string name, vector<string> deps, int64_t work_ns)
+        : Module(move(name), move(deps)), _work_ns(work_ns) {}
+
+    void Execute() override
+    {
+        bench::SpinFor(_work_ns);
+        SetSucc();
+    }
+
+private:
+    int64_t _work_ns;
+};
+
+using Graph = vector<unique_ptr<SyntheticModule>>;
+
+string NodeName(int i) { return "m" + to_string(i); }
+
+Graph MakeChain(int n, int64_t work_ns)
+{
+    Graph graph;
+    for (int i = 0; i < n; ++i)
+    {
+        vector<string> deps;
+        if (i > 0) deps.push_back(NodeName(i - 1));
+        graph.push_back(make_unique<SyntheticModule>(NodeName(i), deps, work_ns));
+    }
+    return graph;
+}
+
+Graph MakeFanout(int n, int64_t work_ns)
+{
+    Graph graph;
+    graph.push_back(make_unique<SyntheticModule>(NodeName(0), vector<string>{}, work_ns));
+    vector<string> middle;
+    for (int i = 1; i < n - 1; ++i)
+    {
+        graph.push_back(make_unique<SyntheticModule>(NodeName(i), vector<string>{NodeName(0)}, work_ns));
+        middle.push_back(NodeName(i));
+    }
+    graph.push_back(make_unique<SyntheticModule>(NodeName(n - 1), middle, work_ns));
+    return graph;
+}
+
+Graph MakeLayered(int layers, int width, int64_t work_ns)
+{
+    mt19937 rng(layers * 1000 + width);
+    uniform_int_distribution<int> fan_in(1, 3);
+    uniform_int_distribution<int> pick(0, width - 1);
+    Graph graph;
+    for (int l = 0; l < layers; ++l)
+    {
+        for (int w = 0; w < width; ++w)
+        {
+            vector<string> deps;
+            if (l > 0)
+            {
+                for (int k = fan_in(rng); k > 0; --k)
+                {
+                    string dep = NodeName((l - 1) * width + pick(rng));
+                    if (find(deps.begin(), deps.end(), dep) == deps.end()) deps.push_back(dep);
+                }
+            }
+            graph.push_back(make_unique<SyntheticModule>(NodeName(l * width + w), deps, work_ns));
+        }
+    }
+    return graph;
+}
+
+void BenchGraph(bench::BenchSuite& suite, ThreadPool& pool, const string& shape, Graph graph, int64_t work_ns, int runs)
+{
+    string name = shape + "/modules=" + to_string(graph.size()) + "/work_ns=" + to_string(work_ns);
+    if (!suite.Enabled(name)) return;
+
+    Executor executor;
+    for (auto& mod : graph) executor.AddModule(mod.get());
+    vector<int64_t> samples;
+    int64_t total_ns = 0;
+    for (int r = 0; r < runs; ++r)
+    {
+        for (auto& mod : graph) mod->ClearState();
+        int64_t start = bench::NowNs();
+        executor.ExecuteAll(pool);
+        executor.Wait();
+        int64_t elapsed = bench::NowNs() - start;
+        samples.push_back(elapsed);
+        total_ns += elapsed;
+        for (auto& mod : graph)
+        {
+            if (!mod->CheckSucc()) throw runtime_error(name + ": module " + mod->Name() + " did not succeed");
+        }
+    }
+    suite.Add(name, uint64_t(graph.size()) * runs, total_ns / 1e9, move(samples), "modules/s");
+}
+
+int main(int argc, char** argv)
+{
+    bench::BenchSuite suite("dag", argc, argv);
+    ThreadPool pool(4);
+    for (int64_t work_ns : {int64_t(0), int64_t(5000)})
+    {
+        int runs = suite.Scale(work_ns ? 100 : 300, 3);
+        BenchGraph(suite, pool, "chain", MakeChain(64, work_ns), work_ns, runs);
+        BenchGraph(suite, pool, "fanout", MakeFanout(256, work_ns), work_ns, runs);
+        BenchGraph(suite, pool, "layered", MakeLayered(8, 32, work_ns), work_ns, runs);
+    }
+    return suite.Finish();
+}
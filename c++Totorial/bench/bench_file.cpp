@@ -0,0 +1,117 @@
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "Bench.h"
+#define DAG_THREAD_POOL_NO_MAIN
+#include "../threadPool/DAGThreadPool.cpp"
+#include "../callbackHell/Future.h"
+#include "../callbackHell/GroupCommit.h"
+#include "../callbackHell/ReadCache.h"
+
+// 异步文件读写的吞吐（callbackHell/ 下的 Future 版 async_read_file / async_write_file）
+// threads 个调用方各自循环：发起一次异步读写，Get 等它完成，再发起下一次；延迟就是一次调用的耗时
+//   read/pool             线程池上整读一个 4KB 文件，不缓存
+//   read/cache            ReadCache，命中时只有一次 stat
+//   write/pool            线程池上覆盖写一个 4KB 文件，不刷盘
+//   write/group_commit    GroupCommitWriter 的 Replace，返回时已经 fdatasync，并发写入合并成批
+// 线程池 4 个工作线程；文件放在 --dir 指定的目录下（默认系统临时目录），结束后删除
+//
+// 运行：bench_file [--quick] [--json path] [--filter substr] [--dir path]
+
+namespace fs = std::filesystem;
+
+const int kFiles = 64;
+const size_t kFileBytes = 4096;
+
+// threads 个线程各自调用 op(thread, i) ops_per_thread 次
+template<typename Op>
+void BenchCalls(bench::BenchSuite& suite, const std::string& name, int threads, int ops_per_thread, Op op)
+{
+    if (!suite.Enabled(name)) return;
+
+    std::vector<std::vector<int64_t>> samples(threads);
+    std::atomic<bool> go{false};
+    std::vector<std::thread> callers;
+    for (int t = 0; t < threads; ++t)
+    {
+        callers.emplace_back([&, t]() {
+            samples[t].reserve(ops_per_thread);
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (int i = 0; i < ops_per_thread; ++i)
+            {
+                int64_t start = bench::NowNs();
+                op(t, i);
+                samples[t].push_back(bench::NowNs() - start);
+            }
+        });
+    }
+    int64_t start = bench::NowNs();
+    go.store(true, std::memory_order_release);
+    for (auto& c : callers) c.join();
+    double seconds = (bench::NowNs() - start) / 1e9;
+    suite.Add(name, uint64_t(threads) * ops_per_thread, seconds, bench::Merge(samples), "calls/s");
+}
+
+int main(int argc, char** argv)
+{
+    bench::BenchSuite suite("file", argc, argv);
+    fs::path dir = fs::path(suite.Dir().empty() ? fs::temp_directory_path().string() : suite.Dir())
+                 / ("bench_file_" + to_string(getpid()));
+    fs::create_directories(dir / "in");
+    fs::create_directories(dir / "out");
+    vector<string> inputs;
+    for (int i = 0; i < kFiles; ++i)
+    {
+        inputs.push_back((dir / "in" / ("config" + to_string(i) + ".ini")).string());
+        ofstream(inputs.back(), ios::binary) << string(kFileBytes, char('a' + i % 26));
+    }
+    auto output = [&dir](int thread, int i) {
+        return (dir / "out" / ("t" + to_string(thread) + "_" + to_string(i % 16) + ".sav")).string();
+    };
+    const string content(kFileBytes, 'x');
+
+    ThreadPool pool(4);
+    vector<int> thread_counts = suite.Quick() ? vector<int>{2} : vector<int>{1, 8};
+    for (int threads : thread_counts)
+    {
+        string suffix = "/threads=" + to_string(threads);
+        int reads = suite.Scale(20000, 100) / threads;
+        int writes = suite.Scale(4000, 40) / threads;
+
+        BenchCalls(suite, "read/pool" + suffix, threads, reads, [&](int t, int i) {
+            const string& path = inputs[(t * 7919 + i) % kFiles];
+            if (Async(pool, [path]() { return ReadCache::LoadFile(path); }).Get()->size() != kFileBytes)
+            {
+                throw runtime_error("Short read " + path);
+            }
+        });
+
+        {
+            ReadCache cache;
+            BenchCalls(suite, "read/cache" + suffix, threads, reads, [&](int t, int i) {
+                const string& path = inputs[(t * 7919 + i) % kFiles];
+                if (cache.Read(pool, path).Get()->size() != kFileBytes) throw runtime_error("Short read " + path);
+            });
+        }
+
+        BenchCalls(suite, "write/pool" + suffix, threads, writes, [&](int t, int i) {
+            string path = output(t, i);
+            Async(pool, [path, &content]() {
+                ofstream file(path, ios::binary);
+                if (!(file << content)) throw runtime_error("Cannot write " + path);
+            }).Get();
+        });
+
+        {
+            GroupCommitWriter writer;
+            BenchCalls(suite, "write/group_commit" + suffix, threads, writes, [&](int t, int i) {
+                writer.Replace(output(t, i), content).Get();
+            });
+        }
+    }
+    fs::remove_all(dir);
+    return suite.Finish();
+}
@@ -0,0 +1,102 @@
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Bench.h"
+#include "../lockProfile/LockProfile.h"
+#define SEMAPHORE_NO_MAIN
+#include "../semaphore/Semaphore.cpp"
+
+// 锁在竞争下的加锁/解锁：threads 个线程反复加锁、计数器加一、在锁内忙等 hold_ns、解锁
+//   std::mutex       各组件 Mutex 别名的默认实现
+//   ProfiledMutex    -DLOCK_PROFILING 时 Mutex 换成它，这一项就是统计本身的开销
+//   YieldSpinLock (reference)
+//                    本文件里按 spinLock/SpinLock.md 写的参照实现：test_and_set 失败就让出 CPU
+//                    不是 spinLock.cpp 里的 SpinLock，那个演示版本每次加锁都打印并睡 100ms，不能拿来测
+//   Semaphore        semaphore/Semaphore.cpp 的计数信号量，初值 1 当互斥锁用
+// 延迟是单次 lock() 的等待时间，吞吐是所有线程合计每秒完成的临界区数
+//
+// 运行：bench_lock [--quick] [--json path] [--filter substr]
+
+class YieldSpinLock
+{
+public:
+    void lock()
+    {
+        while (_flag.test_and_set(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+    }
+    void unlock() { _flag.clear(std::memory_order_release); }
+
+private:
+    std::atomic_flag _flag = ATOMIC_FLAG_INIT;
+};
+
+struct SemaphoreLock
+{
+    void lock() { sem.wait(); }
+    void unlock() { sem.signal(); }
+    Semaphore sem{1};
+};
+
+template<typename Lock>
+void BenchLock(bench::BenchSuite& suite, const std::string& lock_name, int threads, int64_t hold_ns, int iterations)
+{
+    std::string name = lock_name + "/threads=" + std::to_string(threads) + "/hold_ns=" + std::to_string(hold_ns);
+    if (!suite.Enabled(name)) return;
+
+    Lock lock;
+    uint64_t counter = 0;
+    std::atomic<bool> go{false};
+    std::vector<std::vector<int64_t>> samples(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t]() {
+            auto& mine = samples[t];
+            mine.reserve(iterations);
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (int i = 0; i < iterations; ++i)
+            {
+                int64_t start = bench::NowNs();
+                lock.lock();
+                mine.push_back(bench::NowNs() - start);
+                ++counter;
+                bench::SpinFor(hold_ns);
+                lock.unlock();
+            }
+        });
+    }
+    int64_t start = bench::NowNs();
+    go.store(true, std::memory_order_release);
+    for (auto& w : workers) w.join();
+    double seconds = (bench::NowNs() - start) / 1e9;
+    if (counter != uint64_t(threads) * iterations)
+    {
+        throw std::runtime_error(name + ": lost updates, counter " + std::to_string(counter));
+    }
+    suite.Add(name, counter, seconds, bench::Merge(samples));
+}
+
+template<typename Lock>
+void BenchLockAll(bench::BenchSuite& suite, const std::string& lock_name)
+{
+    std::vector<int> thread_counts = suite.Quick() ? std::vector<int>{1, 4} : std::vector<int>{1, 2, 4, 8, 16};
+    for (int threads : thread_counts)
+    {
+        BenchLock<Lock>(suite, lock_name, threads, 0, suite.Scale(200000, 2000) / threads);
+        BenchLock<Lock>(suite, lock_name, threads, 1000, suite.Scale(20000, 500) / threads);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bench::BenchSuite suite("lock", argc, argv);
+    BenchLockAll<std::mutex>(suite, "std::mutex");
+    BenchLockAll<ProfiledMutex>(suite, "ProfiledMutex");
+    BenchLockAll<YieldSpinLock>(suite, "YieldSpinLock (reference)");
+    BenchLockAll<SemaphoreLock>(suite, "Semaphore");
+    return suite.Finish();
+}
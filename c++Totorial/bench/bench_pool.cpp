@@ -0,0 +1,95 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "Bench.h"
+#define THREAD_POOL_NO_MAIN
+#include "../threadPool/threadPool.cpp"
+#define DAG_THREAD_POOL_NO_MAIN
+#include "../threadPool/DAGThreadPool.cpp"
+
+// 线程池从提交到开始执行的延迟和吞吐，线程池都是 4 个工作线程，任务本身是空的
+//   latency/idle          一次只提交一个任务，执行完再提交下一个：空闲工作线程被唤醒的延迟
+//   throughput/producers  producers 个线程各自连续提交，统计全部执行完的吞吐和排队中的提交到执行延迟
+// 被测的是 threadPool.cpp 的 threadPool（Commit）和 DAGThreadPool.cpp 的 ThreadPool（PutTask）
+//
+// 运行：bench_pool [--quick] [--json path] [--filter substr]
+
+const int kWorkers = 4;
+
+template<typename Pool, typename Submit>
+void BenchIdleLatency(bench::BenchSuite& suite, const std::string& pool_name, Submit submit, int tasks)
+{
+    std::string name = pool_name + "/latency/idle";
+    if (!suite.Enabled(name)) return;
+
+    Pool pool(kWorkers);
+    std::vector<int64_t> samples(tasks);
+    std::atomic<int> done{0};
+    int64_t start = bench::NowNs();
+    for (int i = 0; i < tasks; ++i)
+    {
+        int64_t submitted = bench::NowNs();
+        submit(pool, [&samples, &done, submitted, i]() {
+            samples[i] = bench::NowNs() - submitted;
+            done.store(i + 1, std::memory_order_release);
+        });
+        while (done.load(std::memory_order_acquire) != i + 1) std::this_thread::yield();
+    }
+    suite.Add(name, tasks, (bench::NowNs() - start) / 1e9, std::move(samples), "tasks/s");
+}
+
+template<typename Pool, typename Submit>
+void BenchThroughput(bench::BenchSuite& suite, const std::string& pool_name, Submit submit, int producers, int tasks_per_producer)
+{
+    std::string name = pool_name + "/throughput/producers=" + std::to_string(producers);
+    if (!suite.Enabled(name)) return;
+
+    const int total = producers * tasks_per_producer;
+    std::vector<int64_t> samples(total);
+    std::atomic<int> done{0};
+    std::atomic<bool> go{false};
+    double seconds = 0;
+    {
+        Pool pool(kWorkers);
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&, p]() {
+                while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+                for (int i = 0; i < tasks_per_producer; ++i)
+                {
+                    int slot = p * tasks_per_producer + i;
+                    int64_t submitted = bench::NowNs();
+                    submit(pool, [&samples, &done, submitted, slot]() {
+                        samples[slot] = bench::NowNs() - submitted;
+                        done.fetch_add(1, std::memory_order_release);
+                    });
+                }
+            });
+        }
+        int64_t start = bench::NowNs();
+        go.store(true, std::memory_order_release);
+        for (auto& t : threads) t.join();
+        while (done.load(std::memory_order_acquire) != total) std::this_thread::yield();
+        seconds = (bench::NowNs() - start) / 1e9;
+    }
+    suite.Add(name, total, seconds, std::move(samples), "tasks/s");
+}
+
+template<typename Pool, typename Submit>
+void BenchPool(bench::BenchSuite& suite, const std::string& pool_name, Submit submit)
+{
+    BenchIdleLatency<Pool>(suite, pool_name, submit, suite.Scale(20000, 200));
+    for (int producers : {1, 4})
+    {
+        BenchThroughput<Pool>(suite, pool_name, submit, producers, suite.Scale(400000, 2000) / producers);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bench::BenchSuite suite("pool", argc, argv);
+    BenchPool<threadPool>(suite, "threadPool", [](threadPool& pool, function<void()> f) { pool.Commit(move(f)); });
+    BenchPool<ThreadPool>(suite, "DAGThreadPool", [](ThreadPool& pool, function<void()> f) { pool.PutTask(move(f)); });
+    return suite.Finish();
+}
@@ -0,0 +1,121 @@
+#include <atomic>
+#include <climits>
+#include <random>
+#include <thread>
+#include <vector>
+#include "Bench.h"
+#define PRIORITY_THREAD_POOL_NO_MAIN
+#include "../threadPool/priorityThreadPool.cpp"
+
+// 优先级队列和优先级线程池（threadPool/priorityThreadPool.cpp）
+//   queue/push、queue/pop    priority_queue<Task> 的单次入队/出队耗时：随机优先级入队 size 个任务，再全部出队
+//   pool/.../priority=P      1 个工作线程先被一个任务占住，期间积压 backlog 个优先级随机（0/10/20）的任务，
+//                            放开后按优先级依次执行；按优先级分别统计提交到执行的延迟，高优先级应该明显更短
+//                            吞吐是这一优先级的任务数除以所有轮次的总时间
+//
+// 运行：bench_priority [--quick] [--json path] [--filter substr]
+
+void BenchQueue(bench::BenchSuite& suite, int size, int rounds)
+{
+    std::string push_name = "queue/push/size=" + std::to_string(size);
+    std::string pop_name = "queue/pop/size=" + std::to_string(size);
+    if (!suite.Enabled(push_name) && !suite.Enabled(pop_name)) return;
+
+    std::mt19937 rng(size);
+    std::uniform_int_distribution<int> priority(0, 1000);
+    std::vector<int64_t> push_samples, pop_samples;
+    push_samples.reserve(size_t(size) * rounds);
+    pop_samples.reserve(size_t(size) * rounds);
+    int64_t push_ns = 0, pop_ns = 0;
+    for (int r = 0; r < rounds; ++r)
+    {
+        priority_queue<Task> tasks;
+        int64_t round_start = bench::NowNs();
+        for (int i = 0; i < size; ++i)
+        {
+            int p = priority(rng);
+            TaskFunc func = [p]() { (void)p; };
+            int64_t start = bench::NowNs();
+            tasks.emplace(p, move(func));
+            push_samples.push_back(bench::NowNs() - start);
+        }
+        int64_t middle = bench::NowNs();
+        push_ns += middle - round_start;
+        int last = INT_MAX;
+        while (!tasks.empty())
+        {
+            int64_t start = bench::NowNs();
+            Task task = move(const_cast<Task&>(tasks.top()));
+            tasks.pop();
+            pop_samples.push_back(bench::NowNs() - start);
+            if (task.getPriority() > last) throw std::runtime_error("priority_queue popped out of order");
+            last = task.getPriority();
+        }
+        pop_ns += bench::NowNs() - middle;
+    }
+    uint64_t ops = uint64_t(size) * rounds;
+    if (suite.Enabled(push_name)) suite.Add(push_name, ops, push_ns / 1e9, std::move(push_samples));
+    if (suite.Enabled(pop_name)) suite.Add(pop_name, ops, pop_ns / 1e9, std::move(pop_samples));
+}
+
+void BenchPoolPriority(bench::BenchSuite& suite, int backlog, int rounds)
+{
+    const int priorities[] = {0, 10, 20};
+    std::string prefix = "pool/backlog=" + std::to_string(backlog) + "/priority=";
+    bool any = false;
+    for (int p : priorities) any = any || suite.Enabled(prefix + std::to_string(p));
+    if (!any) return;
+
+    std::mt19937 rng(backlog);
+    std::uniform_int_distribution<int> pick(0, 2);
+    std::vector<std::vector<int64_t>> samples(3);
+    std::vector<int> kinds(backlog);
+    std::vector<int64_t> latencies(backlog);
+    int64_t total_ns = 0;
+    ThreadPool pool(1);
+    for (int r = 0; r < rounds; ++r)
+    {
+        std::atomic<bool> blocked{false};
+        std::atomic<bool> open{false};
+        std::atomic<int> done{0};
+        pool.PutTask(INT_MAX, [&]() {
+            blocked.store(true, std::memory_order_release);
+            while (!open.load(std::memory_order_acquire)) std::this_thread::yield();
+        });
+        while (!blocked.load(std::memory_order_acquire)) std::this_thread::yield();
+
+        int64_t start = bench::NowNs();
+        for (int i = 0; i < backlog; ++i)
+        {
+            kinds[i] = pick(rng);
+            int64_t submitted = bench::NowNs();
+            pool.PutTask(priorities[kinds[i]], [&latencies, &done, submitted, i]() {
+                latencies[i] = bench::NowNs() - submitted;
+                done.fetch_add(1, std::memory_order_release);
+            });
+        }
+        open.store(true, std::memory_order_release);
+        while (done.load(std::memory_order_acquire) != backlog) std::this_thread::yield();
+        total_ns += bench::NowNs() - start;
+        for (int i = 0; i < backlog; ++i) samples[kinds[i]].push_back(latencies[i]);
+    }
+    for (int k = 2; k >= 0; --k)
+    {
+        std::string name = prefix + std::to_string(priorities[k]);
+        if (!suite.Enabled(name)) continue;
+        uint64_t ops = samples[k].size();
+        suite.Add(name, ops, total_ns / 1e9, std::move(samples[k]), "tasks/s");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bench::BenchSuite suite("priority", argc, argv);
+    for (int size : {1024, 65536})
+    {
+        BenchQueue(suite, size, suite.Scale(std::max(1, (1 << 20) / size), 1));
+    }
+    BenchPoolPriority(suite, 64, suite.Scale(500, 10));
+    BenchPoolPriority(suite, 1024, suite.Scale(50, 2));
+    return suite.Finish();
+}
@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+# 比较两次基准运行的 JSON 结果，标出退化的项
+#   python3 compare.py <baseline> <current> [--threshold 0.10] [--latency-threshold 0.25] [--min-latency-ns 50]
+# baseline / current 可以是单个 JSON 文件，也可以是目录（读取其中所有 *.json，按 suite 对应）
+# 同名的项逐个比较：
+#   - 吞吐下降超过 threshold 算退化
+#   - p50 或 p99 延迟上升超过 latency-threshold 算退化；两次都低于 min-latency-ns 的延迟只是计时噪声，不比较
+# 只在一边出现的项列出来但不算退化。有退化时退出码为 1，可以直接接在 CI 里
+
+import argparse
+import json
+import os
+import sys
+
+
+def load_results(path):
+    files = []
+    if os.path.isdir(path):
+        files = sorted(os.path.join(path, name) for name in os.listdir(path) if name.endswith(".json"))
+    else:
+        files = [path]
+    results = {}
+    meta = {}
+    for file in files:
+        with open(file) as f:
+            data = json.load(f)
+        suite = data["suite"]
+        meta[suite] = data.get("host", {})
+        for result in data["results"]:
+            results[(suite, result["name"])] = result
+    return results, meta
+
+
+def relative(old, new):
+    if old == 0:
+        return 0.0
+    return (new - old) / old
+
+
+def compare(baseline, current, args):
+    regressions = []
+    rows = []
+    for key in sorted(set(baseline) | set(current)):
+        suite, name = key
+        label = suite + ": " + name
+        if key not in baseline:
+            rows.append((label, "new", ""))
+            continue
+        if key not in current:
+            rows.append((label, "missing", ""))
+            continue
+        old, new = baseline[key], current[key]
+        problems = []
+        notes = []
+
+        change = relative(old["throughput"], new["throughput"])
+        notes.append("throughput %+.1f%%" % (change * 100))
+        if change < -args.threshold:
+            problems.append("throughput %+.1f%%" % (change * 100))
+
+        old_latency, new_latency = old["latency_ns"], new["latency_ns"]
+        if old_latency["count"] and new_latency["count"]:
+            for quantile in ("p50", "p99"):
+                before, after = old_latency[quantile], new_latency[quantile]
+                if max(before, after) < args.min_latency_ns:
+                    continue
+                change = relative(before, after)
+                notes.append("%s %+.1f%%" % (quantile, change * 100))
+                if change > args.latency_threshold:
+                    problems.append("%s %d -> %d ns" % (quantile, before, after))
+
+        if problems:
+            regressions.append((label, problems))
+            rows.append((label, "REGRESSION", "; ".join(problems)))
+        else:
+            rows.append((label, "ok", ", ".join(notes)))
+
+    width = max((len(row[0]) for row in rows), default=0)
+    for label, status, detail in rows:
+        print("%-*s  %-10s  %s" % (width, label, status, detail))
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Flag benchmark regressions between two runs")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="allowed relative throughput drop (default 0.10)")
+    parser.add_argument("--latency-threshold", type=float, default=0.25,
+                        help="allowed relative p50/p99 latency increase (default 0.25)")
+    parser.add_argument("--min-latency-ns", type=int, default=50,
+                        help="latencies below this in both runs are not compared (default 50)")
+    args = parser.parse_args()
+
+    baseline, baseline_meta = load_results(args.baseline)
+    current, current_meta = load_results(args.current)
+    for suite in sorted(set(baseline_meta) & set(current_meta)):
+        if baseline_meta[suite] != current_meta[suite]:
+            print("note: %s ran on different hosts/builds: %s vs %s" % (suite, baseline_meta[suite], current_meta[suite]))
+
+    regressions = compare(baseline, current, args)
+    if regressions:
+        print("\n%d regression(s)" % len(regressions))
+        return 1
+    print("\nno regressions")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
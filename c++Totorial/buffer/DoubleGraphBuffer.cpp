@@ -13,14 +13,20 @@ void GlTextureBuffer::Create(int width, int height, GpuBufferFormat format)
 {
     // 这里实现具体的纹理缓冲区创建逻辑
     // 实际项目中需要根据具体的图形API来实现
+    _width = width;
+    _height = height;
+    format_ = format;
 }
 
-DoubleGraphBufferMgr::DoubleGraphBufferMgr(int width, int height, GpuBufferFormat format)
-    : _width(width), _height(height), _format(format)
+DoubleGraphBufferMgr::DoubleGraphBufferMgr(int width, int height, GpuBufferFormat format, int buffer_count)
+    : _desc(GpuBufferDesc{width, height, format}), _buffer_count(buffer_count)
 {
     if (width <= 0 || height <= 0) {
         throw std::invalid_argument("Invalid buffer dimensions");
     }
+    if (buffer_count <= 0) {
+        throw std::invalid_argument("Invalid buffer count");
+    }
     CreateBuffer();
 }
 
@@ -33,14 +39,33 @@ DoubleGraphBufferMgr::~DoubleGraphBufferMgr()
 
 void DoubleGraphBufferMgr::CreateBuffer()
 {
+    GpuBufferDesc desc = _desc.Load();
     for (int i = 0; i < _buffer_count; i++)
     {
         auto buffer = std::make_unique<GlTextureBuffer>();
-        buffer->Create(_width, _height, _format);
+        buffer->Create(desc.width, desc.height, desc.format);
         _draw_available.emplace_back(std::move(buffer));
     }
 }
 
+void DoubleGraphBufferMgr::Resize(int width, int height, GpuBufferFormat format)
+{
+    if (width <= 0 || height <= 0) {
+        throw std::invalid_argument("Invalid buffer dimensions");
+    }
+    _desc.Store(GpuBufferDesc{width, height, format});
+}
+
+void DoubleGraphBufferMgr::Prepare(GlTextureBuffer* buffer)
+{
+    GpuBufferDesc desc = _desc.Load();
+    if (buffer->Matches(desc)) {
+        buffer->Reuse();
+    } else {
+        buffer->Create(desc.width, desc.height, desc.format);
+    }
+}
+
 std::shared_ptr<GlTextureBuffer> DoubleGraphBufferMgr::GetDrawBuffer()
 {
     std::unique_lock<std::mutex> lock(_mutex);
@@ -49,7 +74,7 @@ std::shared_ptr<GlTextureBuffer> DoubleGraphBufferMgr::GetDrawBuffer()
     
     auto buffer = std::move(_draw_available.front());
     _draw_available.pop_front();
-    buffer->Reuse();
+    Prepare(buffer.get());
 
     // 创建weak_ptr指向管理器
     std::weak_ptr<DoubleGraphBufferMgr> weak_mgr = shared_from_this();
@@ -76,6 +101,7 @@ std::shared_ptr<GlTextureBuffer> DoubleGraphBufferMgr::GetCacheBuffer()
     
     auto buffer = std::move(_cache_available.front());
     _cache_available.pop_front();
+    // 缓存缓冲区里是已经渲染好的内容，尺寸变化也不能重建
     buffer->Reuse();
 
     // 创建weak_ptr指向管理器
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <cstdint>
 #include <iostream>
 #include <thread>
@@ -7,29 +9,66 @@
 #include <condition_variable>
 
 using namespace std;
+
+#include "../syncTypes/SyncTypes.h"
+#include "../snapshot/SeqLock.h"
+
 enum class GpuBufferFormat : uint32_t {
   kUnknown = 0,
   kBGRA32  = 1,
 };
 
+// 缓冲区描述：尺寸和格式，很少修改、每次取缓冲区都要读，用 SeqLock 保存
+struct GpuBufferDesc
+{
+    int width = 0;
+    int height = 0;
+    GpuBufferFormat format = GpuBufferFormat::kUnknown;
+};
+
 class GlTextureBuffer
 {
 public:
     void Create(int width, int height, GpuBufferFormat _format);
     void Reuse() {}
+    bool Matches(const GpuBufferDesc& desc) const
+    {
+        return _width == desc.width && _height == desc.height && format_ == desc.format;
+    }
+    int Width() const { return _width; }
+    int Height() const { return _height; }
+    GpuBufferFormat Format() const { return format_; }
+    // CPU 可见的像素存储，共享内存模式下指向 memfd 映射，普通模式下为空
+    void SetStorage(uint8_t* data, size_t bytes) { data_ = data; bytes_ = bytes; }
+    uint8_t* Data() const { return data_; }
+    size_t Bytes() const { return bytes_; }
 private:
-    const int _width = 0;
-    const int _height = 0;
-    const GpuBufferFormat format_ = GpuBufferFormat::kUnknown;
+    int _width = 0;
+    int _height = 0;
+    GpuBufferFormat format_ = GpuBufferFormat::kUnknown;
+    uint8_t* data_ = nullptr;
+    size_t bytes_ = 0;
 };
 
 class DoubleGraphBufferMgr
     : public std::enable_shared_from_this<DoubleGraphBufferMgr>
 {
 public:
-    DoubleGraphBufferMgr(int width, int height, GpuBufferFormat format);
+    DoubleGraphBufferMgr(int width, int height, GpuBufferFormat format, int buffer_count = 2);
     ~DoubleGraphBufferMgr();
 
+    // 缓冲区总数，也是流水线中同时在途帧数的上限
+    int BufferCount() const { return _buffer_count; }
+
+    // 当前的尺寸和格式，读取不加锁
+    GpuBufferDesc Desc() const { return _desc.Load(); }
+    int Width() const { return _desc.Load().width; }
+    int Height() const { return _desc.Load().height; }
+    GpuBufferFormat Format() const { return _desc.Load().format; }
+
+    // 修改尺寸或格式（例如窗口缩放），正在使用的缓冲区不受影响，下次作为绘制缓冲区取出时按新描述重建
+    void Resize(int width, int height, GpuBufferFormat format);
+
     // 获取一个可用的绘制缓冲区，用于渲染操作
     // 如果没有可用的缓冲区，会等待直到有缓冲区可用
     // 使用完后会自动进入缓存队列
@@ -46,16 +85,16 @@ private:
     void EmplaceCacheBuffer(GlTextureBuffer* buffer);
     // 辅助方法：将缓冲区放回绘制队列
     void EmplaceDrawBuffer(GlTextureBuffer* buffer);
+    // 辅助方法：描述变化过的绘制缓冲区按新描述重建，否则直接复用
+    void Prepare(GlTextureBuffer* buffer);
 
 private:
-    const int _width;
-    const int _height;
-    const GpuBufferFormat _format;
-    const int _buffer_count = 2;  // 双缓冲区，所以数量为2
+    SeqLock<GpuBufferDesc> _desc;
+    const int _buffer_count;  // 默认双缓冲区，数量为2
 
     std::mutex _mutex;
-    std::condition_variable _draw_cv;    // 用于等待可用的绘制缓冲区
-    std::condition_variable _cache_cv;   // 用于等待可用的缓存缓冲区
+    CondVar _draw_cv;    // 用于等待可用的绘制缓冲区
+    CondVar _cache_cv;   // 用于等待可用的缓存缓冲区
 
     deque<unique_ptr<GlTextureBuffer>> _draw_available;  // 可用的绘制缓冲区队列
     deque<unique_ptr<GlTextureBuffer>> _cache_available; // 可用的缓存缓冲区队列
@@ -0,0 +1,366 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "DoubleGraphBuffer.h"
+
+using namespace std;
+
+// 帧流水线调度器
+// 一帧分三个阶段：模拟（跑每帧的模块图）-> 渲染（写入 GetDrawBuffer 取到的缓冲区）-> 离线处理（GetCacheBuffer）
+// 三个阶段各占一个线程，第 N+1 帧模拟、第 N 帧渲染、第 N-1 帧离线处理可以同时进行
+// 在途帧数不超过缓冲区数量，延迟不会无限增长
+//
+// 编译：g++ -std=c++17 -pthread FramePipeline.cpp DoubleGraphBuffer.cpp
+
+enum class FrameStage : int
+{
+    kSimulate = 0,
+    kRender,
+    kCache,
+    kCount,
+};
+
+const char* StageName(FrameStage stage)
+{
+    switch (stage)
+    {
+    case FrameStage::kSimulate: return "simulate";
+    case FrameStage::kRender: return "render";
+    case FrameStage::kCache: return "cache";
+    default: return "unknown";
+    }
+}
+
+enum class Access
+{
+    kRead,
+    kWrite,
+};
+
+struct ResourceUse
+{
+    std::string resource;
+    Access access;
+};
+
+// 资源读写依赖跟踪
+// 资源可以声明多份副本（例如双份世界状态），第 N 帧访问第 N % copies 份
+// 访问按帧、阶段顺序登记；一个访问必须等同一份资源上更早登记的冲突访问（写-读、读-写、写-写）全部完成
+class ResourceTracker
+{
+public:
+    void DeclareResource(const std::string& name, int copies)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _copies[name] = std::max(1, copies);
+    }
+
+    // 按顺序登记一帧所有阶段的访问，必须在该帧任何阶段开始前调用
+    void RegisterFrame(int frame, const std::vector<std::vector<ResourceUse>>& stage_uses)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (size_t stage = 0; stage < stage_uses.size(); ++stage)
+        {
+            for (const ResourceUse& use : stage_uses[stage])
+            {
+                _records[Instance(use.resource, frame)].push_back(Record{frame, int(stage), use.access, false});
+            }
+        }
+    }
+
+    // 阻塞直到该阶段的所有访问都没有未完成的前序冲突
+    void Acquire(int frame, int stage, const std::vector<ResourceUse>& uses)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cv.wait(lock, [&]() {
+            for (const ResourceUse& use : uses)
+            {
+                if (HasConflict(Instance(use.resource, frame), frame, stage, use.access)) return false;
+            }
+            return true;
+        });
+    }
+
+    void Release(int frame, int stage, const std::vector<ResourceUse>& uses)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (const ResourceUse& use : uses)
+            {
+                auto& records = _records[Instance(use.resource, frame)];
+                for (Record& record : records)
+                {
+                    if (record.frame == frame && record.stage == stage) record.done = true;
+                }
+                // 回收队首已完成的记录
+                while (!records.empty() && records.front().done) records.pop_front();
+            }
+        }
+        _cv.notify_all();
+    }
+
+private:
+    struct Record
+    {
+        int frame;
+        int stage;
+        Access access;
+        bool done;
+    };
+
+    std::string Instance(const std::string& name, int frame) const
+    {
+        auto it = _copies.find(name);
+        int copies = it == _copies.end() ? 1 : it->second;
+        return name + "#" + std::to_string(frame % copies);
+    }
+
+    bool HasConflict(const std::string& instance, int frame, int stage, Access access)
+    {
+        for (const Record& record : _records[instance])
+        {
+            if (record.frame == frame && record.stage == stage) return false;  // 之前的都检查完了
+            if (record.done) continue;
+            if (access == Access::kWrite || record.access == Access::kWrite) return true;
+        }
+        return false;
+    }
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::unordered_map<std::string, int> _copies;
+    std::unordered_map<std::string, std::deque<Record>> _records;
+};
+
+// 阶段之间传递帧号的阻塞队列（容量由在途帧数限制，不需要额外的上限）
+class FrameQueue
+{
+public:
+    void Push(int frame)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _frames.push_back(frame);
+        }
+        _cv.notify_one();
+    }
+
+    int Pop()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cv.wait(lock, [this]() { return !_frames.empty(); });
+        int frame = _frames.front();
+        _frames.pop_front();
+        return frame;
+    }
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::deque<int> _frames;
+};
+
+struct StageStats
+{
+    double total_ms = 0;
+    double max_ms = 0;
+    int count = 0;
+};
+
+class FrameScheduler
+{
+public:
+    using SimulateFunc = std::function<void(int frame)>;
+    using BufferFunc = std::function<void(int frame, GlTextureBuffer& buffer)>;
+
+    FrameScheduler(std::shared_ptr<DoubleGraphBufferMgr> mgr, int max_frames_in_flight = 0)
+        : _mgr(std::move(mgr))
+    {
+        // 在途帧数受缓冲区数量限制，再多帧也拿不到缓冲区
+        int limit = _mgr->BufferCount();
+        _max_in_flight = max_frames_in_flight > 0 ? std::min(max_frames_in_flight, limit) : limit;
+    }
+
+    ResourceTracker& Resources() { return _tracker; }
+
+    // simulate 里通常是 executor.ExecuteAll(tp); executor.Wait();
+    void SetSimulate(SimulateFunc func, std::vector<ResourceUse> uses) { _simulate = std::move(func); _uses[0] = std::move(uses); }
+    void SetRender(BufferFunc func, std::vector<ResourceUse> uses) { _render = std::move(func); _uses[1] = std::move(uses); }
+    void SetCache(BufferFunc func, std::vector<ResourceUse> uses) { _cache = std::move(func); _uses[2] = std::move(uses); }
+
+    // 运行 frame_count 帧，返回总耗时（毫秒）
+    double Run(int frame_count)
+    {
+        ResetStats();
+        auto start = Clock::now();
+
+        std::thread render_thread([this, frame_count]() {
+            for (int i = 0; i < frame_count; ++i)
+            {
+                int frame = _to_render.Pop();
+                RunStage(frame, FrameStage::kRender, [this, frame]() {
+                    // 缓冲区离开作用域后自动进入缓存队列
+                    std::shared_ptr<GlTextureBuffer> buffer = _mgr->GetDrawBuffer();
+                    _render(frame, *buffer);
+                });
+                _to_cache.Push(frame);
+            }
+        });
+
+        std::thread cache_thread([this, frame_count]() {
+            for (int i = 0; i < frame_count; ++i)
+            {
+                int frame = _to_cache.Pop();
+                RunStage(frame, FrameStage::kCache, [this, frame]() {
+                    // 缓冲区离开作用域后自动回到绘制队列
+                    std::shared_ptr<GlTextureBuffer> buffer = _mgr->GetCacheBuffer();
+                    _cache(frame, *buffer);
+                });
+                FinishFrame(frame);
+            }
+        });
+
+        // 模拟阶段在调用线程上执行
+        for (int frame = 0; frame < frame_count; ++frame)
+        {
+            BeginFrame(frame);
+            RunStage(frame, FrameStage::kSimulate, [this, frame]() { _simulate(frame); });
+            _to_render.Push(frame);
+        }
+
+        render_thread.join();
+        cache_thread.join();
+        return Elapsed(start);
+    }
+
+    void PrintStats(double total_ms, int frame_count) const
+    {
+        std::cout << "frames in flight <= " << _max_in_flight << ", " << frame_count << " frames in "
+                  << total_ms << " ms, " << frame_count * 1000.0 / total_ms << " fps" << std::endl;
+        for (int i = 0; i < int(FrameStage::kCount); ++i)
+        {
+            const StageStats& stats = _stats[i];
+            std::cout << "  " << StageName(FrameStage(i)) << ": avg " << stats.total_ms / std::max(1, stats.count)
+                      << " ms, max " << stats.max_ms << " ms" << std::endl;
+        }
+        std::cout << "  latency: avg " << _latency.total_ms / std::max(1, _latency.count)
+                  << " ms, max " << _latency.max_ms << " ms" << std::endl;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static double Elapsed(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // 开始新的一帧：等待在途帧数低于上限，然后登记这一帧的资源访问
+    void BeginFrame(int frame)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cv.wait(lock, [this]() { return _in_flight < _max_in_flight; });
+            _in_flight++;
+            _frame_start[frame] = Clock::now();
+        }
+        _tracker.RegisterFrame(frame, {_uses[0], _uses[1], _uses[2]});
+    }
+
+    void FinishFrame(int frame)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _in_flight--;
+            double latency = Elapsed(_frame_start[frame]);
+            _frame_start.erase(frame);
+            _latency.total_ms += latency;
+            _latency.max_ms = std::max(_latency.max_ms, latency);
+            _latency.count++;
+        }
+        _cv.notify_one();
+    }
+
+    void RunStage(int frame, FrameStage stage, const std::function<void()>& body)
+    {
+        int index = int(stage);
+        _tracker.Acquire(frame, index, _uses[index]);
+        auto start = Clock::now();
+        body();
+        double ms = Elapsed(start);
+        _tracker.Release(frame, index, _uses[index]);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        StageStats& stats = _stats[index];
+        stats.total_ms += ms;
+        stats.max_ms = std::max(stats.max_ms, ms);
+        stats.count++;
+    }
+
+    void ResetStats()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto& stats : _stats) stats = StageStats();
+        _latency = StageStats();
+    }
+
+private:
+    std::shared_ptr<DoubleGraphBufferMgr> _mgr;
+    int _max_in_flight = 1;
+    ResourceTracker _tracker;
+    SimulateFunc _simulate;
+    BufferFunc _render;
+    BufferFunc _cache;
+    std::vector<ResourceUse> _uses[int(FrameStage::kCount)];
+
+    FrameQueue _to_render;
+    FrameQueue _to_cache;
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    int _in_flight = 0;
+    std::unordered_map<int, Clock::time_point> _frame_start;
+    StageStats _stats[int(FrameStage::kCount)];
+    StageStats _latency;
+};
+
+// 模拟 16ms/12ms/10ms 的三个阶段
+// 世界状态有两份，模拟写第 N % 2 份、渲染读同一份；渲染结果写入缓冲区，离线处理读缓冲区
+void RunDemo(int max_in_flight, int buffer_count)
+{
+    auto mgr = std::make_shared<DoubleGraphBufferMgr>(1920, 1080, GpuBufferFormat::kBGRA32, buffer_count);
+    FrameScheduler scheduler(mgr, max_in_flight);
+    scheduler.Resources().DeclareResource("world", 2);
+
+    scheduler.SetSimulate([](int) { std::this_thread::sleep_for(std::chrono::milliseconds(16)); },
+                          {{"world", Access::kWrite}});
+    scheduler.SetRender([](int, GlTextureBuffer&) { std::this_thread::sleep_for(std::chrono::milliseconds(12)); },
+                        {{"world", Access::kRead}});
+    scheduler.SetCache([](int, GlTextureBuffer&) { std::this_thread::sleep_for(std::chrono::milliseconds(10)); },
+                       {});
+
+    const int frames = 60;
+    double total_ms = scheduler.Run(frames);
+    scheduler.PrintStats(total_ms, frames);
+}
+
+int main()
+{
+    std::cout << "sequential:" << std::endl;
+    RunDemo(1, 2);
+    std::cout << "pipelined (double buffer):" << std::endl;
+    RunDemo(0, 2);
+    std::cout << "pipelined (triple buffer):" << std::endl;
+    RunDemo(0, 3);
+    return 0;
+}
@@ -0,0 +1,184 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "SharedGraphBuffer.h"
+
+using namespace std;
+
+// 渲染进程 -> 编码进程的 4K BGRA 帧传递：共享内存零拷贝 vs 通过 socket 拷贝整帧
+// 渲染进程每帧写满整块缓冲区并在开头写入帧号，编码进程校验帧号并抽样读取像素
+//
+// 编译：g++ -std=c++17 -O2 -pthread FrameShareBench.cpp SharedGraphBuffer.cpp DoubleGraphBuffer.cpp
+// 运行：./a.out [frames]
+
+constexpr int kWidth = 3840;
+constexpr int kHeight = 2160;
+constexpr size_t kPixelBytes = size_t(kWidth) * kHeight * 4;
+
+struct BenchResult
+{
+    double seconds;
+    double cpu_ms;  // 两个进程的用户态 + 内核态 CPU 时间
+    bool ok;
+};
+
+double CpuMs(const rusage& usage)
+{
+    return usage.ru_utime.tv_sec * 1e3 + usage.ru_utime.tv_usec / 1e3
+         + usage.ru_stime.tv_sec * 1e3 + usage.ru_stime.tv_usec / 1e3;
+}
+
+void Render(uint8_t* data, uint64_t frame)
+{
+    memset(data, int(frame & 0xff), kPixelBytes);
+    memcpy(data, &frame, sizeof(frame));
+}
+
+// 编码端只校验帧号并抽样，避免消费端的计算掩盖传递本身的开销
+bool Consume(const uint8_t* data, uint64_t expected)
+{
+    uint64_t frame;
+    memcpy(&frame, data, sizeof(frame));
+    if (frame != expected) return false;
+    for (size_t offset = kPixelBytes / 2; offset < kPixelBytes; offset += 4096)
+    {
+        if (data[offset] != uint8_t(expected & 0xff)) return false;
+    }
+    return true;
+}
+
+// fork 出编码进程执行 consumer，父进程执行 producer，统计总耗时和两个进程的 CPU 时间
+template<typename Producer, typename Consumer>
+BenchResult Run(Producer producer, Consumer consumer)
+{
+    cout.flush();
+    rusage before;
+    getrusage(RUSAGE_SELF, &before);
+    auto start = chrono::steady_clock::now();
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        throw runtime_error("fork failed");
+    }
+    if (pid == 0) {
+        _exit(consumer() ? 0 : 1);
+    }
+    producer();
+
+    int status = 0;
+    rusage child;
+    wait4(pid, &status, 0, &child);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    rusage after;
+    getrusage(RUSAGE_SELF, &after);
+
+    bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    return BenchResult{seconds, CpuMs(after) - CpuMs(before) + CpuMs(child), ok};
+}
+
+BenchResult BenchShared(int frames)
+{
+    auto mgr = SharedGraphBufferMgr::Create(kWidth, kHeight, GpuBufferFormat::kBGRA32, 3);
+    int fd = mgr->Fd();
+    return Run(
+        [&]() {
+            for (int i = 0; i < frames; ++i)
+            {
+                auto buffer = mgr->GetDrawBuffer();
+                Render(buffer->Data(), uint64_t(i));
+            }
+        },
+        [&]() {
+            // 模拟独立的编码进程：只通过 fd 映射共享内存
+            auto consumer = SharedGraphBufferMgr::Attach(dup(fd));
+            bool ok = true;
+            for (int i = 0; i < frames; ++i)
+            {
+                auto buffer = consumer->GetCacheBuffer();
+                ok = Consume(buffer->Data(), uint64_t(i)) && ok;
+            }
+            return ok;
+        });
+}
+
+bool WriteAll(int fd, const uint8_t* data, size_t bytes)
+{
+    while (bytes > 0)
+    {
+        ssize_t n = write(fd, data, bytes);
+        if (n <= 0) return false;
+        data += n;
+        bytes -= size_t(n);
+    }
+    return true;
+}
+
+bool ReadAll(int fd, uint8_t* data, size_t bytes)
+{
+    while (bytes > 0)
+    {
+        ssize_t n = read(fd, data, bytes);
+        if (n <= 0) return false;
+        data += n;
+        bytes -= size_t(n);
+    }
+    return true;
+}
+
+BenchResult BenchCopy(int frames)
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        throw runtime_error("socketpair failed");
+    }
+    BenchResult result = Run(
+        [&]() {
+            close(fds[1]);
+            vector<uint8_t> frame(kPixelBytes);
+            for (int i = 0; i < frames; ++i)
+            {
+                Render(frame.data(), uint64_t(i));
+                if (!WriteAll(fds[0], frame.data(), frame.size())) break;
+            }
+            close(fds[0]);
+        },
+        [&]() {
+            close(fds[0]);
+            vector<uint8_t> frame(kPixelBytes);
+            bool ok = true;
+            for (int i = 0; i < frames; ++i)
+            {
+                if (!ReadAll(fds[1], frame.data(), frame.size())) return false;
+                ok = Consume(frame.data(), uint64_t(i)) && ok;
+            }
+            return ok;
+        });
+    return result;
+}
+
+void Print(const string& name, int frames, const BenchResult& result)
+{
+    cout << "  " << left << setw(8) << name << right << fixed << setprecision(1)
+         << setw(8) << frames / result.seconds << " fps"
+         << setw(10) << result.cpu_ms / frames << " ms cpu/frame"
+         << (result.ok ? "" : "  (VERIFY FAILED)") << endl;
+    cout.unsetf(ios::fixed);
+}
+
+int main(int argc, char** argv)
+{
+    int frames = argc > 1 ? atoi(argv[1]) : 120;
+    cout << "4K BGRA (" << kPixelBytes / (1024 * 1024) << " MB/frame), " << frames << " frames:" << endl;
+    Print("copy", frames, BenchCopy(frames));
+    Print("shared", frames, BenchShared(frames));
+    return 0;
+}
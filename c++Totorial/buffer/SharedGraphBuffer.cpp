@@ -0,0 +1,263 @@
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "SharedGraphBuffer.h"
+
+using namespace std;
+
+void ShmIndexQueue::Init()
+{
+    for (uint32_t i = 0; i < kCapacity; ++i)
+    {
+        cells[i].seq.store(i, memory_order_relaxed);
+    }
+    enqueue_pos.store(0, memory_order_relaxed);
+    dequeue_pos.store(0, memory_order_relaxed);
+    new (&not_empty) SharedEventCount();
+}
+
+bool ShmIndexQueue::TryPush(uint32_t value)
+{
+    uint32_t pos = enqueue_pos.load(memory_order_relaxed);
+    Cell* cell;
+    while (true)
+    {
+        cell = &cells[pos % kCapacity];
+        uint32_t seq = cell->seq.load(memory_order_acquire);
+        int32_t diff = int32_t(seq - pos);
+        if (diff == 0)
+        {
+            if (enqueue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+        }
+        else if (diff < 0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = enqueue_pos.load(memory_order_relaxed);
+        }
+    }
+    cell->value = value;
+    cell->seq.store(pos + 1, memory_order_release);
+    return true;
+}
+
+bool ShmIndexQueue::TryPop(uint32_t& value)
+{
+    uint32_t pos = dequeue_pos.load(memory_order_relaxed);
+    Cell* cell;
+    while (true)
+    {
+        cell = &cells[pos % kCapacity];
+        uint32_t seq = cell->seq.load(memory_order_acquire);
+        int32_t diff = int32_t(seq - (pos + 1));
+        if (diff == 0)
+        {
+            if (dequeue_pos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+        }
+        else if (diff < 0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = dequeue_pos.load(memory_order_relaxed);
+        }
+    }
+    value = cell->value;
+    cell->seq.store(pos + kCapacity, memory_order_release);
+    return true;
+}
+
+void ShmIndexQueue::Push(uint32_t value)
+{
+    while (!TryPush(value)) this_thread::yield();
+    not_empty.NotifyOne();
+}
+
+uint32_t ShmIndexQueue::Pop()
+{
+    uint32_t value;
+    while (true)
+    {
+        if (TryPop(value)) return value;
+        SharedEventCount::Key key = not_empty.PrepareWait();
+        if (TryPop(value))
+        {
+            not_empty.CancelWait();
+            return value;
+        }
+        not_empty.CommitWait(key);
+    }
+}
+
+// 共享内存布局：Header | 填充到页边界 | 缓冲区 0 | 缓冲区 1 | ...
+struct SharedGraphBufferMgr::Header
+{
+    static constexpr uint32_t kMagic = 0x47425546;  // "GBUF"
+
+    uint32_t magic;
+    uint32_t buffer_count;
+    int32_t width;
+    int32_t height;
+    GpuBufferFormat format;
+    uint64_t frame_bytes;
+    uint64_t data_offset;
+    ShmIndexQueue draw;
+    ShmIndexQueue cache;
+};
+
+namespace
+{
+size_t PageAlign(size_t bytes)
+{
+    size_t page = size_t(sysconf(_SC_PAGESIZE));
+    return (bytes + page - 1) / page * page;
+}
+
+size_t BytesPerPixel(GpuBufferFormat format)
+{
+    switch (format)
+    {
+    case GpuBufferFormat::kBGRA32: return 4;
+    default: return 0;
+    }
+}
+}
+
+shared_ptr<SharedGraphBufferMgr> SharedGraphBufferMgr::Create(int width, int height, GpuBufferFormat format, int buffer_count)
+{
+    if (width <= 0 || height <= 0) {
+        throw invalid_argument("Invalid buffer dimensions");
+    }
+    if (buffer_count <= 0 || uint32_t(buffer_count) > kMaxBuffers) {
+        throw invalid_argument("Invalid buffer count");
+    }
+    size_t bpp = BytesPerPixel(format);
+    if (bpp == 0) {
+        throw invalid_argument("Unsupported buffer format");
+    }
+
+    size_t frame_bytes = PageAlign(size_t(width) * size_t(height) * bpp);
+    size_t data_offset = PageAlign(sizeof(Header));
+    size_t size = data_offset + frame_bytes * size_t(buffer_count);
+
+    int fd = memfd_create("graph_buffer", MFD_CLOEXEC);
+    if (fd < 0) {
+        throw runtime_error("memfd_create failed");
+    }
+    if (ftruncate(fd, off_t(size)) != 0) {
+        close(fd);
+        throw runtime_error("ftruncate failed");
+    }
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        throw runtime_error("mmap failed");
+    }
+
+    Header* header = static_cast<Header*>(base);
+    header->buffer_count = uint32_t(buffer_count);
+    header->width = width;
+    header->height = height;
+    header->format = format;
+    header->frame_bytes = frame_bytes;
+    header->data_offset = data_offset;
+    header->draw.Init();
+    header->cache.Init();
+    for (int i = 0; i < buffer_count; ++i) {
+        header->draw.TryPush(uint32_t(i));
+    }
+    // magic 最后写入，Attach 看到它说明其余字段都已初始化
+    reinterpret_cast<atomic<uint32_t>*>(&header->magic)->store(Header::kMagic, memory_order_release);
+
+    return shared_ptr<SharedGraphBufferMgr>(new SharedGraphBufferMgr(fd, base, size));
+}
+
+shared_ptr<SharedGraphBufferMgr> SharedGraphBufferMgr::Attach(int fd)
+{
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Header)) {
+        close(fd);
+        throw runtime_error("Invalid shared buffer fd");
+    }
+    size_t size = size_t(st.st_size);
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        throw runtime_error("mmap failed");
+    }
+    Header* header = static_cast<Header*>(base);
+    uint32_t magic = reinterpret_cast<atomic<uint32_t>*>(&header->magic)->load(memory_order_acquire);
+    if (magic != Header::kMagic || header->data_offset + header->frame_bytes * header->buffer_count > size) {
+        munmap(base, size);
+        close(fd);
+        throw runtime_error("Shared buffer header is corrupted");
+    }
+    return shared_ptr<SharedGraphBufferMgr>(new SharedGraphBufferMgr(fd, base, size));
+}
+
+SharedGraphBufferMgr::SharedGraphBufferMgr(int fd, void* base, size_t size)
+    : _fd(fd), _base(base), _size(size), _header(static_cast<Header*>(base))
+{
+    uint8_t* data = static_cast<uint8_t*>(base) + _header->data_offset;
+    for (uint32_t i = 0; i < _header->buffer_count; ++i)
+    {
+        auto buffer = make_unique<GlTextureBuffer>();
+        buffer->Create(_header->width, _header->height, _header->format);
+        buffer->SetStorage(data + i * _header->frame_bytes, _header->frame_bytes);
+        _buffers.emplace_back(move(buffer));
+    }
+}
+
+SharedGraphBufferMgr::~SharedGraphBufferMgr()
+{
+    munmap(_base, _size);
+    close(_fd);
+}
+
+int SharedGraphBufferMgr::BufferCount() const
+{
+    return int(_header->buffer_count);
+}
+
+GpuBufferDesc SharedGraphBufferMgr::Desc() const
+{
+    return GpuBufferDesc{_header->width, _header->height, _header->format};
+}
+
+size_t SharedGraphBufferMgr::FrameBytes() const
+{
+    return _header->frame_bytes;
+}
+
+shared_ptr<GlTextureBuffer> SharedGraphBufferMgr::GetDrawBuffer()
+{
+    return Lease(_header->draw, true);
+}
+
+shared_ptr<GlTextureBuffer> SharedGraphBufferMgr::GetCacheBuffer()
+{
+    return Lease(_header->cache, false);
+}
+
+// 从队列取出一个下标，归还时把下标放进另一个队列；缓冲区对象本身归管理器所有，删除器不释放它
+shared_ptr<GlTextureBuffer> SharedGraphBufferMgr::Lease(ShmIndexQueue& from, bool to_cache)
+{
+    uint32_t index = from.Pop();
+    weak_ptr<SharedGraphBufferMgr> weak_mgr = shared_from_this();
+    return shared_ptr<GlTextureBuffer>(
+        _buffers[index].get(),
+        [weak_mgr, index, to_cache](GlTextureBuffer*) {
+            auto mgr = weak_mgr.lock();
+            if (mgr) {
+                (to_cache ? mgr->_header->cache : mgr->_header->draw).Push(index);
+            }
+        }
+    );
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "DoubleGraphBuffer.h"
+#include "../eventCount/EventCount.h"
+
+// 跨进程零拷贝的缓冲区管理器
+// 接口与 DoubleGraphBufferMgr 相同：GetDrawBuffer() 取绘制缓冲区，用完自动进入缓存队列；
+// GetCacheBuffer() 取缓存缓冲区，用完自动回到绘制队列
+// 区别在于所有状态都放在一块 memfd 共享内存里：
+//   - 像素数据：每个缓冲区一段，按页对齐
+//   - 绘制/缓存队列：保存缓冲区下标的无锁环形队列，空时用跨进程 futex 等待
+// 渲染进程 Create() 之后把 Fd() 交给编码进程（fork 继承或 SCM_RIGHTS），对方 Attach(fd) 映射同一块内存，
+// 帧在两个进程之间只传递下标，不拷贝像素
+
+// 共享内存中的多生产者多消费者有界队列（Vyukov），元素是缓冲区下标
+struct ShmIndexQueue
+{
+    static constexpr uint32_t kCapacity = 64;
+
+    struct Cell
+    {
+        std::atomic<uint32_t> seq;
+        uint32_t value;
+    };
+
+    void Init();
+    bool TryPush(uint32_t value);
+    bool TryPop(uint32_t& value);
+    // 容量不小于缓冲区总数，Push 不会长时间阻塞
+    void Push(uint32_t value);
+    // 队列为空时睡眠，直到其他进程 Push
+    uint32_t Pop();
+
+    alignas(64) std::atomic<uint32_t> enqueue_pos;
+    alignas(64) std::atomic<uint32_t> dequeue_pos;
+    alignas(64) SharedEventCount not_empty;
+    Cell cells[kCapacity];
+};
+
+class SharedGraphBufferMgr
+    : public std::enable_shared_from_this<SharedGraphBufferMgr>
+{
+public:
+    static constexpr uint32_t kMaxBuffers = ShmIndexQueue::kCapacity;
+
+    // 新建共享内存并初始化，所有缓冲区都在绘制队列中
+    static std::shared_ptr<SharedGraphBufferMgr> Create(int width, int height, GpuBufferFormat format, int buffer_count = 2);
+    // 映射另一个进程创建的共享内存，fd 的所有权转移给返回的对象
+    static std::shared_ptr<SharedGraphBufferMgr> Attach(int fd);
+
+    ~SharedGraphBufferMgr();
+
+    int Fd() const { return _fd; }
+    int BufferCount() const;
+    GpuBufferDesc Desc() const;
+    size_t FrameBytes() const;
+
+    std::shared_ptr<GlTextureBuffer> GetDrawBuffer();
+    std::shared_ptr<GlTextureBuffer> GetCacheBuffer();
+
+private:
+    struct Header;
+
+    SharedGraphBufferMgr(int fd, void* base, size_t size);
+    std::shared_ptr<GlTextureBuffer> Lease(ShmIndexQueue& from, bool to_cache);
+
+private:
+    int _fd = -1;
+    void* _base = nullptr;
+    size_t _size = 0;
+    Header* _header = nullptr;
+    // 本进程内对每段共享像素的描述，不在共享内存中
+    std::vector<std::unique_ptr<GlTextureBuffer>> _buffers;
+};
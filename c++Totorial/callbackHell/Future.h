@@ -0,0 +1,493 @@
+#pragma once
+
+// 非阻塞的 Future / Promise，用来代替层层嵌套的回调
+//   - Then(f)：结果就绪后在完成它的那个线程上直接执行 f（已经就绪则当场执行），不另起线程
+//   - Then(pool, f)：f 交给指定的执行器；完成线程本来就是该线程池的工作线程时直接执行，省掉一次入队和线程切换
+//   - f 返回普通值得到 Future<值>，返回 void 得到 Future<Unit>，返回 Future<U> 会自动展开成 Future<U>
+//   - 异常沿链条传递，跳过中间的 f，直到 Get() 时重新抛出，或者交给末端的 Finally(f) 回调
+//   - WhenAll / WhenAny：把一组 Future 合成一个，整个组合只分配一个共享状态
+//
+// 执行器只需要提供 PutTask(task)，可选提供 bool InWorker()（当前线程是否是它的工作线程）
+// 每个 Future 只能消费一次：Then / Get 之后原对象失效
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "../phase/Phase.h"
+
+// Future<void> 的替代：没有值，只表示"完成了"
+struct Unit {};
+
+template<typename T> class Future;
+template<typename T> class Promise;
+
+namespace future_detail
+{
+// 值或异常，二者有且只有一个
+template<typename T>
+struct Result
+{
+    std::optional<T> value;
+    std::exception_ptr error;
+
+    T Take()
+    {
+        if (error) std::rethrow_exception(error);
+        return std::move(*value);
+    }
+};
+
+// 结果与续体之间的交接只用一个原子状态：先到的一方 CAS 占位，后到的一方负责执行续体
+template<typename T>
+class SharedState
+{
+public:
+    using Callback = std::function<void(Result<T>&)>;
+
+    virtual ~SharedState() = default;
+
+    void SetValue(T value)
+    {
+        _result.value.emplace(std::move(value));
+        Publish();
+    }
+
+    void SetError(std::exception_ptr error)
+    {
+        _result.error = std::move(error);
+        Publish();
+    }
+
+    void SetResult(Result<T>&& result)
+    {
+        _result = std::move(result);
+        Publish();
+    }
+
+    void SetCallback(Callback callback)
+    {
+        _callback = std::move(callback);
+        int expected = kEmpty;
+        if (_phase.compare_exchange_strong(expected, kCallback, std::memory_order_acq_rel)) return;
+        // 结果已经在了：当场执行
+        _phase.store(kDone, std::memory_order_relaxed);
+        RunCallback();
+    }
+
+    bool IsReady() const
+    {
+        int phase = _phase.load(std::memory_order_acquire);
+        return phase == kResult || phase == kDone;
+    }
+
+private:
+    void Publish()
+    {
+        int expected = kEmpty;
+        if (_phase.compare_exchange_strong(expected, kResult, std::memory_order_acq_rel)) return;
+        _phase.store(kDone, std::memory_order_relaxed);
+        RunCallback();
+    }
+
+    enum { kEmpty, kResult, kCallback, kDone };
+
+    void RunCallback()
+    {
+        Callback callback = std::move(_callback);
+        callback(_result);
+    }
+
+    Result<T> _result;
+    std::atomic<int> _phase{kEmpty};
+    Callback _callback;
+};
+
+template<typename R>
+struct Unwrap
+{
+    using type = R;
+};
+
+template<>
+struct Unwrap<void>
+{
+    using type = Unit;
+};
+
+template<typename U>
+struct Unwrap<Future<U>>
+{
+    using type = U;
+};
+
+template<typename F, typename T>
+using ContinuationValue = typename Unwrap<std::invoke_result_t<F&, T>>::type;
+
+// 执行器有 InWorker() 且当前就在它的工作线程上：直接执行
+template<typename Executor, typename Task>
+auto Dispatch(Executor& executor, Task&& task, int) -> decltype(executor.InWorker(), void())
+{
+    if (executor.InWorker()) task();
+    else executor.PutTask(std::forward<Task>(task));
+}
+
+template<typename Executor, typename Task>
+void Dispatch(Executor& executor, Task&& task, long)
+{
+    executor.PutTask(std::forward<Task>(task));
+}
+
+// 用上游结果调用 f，把 f 的结果交给 next；f 抛出的异常也交给 next
+template<typename U, typename F, typename T>
+void Apply(const std::shared_ptr<SharedState<U>>& next, F& f, Result<T>& result)
+{
+    using R = std::invoke_result_t<F&, T>;
+    if (result.error)
+    {
+        next->SetError(result.error);
+        return;
+    }
+    Result<U> out;
+    std::optional<std::conditional_t<std::is_same_v<R, Future<U>>, R, Unit>> inner;
+    try
+    {
+        if constexpr (std::is_void_v<R>)
+        {
+            f(std::move(*result.value));
+            out.value.emplace();
+        }
+        else if constexpr (std::is_same_v<R, Future<U>>)
+        {
+            inner.emplace(f(std::move(*result.value)));
+        }
+        else
+        {
+            out.value.emplace(f(std::move(*result.value)));
+        }
+    }
+    catch (...)
+    {
+        out.error = std::current_exception();
+    }
+    // 在 try 外面交出结果，下游续体抛出的异常不会被当成 f 的异常再设置一次
+    if constexpr (std::is_same_v<R, Future<U>>)
+    {
+        if (inner)
+        {
+            std::move(*inner).Forward(next);
+            return;
+        }
+    }
+    next->SetResult(std::move(out));
+}
+}
+
+class InlineExecutor
+{
+public:
+    template<typename F>
+    void PutTask(F&& f) { f(); }
+};
+
+template<typename T>
+class Future
+{
+public:
+    using State = future_detail::SharedState<T>;
+
+    Future() = default;
+    explicit Future(std::shared_ptr<State> state) : _state(std::move(state)) {}
+
+    bool Valid() const { return _state != nullptr; }
+    bool IsReady() const { return _state && _state->IsReady(); }
+
+    // 结果就绪后在完成它的线程上执行 f
+    template<typename F>
+    Future<future_detail::ContinuationValue<F, T>> Then(F&& f) &&
+    {
+        using U = future_detail::ContinuationValue<F, T>;
+        auto next = std::make_shared<future_detail::SharedState<U>>();
+        TakeState()->SetCallback([next, f = std::forward<F>(f)](future_detail::Result<T>& result) mutable {
+            future_detail::Apply(next, f, result);
+        });
+        return Future<U>(next);
+    }
+
+    // 结果就绪后把 f 交给 executor 执行
+    template<typename Executor, typename F>
+    Future<future_detail::ContinuationValue<F, T>> Then(Executor& executor, F&& f) &&
+    {
+        using U = future_detail::ContinuationValue<F, T>;
+        auto next = std::make_shared<future_detail::SharedState<U>>();
+        TakeState()->SetCallback([next, &executor, f = std::forward<F>(f)](future_detail::Result<T>& result) mutable {
+            future_detail::Dispatch(executor, [next, f, result = std::move(result)]() mutable {
+                future_detail::Apply(next, f, result);
+            }, 0);
+        });
+        return Future<U>(next);
+    }
+
+    // 链条末端的回调：结果就绪后在完成它的线程上调用 f(error)，成功时 error 为空，值被丢弃
+    // 给只需要知道成败的回调风格接口用，异常不会因为没人 Get 而悄悄丢掉
+    template<typename F>
+    void Finally(F&& f) &&
+    {
+        TakeState()->SetCallback([f = std::forward<F>(f)](future_detail::Result<T>& result) mutable {
+            f(result.error);
+        });
+    }
+
+    // 阻塞等待结果；有异常则重新抛出。只应在链条末端、不在工作线程上调用
+    T Get() &&
+    {
+        future_detail::Result<T> out;
+        Latch done(1);
+        TakeState()->SetCallback([&out, &done](future_detail::Result<T>& result) {
+            out = std::move(result);
+            done.CountDown();
+        });
+        done.Wait();
+        return out.Take();
+    }
+
+    // 工作线程里等待：等的同时帮线程池执行排队的任务
+    template<typename Pool>
+    T Get(Pool& pool) &&
+    {
+        future_detail::Result<T> out;
+        Latch done(1);
+        TakeState()->SetCallback([&out, &done](future_detail::Result<T>& result) {
+            out = std::move(result);
+            done.CountDown();
+        });
+        done.Wait(pool);
+        return out.Take();
+    }
+
+    // 把结果原样转交给另一个共享状态（Then 展开 Future<Future<U>> 时用）
+    void Forward(const std::shared_ptr<State>& target) &&
+    {
+        TakeState()->SetCallback([target](future_detail::Result<T>& result) {
+            target->SetResult(std::move(result));
+        });
+    }
+
+    // 组合器内部用：直接挂续体，不创建新的 Future
+    void Subscribe(typename State::Callback callback) &&
+    {
+        TakeState()->SetCallback(std::move(callback));
+    }
+
+private:
+    std::shared_ptr<State> TakeState()
+    {
+        if (!_state) {
+            throw std::logic_error("Future has no state or was already consumed");
+        }
+        return std::move(_state);
+    }
+
+    std::shared_ptr<State> _state;
+};
+
+template<typename T>
+class Promise
+{
+public:
+    Promise() : _state(std::make_shared<future_detail::SharedState<T>>()) {}
+    ~Promise()
+    {
+        // 没有设置结果就销毁：让等待方收到异常，而不是永远等下去
+        if (_state && !_fulfilled) {
+            _state->SetError(std::make_exception_ptr(std::runtime_error("Broken promise")));
+        }
+    }
+
+    Promise(Promise&&) = default;
+    Promise& operator=(Promise&&) = delete;
+    Promise(const Promise&) = delete;
+    Promise& operator=(const Promise&) = delete;
+
+    Future<T> GetFuture()
+    {
+        if (_retrieved) {
+            throw std::logic_error("Future already retrieved");
+        }
+        _retrieved = true;
+        return Future<T>(_state);
+    }
+
+    void SetValue(T value)
+    {
+        CheckUnfulfilled();
+        _state->SetValue(std::move(value));
+    }
+
+    void SetException(std::exception_ptr error)
+    {
+        CheckUnfulfilled();
+        _state->SetError(std::move(error));
+    }
+
+private:
+    void CheckUnfulfilled()
+    {
+        if (_fulfilled) {
+            throw std::logic_error("Promise already satisfied");
+        }
+        _fulfilled = true;
+    }
+
+    std::shared_ptr<future_detail::SharedState<T>> _state;
+    bool _retrieved = false;
+    bool _fulfilled = false;
+};
+
+template<typename T>
+Future<std::decay_t<T>> MakeReadyFuture(T&& value)
+{
+    auto state = std::make_shared<future_detail::SharedState<std::decay_t<T>>>();
+    state->SetValue(std::forward<T>(value));
+    return Future<std::decay_t<T>>(state);
+}
+
+template<typename T>
+Future<T> MakeErrorFuture(std::exception_ptr error)
+{
+    auto state = std::make_shared<future_detail::SharedState<T>>();
+    state->SetError(std::move(error));
+    return Future<T>(state);
+}
+
+// 在 executor 上执行 f，返回它的结果
+// 总是入队，不像 Then 那样在工作线程上就地执行，否则起不到并行的作用
+template<typename Executor, typename F>
+auto Async(Executor& executor, F&& f)
+{
+    auto call = [f = std::forward<F>(f)](Unit) mutable { return f(); };
+    using U = future_detail::ContinuationValue<decltype(call), Unit>;
+    auto next = std::make_shared<future_detail::SharedState<U>>();
+    executor.PutTask([next, call]() mutable {
+        future_detail::Result<Unit> unit;
+        unit.value.emplace();
+        future_detail::Apply(next, call, unit);
+    });
+    return Future<U>(next);
+}
+
+namespace future_detail
+{
+// 组合器的共享状态就是结果 Future 的共享状态，计数器、结果数组都挂在这一个对象上
+// 每个输入上挂的续体只捕获一个裸指针和下标，能放进 std::function 的内部缓冲，不再分配
+// 状态通过 _self 保活，直到最后一个输入完成
+template<typename T>
+class WhenAllState : public SharedState<std::vector<T>>
+{
+public:
+    explicit WhenAllState(size_t n) : _remaining(n), _values(n) {}
+
+    static Future<std::vector<T>> Start(std::vector<Future<T>>& inputs)
+    {
+        auto state = std::make_shared<WhenAllState>(inputs.size());
+        if (inputs.empty())
+        {
+            state->SetValue({});
+            return Future<std::vector<T>>(state);
+        }
+        state->_self = state;
+        WhenAllState* raw = state.get();
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            std::move(inputs[i]).Subscribe([raw, i](Result<T>& result) { raw->OnInput(i, result); });
+        }
+        return Future<std::vector<T>>(state);
+    }
+
+private:
+    void OnInput(size_t i, Result<T>& result)
+    {
+        // 第一个异常立即交出去，之后完成的输入只计数
+        if (result.error)
+        {
+            if (!_failed.exchange(true, std::memory_order_acq_rel)) this->SetError(result.error);
+        }
+        else
+        {
+            _values[i] = std::move(*result.value);
+        }
+        if (_remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        auto self = std::move(_self);
+        if (!_failed.load(std::memory_order_acquire)) this->SetValue(std::move(_values));
+    }
+
+    std::atomic<size_t> _remaining;
+    std::atomic<bool> _failed{false};
+    // 不直接写 _result：出错时结果已经交出去，其余输入还在往这里写
+    std::vector<T> _values;
+    std::shared_ptr<WhenAllState> _self;
+};
+
+// 第一个成功的输入决定结果；全部失败时交出最后一个异常
+template<typename T>
+class WhenAnyState : public SharedState<std::pair<size_t, T>>
+{
+public:
+    explicit WhenAnyState(size_t n) : _remaining(n) {}
+
+    static Future<std::pair<size_t, T>> Start(std::vector<Future<T>>& inputs)
+    {
+        if (inputs.empty()) {
+            throw std::invalid_argument("WhenAny needs at least one future");
+        }
+        auto state = std::make_shared<WhenAnyState>(inputs.size());
+        state->_self = state;
+        WhenAnyState* raw = state.get();
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            std::move(inputs[i]).Subscribe([raw, i](Result<T>& result) { raw->OnInput(i, result); });
+        }
+        return Future<std::pair<size_t, T>>(state);
+    }
+
+private:
+    void OnInput(size_t i, Result<T>& result)
+    {
+        bool last = _remaining.fetch_sub(1, std::memory_order_acq_rel) == 1;
+        std::shared_ptr<WhenAnyState> self;
+        if (last) self = std::move(_self);
+        if (!result.error)
+        {
+            if (!_done.exchange(true, std::memory_order_acq_rel)) this->SetValue({i, std::move(*result.value)});
+        }
+        else if (last && !_done.exchange(true, std::memory_order_acq_rel))
+        {
+            this->SetError(result.error);
+        }
+    }
+
+    std::atomic<size_t> _remaining;
+    std::atomic<bool> _done{false};
+    std::shared_ptr<WhenAnyState> _self;
+};
+}
+
+// 全部完成后得到按输入顺序排列的结果；任何一个失败则得到第一个异常。T 需要能默认构造
+template<typename T>
+Future<std::vector<T>> WhenAll(std::vector<Future<T>> inputs)
+{
+    return future_detail::WhenAllState<T>::Start(inputs);
+}
+
+// 第一个成功完成的输入：返回它的下标和值
+template<typename T>
+Future<std::pair<size_t, T>> WhenAny(std::vector<Future<T>> inputs)
+{
+    return future_detail::WhenAnyState<T>::Start(inputs);
+}
@@ -0,0 +1,170 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include "GroupCommit.h"
+
+using namespace std;
+
+// 存档系统的写入模式：threads 个线程每帧各写一批小记录（追加到 4 个存档文件之一），帧末等这一批写完
+//   per-call:          现在的 async_write_file，每次写起一个线程、开一个 ofstream（去掉了模拟延迟的 sleep），不保证落盘
+//   per-call+fdatasync: 同上，但每次写完都 fdatasync，每次写入都能落盘
+//   group commit:      GroupCommitWriter，window 为凑批窗口
+// 统计每秒写入次数和每秒 fsync 次数，最后检查文件总长度
+//
+// 编译：g++ -std=c++17 -O2 -pthread GroupCommit.cpp
+// 运行：./a.out [dir] [threads] [frames] [writes_per_frame] [record_bytes]
+
+namespace fs = std::filesystem;
+
+struct Config
+{
+    fs::path dir;
+    int threads;
+    int frames;
+    int writes_per_frame;
+    size_t record_bytes;
+    int files = 4;
+};
+
+string SavePath(const Config& config, int i)
+{
+    return (config.dir / ("save" + to_string(i) + ".dat")).string();
+}
+
+void ResetFiles(const Config& config)
+{
+    for (int i = 0; i < config.files; ++i) fs::remove(SavePath(config, i));
+}
+
+uint64_t TotalSize(const Config& config)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < config.files; ++i)
+    {
+        if (fs::exists(SavePath(config, i))) total += fs::file_size(SavePath(config, i));
+    }
+    return total;
+}
+
+// 现在的做法：每次调用一个线程
+void PerCallWrite(const string& filename, const string& content, bool durable, Latch& done, atomic<long>& fsyncs)
+{
+    thread t([filename, content, durable, &done, &fsyncs]()
+    {
+        if (durable)
+        {
+            int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if (fd >= 0)
+            {
+                ssize_t n = write(fd, content.data(), content.size());
+                if (n == ssize_t(content.size()) && fdatasync(fd) == 0) fsyncs.fetch_add(1);
+                close(fd);
+            }
+        }
+        else
+        {
+            ofstream ofs(filename, ios::app | ios::binary);
+            ofs << content;
+        }
+        done.CountDown();
+    });
+    t.detach();
+}
+
+struct RunResult
+{
+    double seconds;
+    long writes;
+    long fsyncs;
+    uint64_t bytes;
+};
+
+RunResult RunPerCall(const Config& config, bool durable)
+{
+    ResetFiles(config);
+    atomic<long> fsyncs{0};
+    string record(config.record_bytes, 'x');
+    auto start = chrono::steady_clock::now();
+    vector<thread> systems;
+    for (int t = 0; t < config.threads; ++t)
+    {
+        systems.emplace_back([&, t]() {
+            for (int f = 0; f < config.frames; ++f)
+            {
+                Latch frame(config.writes_per_frame);
+                for (int w = 0; w < config.writes_per_frame; ++w)
+                {
+                    PerCallWrite(SavePath(config, (t + w) % config.files), record, durable, frame, fsyncs);
+                }
+                frame.Wait();
+            }
+        });
+    }
+    for (auto& s : systems) s.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return RunResult{seconds, long(config.threads) * config.frames * config.writes_per_frame, fsyncs.load(), TotalSize(config)};
+}
+
+RunResult RunGroupCommit(const Config& config, chrono::microseconds window)
+{
+    ResetFiles(config);
+    string record(config.record_bytes, 'x');
+    GroupCommitWriter::Options options;
+    options.window = window;
+    GroupCommitWriter writer(options);
+    auto start = chrono::steady_clock::now();
+    vector<thread> systems;
+    for (int t = 0; t < config.threads; ++t)
+    {
+        systems.emplace_back([&, t]() {
+            for (int f = 0; f < config.frames; ++f)
+            {
+                vector<Future<Unit>> writes;
+                for (int w = 0; w < config.writes_per_frame; ++w)
+                {
+                    writes.push_back(writer.Append(SavePath(config, (t + w) % config.files), record));
+                }
+                WhenAll(move(writes)).Get();
+            }
+        });
+    }
+    for (auto& s : systems) s.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    auto stats = writer.GetStats();
+    return RunResult{seconds, long(stats.writes), long(stats.fsyncs), TotalSize(config)};
+}
+
+void Print(const string& name, const Config& config, const RunResult& r)
+{
+    uint64_t expected = uint64_t(config.threads) * config.frames * config.writes_per_frame * config.record_bytes;
+    cout << "  " << left << setw(22) << name << right << fixed << setprecision(0)
+         << setw(10) << r.writes / r.seconds << " writes/s"
+         << setw(10) << r.fsyncs / r.seconds << " fsyncs/s"
+         << setprecision(1) << setw(9) << r.seconds * 1000 << " ms"
+         << (r.bytes == expected ? "" : "   SIZE MISMATCH") << endl;
+    cout.unsetf(ios::fixed);
+}
+
+int main(int argc, char** argv)
+{
+    Config config;
+    config.dir = fs::path(argc > 1 ? argv[1] : ".") / "group_commit_bench";
+    config.threads = argc > 2 ? atoi(argv[2]) : 8;
+    config.frames = argc > 3 ? atoi(argv[3]) : 20;
+    config.writes_per_frame = argc > 4 ? atoi(argv[4]) : 16;
+    config.record_bytes = argc > 5 ? size_t(atol(argv[5])) : 128;
+    fs::create_directories(config.dir);
+
+    cout << config.threads << " threads x " << config.frames << " frames x " << config.writes_per_frame
+         << " writes of " << config.record_bytes << " bytes into " << config.files << " files:" << endl;
+    Print("per-call", config, RunPerCall(config, false));
+    Print("per-call+fdatasync", config, RunPerCall(config, true));
+    Print("group commit 0us", config, RunGroupCommit(config, chrono::microseconds(0)));
+    Print("group commit 1000us", config, RunGroupCommit(config, chrono::microseconds(1000)));
+
+    fs::remove_all(config.dir);
+    return 0;
+}
@@ -0,0 +1,440 @@
+#pragma once
+
+// 组提交写引擎：代替"每次写文件起一个线程、开一个 ofstream"
+//   - 所有写请求进同一个队列，由一个写线程成批处理
+//   - 同一个文件在一批里的写入按提交顺序排好偏移，首尾相接的合并成一次 pwritev
+//   - 每批每个文件只做一次 fdatasync；全部文件落盘后，这一批的 Future 一起完成
+//   - Replace 写到临时文件、fdatasync 后改名，目录的 fsync 同样按批合并；崩溃时只会看到旧内容或新内容，
+//     不会留下清空或写了一半的存档。Append / WriteAt 原地写
+//   - 写线程正在 fdatasync 时到达的请求自然攒成下一批；也可以设置 window，第一个请求到达后再等一会儿凑批
+//
+// Future 的续体默认在写线程上执行，续体里有重活时用 Then(pool, f) 交给线程池，不要拖住写线程
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Future.h"
+
+class GroupCommitWriter
+{
+public:
+    struct Options
+    {
+        // 第一个请求到达后最多再等多久凑批。默认不等：上一批 fdatasync 期间到达的请求已经自然成批，
+        // 提交方每帧都要等结果时，额外的等待只会拉长每一帧（见 GroupCommit.cpp 的对比）
+        std::chrono::microseconds window{0};
+        // 攒够这么多字节就不再等窗口
+        size_t max_batch_bytes = 4 << 20;
+        // 缓存的文件描述符上限，超过后全部关闭重开
+        size_t max_open_files = 64;
+    };
+
+    struct Stats
+    {
+        uint64_t writes = 0;
+        uint64_t batches = 0;
+        uint64_t pwritev_calls = 0;
+        uint64_t fsyncs = 0;
+        uint64_t bytes = 0;
+    };
+
+    GroupCommitWriter() : GroupCommitWriter(Options()) {}
+
+    explicit GroupCommitWriter(Options options) : _options(options)
+    {
+        _thread = std::thread([this]() { Run(); });
+    }
+
+    // 析构前已提交的写入都会完成
+    ~GroupCommitWriter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _stop = true;
+        }
+        _cv.notify_one();
+        _thread.join();
+        for (auto& entry : _files) close(entry.second.fd);
+    }
+
+    GroupCommitWriter(const GroupCommitWriter&) = delete;
+    GroupCommitWriter& operator=(const GroupCommitWriter&) = delete;
+
+    // 追加到文件末尾（按本引擎看到的提交顺序）
+    Future<Unit> Append(std::string path, std::string data)
+    {
+        return Enqueue(Request{std::move(path), Kind::kAppend, 0, std::move(data), Promise<Unit>()});
+    }
+
+    Future<Unit> WriteAt(std::string path, uint64_t offset, std::string data)
+    {
+        return Enqueue(Request{std::move(path), Kind::kAt, offset, std::move(data), Promise<Unit>()});
+    }
+
+    // 用 data 替换整个文件：写临时文件再改名，原子地替换；同一批里排在它前面的写入会被直接丢弃，
+    // 排在它后面的 Append / WriteAt 一起写进临时文件
+    Future<Unit> Replace(std::string path, std::string data)
+    {
+        return Enqueue(Request{std::move(path), Kind::kReplace, 0, std::move(data), Promise<Unit>()});
+    }
+
+    Stats GetStats() const
+    {
+        Stats stats;
+        stats.writes = _writes.load(std::memory_order_relaxed);
+        stats.batches = _batches.load(std::memory_order_relaxed);
+        stats.pwritev_calls = _pwritev_calls.load(std::memory_order_relaxed);
+        stats.fsyncs = _fsyncs.load(std::memory_order_relaxed);
+        stats.bytes = _bytes.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    enum class Kind { kAppend, kAt, kReplace };
+
+    struct Request
+    {
+        std::string path;
+        Kind kind;
+        uint64_t offset;
+        std::string data;
+        Promise<Unit> promise;
+    };
+
+    struct OpenFile
+    {
+        int fd;
+        uint64_t size;
+        bool created;
+    };
+
+    Future<Unit> Enqueue(Request&& request)
+    {
+        Future<Unit> future = request.promise.GetFuture();
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            if (_stop) {
+                throw std::runtime_error("GroupCommitWriter is shutting down");
+            }
+            _queued_bytes += request.data.size();
+            _queue.push_back(std::move(request));
+            // 写线程在空等或在凑批窗口里：只在队列从空变非空、或攒够字节时叫醒它
+            wake = _queue.size() == 1 || _queued_bytes >= _options.max_batch_bytes;
+        }
+        if (wake) _cv.notify_one();
+        return future;
+    }
+
+    void Run()
+    {
+        while (true)
+        {
+            std::vector<Request> batch;
+            {
+                std::unique_lock<std::mutex> lock(_mtx);
+                _cv.wait(lock, [this]() { return !_queue.empty() || _stop; });
+                if (_queue.empty()) return;
+                if (!_stop && _options.window.count() > 0)
+                {
+                    _cv.wait_for(lock, _options.window, [this]() {
+                        return _stop || _queued_bytes >= _options.max_batch_bytes;
+                    });
+                }
+                batch.swap(_queue);
+                _queued_bytes = 0;
+            }
+            Commit(batch);
+        }
+    }
+
+    void Commit(std::vector<Request>& batch)
+    {
+        // 按文件分组，组内保持提交顺序
+        std::unordered_map<std::string, std::vector<Request*>> by_file;
+        std::vector<const std::string*> order;
+        for (auto& request : batch)
+        {
+            auto& group = by_file[request.path];
+            if (group.empty()) order.push_back(&request.path);
+            group.push_back(&request);
+        }
+
+        // 新建或改名替换的文件还要让目录项落盘：同一目录在一批里只 fsync 一次
+        std::vector<std::vector<Request*>*> durable;
+        std::unordered_map<std::string, std::vector<std::vector<Request*>*>> new_entries;
+        for (const std::string* path : order)
+        {
+            auto& group = by_file[*path];
+            try
+            {
+                if (CommitFile(*path, group)) new_entries[ParentDir(*path)].push_back(&group);
+                else durable.push_back(&group);
+            }
+            catch (...)
+            {
+                Fail(group, std::current_exception());
+            }
+        }
+        for (auto& entry : new_entries)
+        {
+            try
+            {
+                SyncDir(entry.first);
+                durable.insert(durable.end(), entry.second.begin(), entry.second.end());
+            }
+            catch (...)
+            {
+                for (auto* group : entry.second) Fail(*group, std::current_exception());
+            }
+        }
+        _writes.fetch_add(batch.size(), std::memory_order_relaxed);
+        _batches.fetch_add(1, std::memory_order_relaxed);
+        // 这一批全部落盘后再一起通知
+        for (auto* group : durable)
+        {
+            for (Request* request : *group) request->promise.SetValue(Unit{});
+        }
+    }
+
+    static void Fail(std::vector<Request*>& group, std::exception_ptr error)
+    {
+        for (Request* request : group) request->promise.SetException(error);
+    }
+
+    struct Segment
+    {
+        uint64_t offset;
+        const std::string* data;
+    };
+
+    // 写入并 fdatasync 一个文件；返回 true 表示目录项有变化（新建或改名替换），目录还没有 fsync
+    bool CommitFile(const std::string& path, const std::vector<Request*>& requests)
+    {
+        // 只有最后一个 Replace 和它之后的写入有效
+        size_t first = 0;
+        bool replace = false;
+        for (size_t i = 0; i < requests.size(); ++i)
+        {
+            if (requests[i]->kind == Kind::kReplace)
+            {
+                first = i;
+                replace = true;
+            }
+        }
+        if (replace) return ReplaceFile(path, requests, first);
+
+        OpenFile& file = Open(path);
+        uint64_t size = file.size;
+        std::vector<Segment> segments = BuildSegments(requests, 0, size);
+        try
+        {
+            WriteSegments(file.fd, segments, path);
+        }
+        catch (...)
+        {
+            // 出错后文件大小不可信，下次重新打开
+            close(file.fd);
+            _files.erase(path);
+            throw;
+        }
+        file.size = size;
+        bool created = file.created;
+        file.created = false;
+        return created;
+    }
+
+    // 新内容写进 path.tmp，落盘后改名覆盖 path；改名换了 inode，缓存的描述符随之作废
+    bool ReplaceFile(const std::string& path, const std::vector<Request*>& requests, size_t first)
+    {
+        auto cached = _files.find(path);
+        if (cached != _files.end())
+        {
+            close(cached->second.fd);
+            _files.erase(cached);
+        }
+        std::string tmp = path + ".tmp";
+        int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) ThrowErrno("open " + tmp);
+        uint64_t size = 0;
+        std::vector<Segment> segments = BuildSegments(requests, first, size);
+        try
+        {
+            WriteSegments(fd, segments, tmp);
+        }
+        catch (...)
+        {
+            close(fd);
+            unlink(tmp.c_str());
+            throw;
+        }
+        close(fd);
+        if (rename(tmp.c_str(), path.c_str()) != 0)
+        {
+            int err = errno;
+            unlink(tmp.c_str());
+            throw std::system_error(err, std::generic_category(), "rename " + tmp);
+        }
+        return true;
+    }
+
+    // requests[first..] 按提交顺序排好偏移，size 是文件当前大小，返回时更新为写完后的大小
+    static std::vector<Segment> BuildSegments(const std::vector<Request*>& requests, size_t first, uint64_t& size)
+    {
+        std::vector<Segment> segments;
+        for (size_t i = first; i < requests.size(); ++i)
+        {
+            Request* request = requests[i];
+            switch (request->kind)
+            {
+            case Kind::kReplace:
+                segments.push_back(Segment{0, &request->data});
+                size = request->data.size();
+                break;
+            case Kind::kAppend:
+                segments.push_back(Segment{size, &request->data});
+                size += request->data.size();
+                break;
+            case Kind::kAt:
+                segments.push_back(Segment{request->offset, &request->data});
+                size = std::max<uint64_t>(size, request->offset + request->data.size());
+                break;
+            }
+        }
+        return segments;
+    }
+
+    void WriteSegments(int fd, const std::vector<Segment>& segments, const std::string& path)
+    {
+        // 首尾相接的段合并成一次 pwritev；不连续或重叠的段按提交顺序分开写，后写的覆盖先写的
+        std::vector<iovec> iov;
+        for (size_t i = 0; i < segments.size();)
+        {
+            uint64_t start = segments[i].offset;
+            uint64_t end = start;
+            iov.clear();
+            while (i < segments.size() && segments[i].offset == end && iov.size() < IOV_MAX)
+            {
+                iov.push_back(iovec{const_cast<char*>(segments[i].data->data()), segments[i].data->size()});
+                end += segments[i].data->size();
+                ++i;
+            }
+            PwritevAll(fd, iov, start, path);
+            _bytes.fetch_add(end - start, std::memory_order_relaxed);
+        }
+        if (fdatasync(fd) != 0) ThrowErrno("fdatasync " + path);
+        _fsyncs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    OpenFile& Open(const std::string& path)
+    {
+        auto it = _files.find(path);
+        if (it != _files.end()) return it->second;
+        if (_files.size() >= _options.max_open_files)
+        {
+            for (auto& entry : _files) close(entry.second.fd);
+            _files.clear();
+        }
+        bool created = true;
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd < 0 && errno == EEXIST)
+        {
+            created = false;
+            fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+        }
+        if (fd < 0) ThrowErrno("open " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            int err = errno;
+            close(fd);
+            throw std::system_error(err, std::generic_category(), "fstat " + path);
+        }
+        return _files.emplace(path, OpenFile{fd, uint64_t(st.st_size), created}).first->second;
+    }
+
+    void PwritevAll(int fd, std::vector<iovec>& iov, uint64_t offset, const std::string& path)
+    {
+        iovec* cur = iov.data();
+        int count = int(iov.size());
+        while (count > 0)
+        {
+            ssize_t n = pwritev(fd, cur, count, off_t(offset));
+            _pwritev_calls.fetch_add(1, std::memory_order_relaxed);
+            if (n < 0)
+            {
+                if (errno == EINTR) continue;
+                ThrowErrno("pwritev " + path);
+            }
+            offset += uint64_t(n);
+            // 部分写入：跳过已经写完的 iovec，调整写了一半的那个
+            while (count > 0 && size_t(n) >= cur->iov_len)
+            {
+                n -= ssize_t(cur->iov_len);
+                ++cur;
+                --count;
+            }
+            if (count > 0)
+            {
+                cur->iov_base = static_cast<char*>(cur->iov_base) + n;
+                cur->iov_len -= size_t(n);
+            }
+        }
+    }
+
+    static std::string ParentDir(const std::string& path)
+    {
+        size_t slash = path.find_last_of('/');
+        if (slash == std::string::npos) return ".";
+        return slash == 0 ? "/" : path.substr(0, slash);
+    }
+
+    void SyncDir(const std::string& dir)
+    {
+        int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) ThrowErrno("open " + dir);
+        int rc = fsync(fd);
+        int err = errno;
+        close(fd);
+        if (rc != 0) throw std::system_error(err, std::generic_category(), "fsync " + dir);
+        _fsyncs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    [[noreturn]] static void ThrowErrno(const std::string& what)
+    {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    Options _options;
+    std::mutex _mtx;
+    std::condition_variable _cv;
+    std::vector<Request> _queue;
+    size_t _queued_bytes = 0;
+    bool _stop = false;
+
+    // 只有写线程访问
+    std::unordered_map<std::string, OpenFile> _files;
+
+    std::atomic<uint64_t> _writes{0};
+    std::atomic<uint64_t> _batches{0};
+    std::atomic<uint64_t> _pwritev_calls{0};
+    std::atomic<uint64_t> _fsyncs{0};
+    std::atomic<uint64_t> _bytes{0};
+
+    std::thread _thread;
+};
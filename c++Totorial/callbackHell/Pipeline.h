@@ -0,0 +1,422 @@
+#pragma once
+
+// SEDA 风格的三段流水线：读取 -> 变换 -> 写出
+//   - 每段有自己的线程数：读写段按 IO 并发度配置，变换段按核数配置
+//   - 段与段之间是有界队列，下游处理不过来时上游在 Push 上阻塞（背压），内存占用有上限
+//   - ordered 模式下写出段按输入顺序写：乱序到达的结果先放进重排缓冲，
+//     同时用在途票据限制"已读入但还没写出"的条目数，重排缓冲也不会无限增长
+//   - 单个条目出错只记录错误，不影响其他条目；有序模式下出错的条目照样占一个序号
+//   - 结束后报告每段的吞吐、忙碌比例和每个队列的平均/最大占用
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct QueueStats
+{
+    size_t capacity = 0;
+    size_t max_size = 0;
+    double avg_size = 0;
+    uint64_t full_waits = 0;   // Push 因为队列满而等待的次数（背压）
+    uint64_t empty_waits = 0;  // Pop 因为队列空而等待的次数（下游饥饿）
+};
+
+// 有界阻塞队列，顺带统计占用情况
+template<typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity) : _capacity(capacity)
+    {
+        if (capacity == 0) {
+            throw std::invalid_argument("Queue capacity must be positive");
+        }
+    }
+
+    // 队列已关闭时返回 false
+    bool Push(T item)
+    {
+        std::unique_lock<std::mutex> lock(_mtx);
+        if (_items.size() >= _capacity && !_closed)
+        {
+            ++_full_waits;
+            ++_push_waiters;
+            _not_full.wait(lock, [this]() { return _items.size() < _capacity || _closed; });
+            --_push_waiters;
+        }
+        if (_closed) return false;
+        _items.push_back(std::move(item));
+        Sample();
+        bool wake = _pop_waiters > 0;
+        lock.unlock();
+        if (wake) _not_empty.notify_one();
+        return true;
+    }
+
+    // 队列关闭且取空后返回 nullopt
+    std::optional<T> Pop()
+    {
+        std::unique_lock<std::mutex> lock(_mtx);
+        if (_items.empty() && !_closed)
+        {
+            ++_empty_waits;
+            ++_pop_waiters;
+            _not_empty.wait(lock, [this]() { return !_items.empty() || _closed; });
+            --_pop_waiters;
+        }
+        if (_items.empty()) return std::nullopt;
+        T item = std::move(_items.front());
+        _items.pop_front();
+        Sample();
+        // 满队列上阻塞的生产者等队列退到一半再一起唤醒，而不是每取一个就唤醒一个，
+        // 核少时能省掉大量一进一出的线程切换
+        bool wake = _push_waiters > 0 && _items.size() <= _capacity / 2;
+        lock.unlock();
+        if (wake) _not_full.notify_all();
+        return item;
+    }
+
+    // 不再接受新条目，已有的条目仍然可以取出
+    void Close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _closed = true;
+        }
+        _not_full.notify_all();
+        _not_empty.notify_all();
+    }
+
+    QueueStats GetStats()
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        QueueStats stats;
+        stats.capacity = _capacity;
+        stats.max_size = _max_size;
+        stats.avg_size = _samples ? double(_size_sum) / _samples : 0;
+        stats.full_waits = _full_waits;
+        stats.empty_waits = _empty_waits;
+        return stats;
+    }
+
+private:
+    // 每次进出队时采样一次长度
+    void Sample()
+    {
+        _max_size = std::max(_max_size, _items.size());
+        _size_sum += _items.size();
+        ++_samples;
+    }
+
+    size_t _capacity;
+    std::mutex _mtx;
+    std::condition_variable _not_full;
+    std::condition_variable _not_empty;
+    std::deque<T> _items;
+    bool _closed = false;
+    size_t _max_size = 0;
+    uint64_t _size_sum = 0;
+    uint64_t _samples = 0;
+    uint64_t _full_waits = 0;
+    uint64_t _empty_waits = 0;
+    int _push_waiters = 0;
+    int _pop_waiters = 0;
+};
+
+struct PipelineOptions
+{
+    int read_threads = 4;
+    int transform_threads = int(std::max(1u, std::thread::hardware_concurrency()));
+    int write_threads = 2;
+    size_t queue_capacity = 64;
+    bool ordered = false;
+    // 有序模式下同时在途（已读入、未写出）的最大条目数
+    size_t max_in_flight = 256;
+};
+
+struct StageReport
+{
+    std::string name;
+    int threads = 0;
+    uint64_t items = 0;
+    uint64_t errors = 0;
+    double busy_seconds = 0;
+};
+
+struct PipelineReport
+{
+    double seconds = 0;
+    uint64_t inputs = 0;
+    uint64_t failed = 0;
+    std::vector<std::string> first_errors;
+    StageReport stages[3];
+    QueueStats queues[2];
+    size_t max_reorder = 0;
+
+    void Print(std::ostream& os) const
+    {
+        os << inputs << " items in " << std::fixed << std::setprecision(2) << seconds << " s ("
+           << std::setprecision(0) << inputs / std::max(seconds, 1e-9) << " items/s), " << failed << " failed" << std::endl;
+        for (auto& stage : stages)
+        {
+            os << "  " << std::left << std::setw(10) << stage.name << std::right << std::setw(3) << stage.threads << " threads"
+               << std::setw(10) << stage.items / std::max(seconds, 1e-9) << " items/s"
+               << "   busy " << std::setw(3) << 100 * stage.busy_seconds / std::max(seconds * stage.threads, 1e-9) << "%"
+               << (stage.errors ? "   errors " + std::to_string(stage.errors) : "") << std::endl;
+        }
+        const char* names[2] = {"read->transform", "transform->write"};
+        for (int i = 0; i < 2; ++i)
+        {
+            os << "  queue " << std::left << std::setw(17) << names[i] << std::right << std::setprecision(1)
+               << " avg " << std::setw(5) << queues[i].avg_size << " / " << queues[i].capacity
+               << "   max " << std::setw(4) << queues[i].max_size
+               << "   full waits " << std::setw(6) << queues[i].full_waits
+               << "   empty waits " << std::setw(6) << queues[i].empty_waits << std::endl;
+        }
+        if (max_reorder) os << "  reorder buffer max " << max_reorder << std::endl;
+        for (auto& error : first_errors) os << "  error: " << error << std::endl;
+        os.unsetf(std::ios::fixed);
+    }
+};
+
+// Source：输入描述（例如文件路径）；Loaded：读取段的产物；Result：变换段的产物
+template<typename Source, typename Loaded, typename Result>
+class StagedPipeline
+{
+public:
+    using ReadFunc = std::function<Loaded(const Source&)>;
+    using TransformFunc = std::function<Result(const Source&, Loaded&&)>;
+    using WriteFunc = std::function<void(const Source&, Result&&)>;
+
+    StagedPipeline(ReadFunc read, TransformFunc transform, WriteFunc write, PipelineOptions options = PipelineOptions())
+        : _read(std::move(read)), _transform(std::move(transform)), _write(std::move(write)), _options(options)
+    {
+        if (_options.read_threads <= 0 || _options.transform_threads <= 0 || _options.write_threads <= 0) {
+            throw std::invalid_argument("Every pipeline stage needs at least one thread");
+        }
+        // 有序写出只能由一个线程按序号推进
+        if (_options.ordered) _options.write_threads = 1;
+    }
+
+    // 处理全部输入，返回报告；一个 StagedPipeline 可以反复 Run
+    PipelineReport Run(const std::vector<Source>& inputs)
+    {
+        Reset();
+        BoundedQueue<Item<Loaded>> loaded(_options.queue_capacity);
+        BoundedQueue<Item<Result>> results(_options.queue_capacity);
+        auto start = std::chrono::steady_clock::now();
+
+        std::atomic<size_t> next_input{0};
+        std::vector<std::thread> readers, transformers, writers;
+        std::atomic<int> readers_left{_options.read_threads};
+        std::atomic<int> transformers_left{_options.transform_threads};
+
+        for (int i = 0; i < _options.read_threads; ++i)
+        {
+            readers.emplace_back([&]() {
+                while (true)
+                {
+                    size_t seq = next_input.fetch_add(1);
+                    if (seq >= inputs.size()) break;
+                    AcquireTicket(seq);
+                    Item<Loaded> item{seq, &inputs[seq], std::nullopt, nullptr};
+                    RunStage(kRead, item, [&]() { item.value.emplace(_read(inputs[seq])); });
+                    loaded.Push(std::move(item));
+                }
+                if (readers_left.fetch_sub(1) == 1) loaded.Close();
+            });
+        }
+        for (int i = 0; i < _options.transform_threads; ++i)
+        {
+            transformers.emplace_back([&]() {
+                while (auto in = loaded.Pop())
+                {
+                    Item<Result> out{in->seq, in->source, std::nullopt, in->error};
+                    if (!out.error)
+                    {
+                        RunStage(kTransform, out, [&]() { out.value.emplace(_transform(*in->source, std::move(*in->value))); });
+                    }
+                    results.Push(std::move(out));
+                }
+                if (transformers_left.fetch_sub(1) == 1) results.Close();
+            });
+        }
+        for (int i = 0; i < _options.write_threads; ++i)
+        {
+            writers.emplace_back([&]() {
+                if (_options.ordered) WriteOrdered(results);
+                else
+                {
+                    while (auto item = results.Pop()) Finish(*item);
+                }
+            });
+        }
+        for (auto& t : readers) t.join();
+        for (auto& t : transformers) t.join();
+        for (auto& t : writers) t.join();
+
+        PipelineReport report;
+        report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        report.inputs = inputs.size();
+        report.failed = _failed;
+        report.first_errors = _first_errors;
+        const char* names[3] = {"read", "transform", "write"};
+        int threads[3] = {_options.read_threads, _options.transform_threads, _options.write_threads};
+        for (int i = 0; i < 3; ++i)
+        {
+            report.stages[i].name = names[i];
+            report.stages[i].threads = threads[i];
+            report.stages[i].items = _stage[i].items.load();
+            report.stages[i].errors = _stage[i].errors.load();
+            report.stages[i].busy_seconds = _stage[i].busy_ns.load() / 1e9;
+        }
+        report.queues[0] = loaded.GetStats();
+        report.queues[1] = results.GetStats();
+        report.max_reorder = _max_reorder;
+        return report;
+    }
+
+private:
+    enum { kRead, kTransform, kWrite };
+
+    template<typename T>
+    struct Item
+    {
+        size_t seq;
+        const Source* source;
+        std::optional<T> value;
+        std::exception_ptr error;
+    };
+
+    struct StageCounters
+    {
+        std::atomic<uint64_t> items{0};
+        std::atomic<uint64_t> errors{0};
+        std::atomic<int64_t> busy_ns{0};
+    };
+
+    void Reset()
+    {
+        for (auto& stage : _stage)
+        {
+            stage.items = 0;
+            stage.errors = 0;
+            stage.busy_ns = 0;
+        }
+        _failed = 0;
+        _first_errors.clear();
+        _next_to_write = 0;
+        _max_reorder = 0;
+    }
+
+    // 执行一段的工作，计时；异常记在条目上，由写出段统一计入失败
+    template<typename T, typename F>
+    void RunStage(int stage, Item<T>& item, F&& work)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        try
+        {
+            work();
+        }
+        catch (...)
+        {
+            item.error = std::current_exception();
+            _stage[stage].errors.fetch_add(1, std::memory_order_relaxed);
+        }
+        _stage[stage].busy_ns.fetch_add(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count(),
+            std::memory_order_relaxed);
+        _stage[stage].items.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 有序模式：序号超出 已写出 + max_in_flight 的条目先不读，等写出段追上来
+    void AcquireTicket(size_t seq)
+    {
+        if (!_options.ordered) return;
+        std::unique_lock<std::mutex> lock(_ticket_mtx);
+        _ticket_cv.wait(lock, [&]() { return seq < _next_to_write + _options.max_in_flight; });
+    }
+
+    void WriteOrdered(BoundedQueue<Item<Result>>& results)
+    {
+        std::map<size_t, Item<Result>> pending;
+        size_t next = 0;
+        while (auto item = results.Pop())
+        {
+            pending.emplace(item->seq, std::move(*item));
+            _max_reorder = std::max(_max_reorder, pending.size());
+            bool advanced = false;
+            for (auto it = pending.begin(); it != pending.end() && it->first == next; it = pending.erase(it))
+            {
+                Finish(it->second);
+                ++next;
+                advanced = true;
+            }
+            if (advanced)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(_ticket_mtx);
+                    _next_to_write = next;
+                }
+                _ticket_cv.notify_all();
+            }
+        }
+    }
+
+    void Finish(Item<Result>& item)
+    {
+        if (!item.error)
+        {
+            RunStage(kWrite, item, [&]() { _write(*item.source, std::move(*item.value)); });
+        }
+        if (item.error)
+        {
+            std::lock_guard<std::mutex> lock(_error_mtx);
+            ++_failed;
+            if (_first_errors.size() < 5)
+            {
+                try
+                {
+                    std::rethrow_exception(item.error);
+                }
+                catch (const std::exception& e)
+                {
+                    _first_errors.push_back(e.what());
+                }
+                catch (...)
+                {
+                    _first_errors.push_back("unknown error");
+                }
+            }
+        }
+    }
+
+    ReadFunc _read;
+    TransformFunc _transform;
+    WriteFunc _write;
+    PipelineOptions _options;
+
+    StageCounters _stage[3];
+    std::mutex _error_mtx;
+    uint64_t _failed = 0;
+    std::vector<std::string> _first_errors;
+
+    std::mutex _ticket_mtx;
+    std::condition_variable _ticket_cv;
+    size_t _next_to_write = 0;
+    size_t _max_reorder = 0;
+};
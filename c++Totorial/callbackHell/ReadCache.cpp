@@ -0,0 +1,168 @@
+#define DAG_THREAD_POOL_NO_MAIN
+#include "../threadPool/DAGThreadPool.cpp"
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include "ReadCache.h"
+
+// 1. 吞吐：threads 个线程反复读同一批配置文件（64 个 4KB 文件、8 个 256KB 资源文件），每次读完才读下一个
+//      per-call:   现在的 async_read_file，每次起一个线程、整读成新字符串（去掉了模拟延迟的 sleep）
+//      pool:       线程池上读，不缓存
+//      cache:      ReadCache，命中时只有一次 stat
+// 2. 合并：16 个并发读者同时读一个冷的 8MB 文件，只应加载一次
+// 3. 失效：用"写临时文件再 rename"替换文件，关掉命中时的 stat 校验，只靠 inotify 也能读到新内容
+//
+// 编译：g++ -std=c++17 -O2 -pthread ReadCache.cpp
+// 运行：./a.out [dir] [threads] [reads_per_thread]
+
+namespace fs = std::filesystem;
+
+void WriteFile(const fs::path& path, size_t bytes, char fill)
+{
+    ofstream(path, ios::binary) << string(bytes, fill);
+}
+
+vector<string> MakeFiles(const fs::path& dir)
+{
+    vector<string> files;
+    for (int i = 0; i < 64; ++i)
+    {
+        fs::path path = dir / ("config" + to_string(i) + ".ini");
+        WriteFile(path, 4096, 'a' + i % 26);
+        files.push_back(path.string());
+    }
+    for (int i = 0; i < 8; ++i)
+    {
+        fs::path path = dir / ("asset" + to_string(i) + ".bin");
+        WriteFile(path, 256 * 1024, 'A' + i);
+        files.push_back(path.string());
+    }
+    return files;
+}
+
+// 现在的做法
+void PerCallRead(const string& filename, function<void(const string&)> callback)
+{
+    thread t([filename, callback]()
+    {
+        ifstream file(filename);
+        string content((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+        callback(content);
+    });
+    t.detach();
+}
+
+template<typename ReadOne>
+double ReadsPerSec(const vector<string>& files, int threads, int reads, ReadOne read_one, size_t& bytes)
+{
+    atomic<size_t> total{0};
+    auto start = chrono::steady_clock::now();
+    vector<thread> readers;
+    for (int t = 0; t < threads; ++t)
+    {
+        readers.emplace_back([&, t]() {
+            mt19937 rng(t);
+            // 配置文件读得多，资源文件读得少
+            uniform_int_distribution<int> pick(0, 99);
+            uniform_int_distribution<int> config(0, 63);
+            uniform_int_distribution<int> asset(64, 71);
+            for (int i = 0; i < reads; ++i)
+            {
+                const string& path = files[pick(rng) < 90 ? config(rng) : asset(rng)];
+                total.fetch_add(read_one(path), memory_order_relaxed);
+            }
+        });
+    }
+    for (auto& r : readers) r.join();
+    bytes = total.load();
+    return double(threads) * reads / chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void BenchThroughput(const vector<string>& files, int threads, int reads)
+{
+    size_t bytes = 0;
+    cout << threads << " threads x " << reads << " reads:" << endl << fixed << setprecision(0);
+
+    double rate = ReadsPerSec(files, threads, reads, [](const string& path) {
+        Promise<size_t> promise;
+        Future<size_t> size = promise.GetFuture();
+        auto shared = make_shared<Promise<size_t>>(move(promise));
+        PerCallRead(path, [shared](const string& content) { shared->SetValue(content.size()); });
+        return move(size).Get();
+    }, bytes);
+    cout << "  per-call " << setw(10) << rate << " reads/s" << endl;
+
+    {
+        ThreadPool pool(4);
+        rate = ReadsPerSec(files, threads, reads, [&pool](const string& path) {
+            return Async(pool, [path]() { return ReadCache::LoadFile(path)->size(); }).Get();
+        }, bytes);
+        cout << "  pool     " << setw(10) << rate << " reads/s" << endl;
+    }
+
+    {
+        ThreadPool pool(4);
+        ReadCache cache;
+        rate = ReadsPerSec(files, threads, reads, [&](const string& path) {
+            return cache.Read(pool, path).Get()->size();
+        }, bytes);
+        auto stats = cache.GetStats();
+        cout << "  cache    " << setw(10) << rate << " reads/s   hits " << stats.hits << "  loads " << stats.misses
+             << "  coalesced " << stats.coalesced << "  cached " << stats.bytes / 1024 << " KB" << endl;
+    }
+    cout.unsetf(ios::fixed);
+}
+
+void testCoalesce(const fs::path& dir)
+{
+    fs::path big = dir / "big.bin";
+    WriteFile(big, 8 << 20, 'z');
+    ThreadPool pool(4);
+    ReadCache cache;
+    vector<Future<ReadCache::Buffer>> reads;
+    for (int i = 0; i < 16; ++i) reads.push_back(cache.Read(pool, big.string()));
+    auto buffers = WhenAll(move(reads)).Get();
+    bool shared = all_of(buffers.begin(), buffers.end(), [&](const ReadCache::Buffer& b) { return b == buffers[0]; });
+    auto stats = cache.GetStats();
+    cout << "coalesce: 16 concurrent reads -> " << stats.misses << " load, " << stats.coalesced << " coalesced, "
+         << (shared ? "one shared buffer" : "DIFFERENT buffers") << endl;
+}
+
+void testInvalidate(const fs::path& dir)
+{
+    fs::path path = dir / "live.cfg";
+    ofstream(path) << "version=1";
+    ThreadPool pool(2);
+    ReadCache::Options options;
+    options.validate_on_hit = false;
+    ReadCache cache(options);
+    string before = *cache.Read(pool, path.string()).Get();
+    // 原子替换：写临时文件再 rename
+    fs::path tmp = dir / "live.cfg.tmp";
+    ofstream(tmp) << "version=2";
+    fs::rename(tmp, path);
+    auto deadline = chrono::steady_clock::now() + chrono::seconds(1);
+    while (cache.GetStats().invalidations == 0 && chrono::steady_clock::now() < deadline)
+    {
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    string after = *cache.Read(pool, path.string()).Get();
+    cout << "invalidate: " << before << " -> " << after << " (inotify invalidations " << cache.GetStats().invalidations << ")" << endl;
+}
+
+int main(int argc, char** argv)
+{
+    fs::path dir = fs::path(argc > 1 ? argv[1] : ".") / "read_cache_bench";
+    int threads = argc > 2 ? atoi(argv[2]) : 8;
+    int reads = argc > 3 ? atoi(argv[3]) : 2000;
+    fs::create_directories(dir);
+
+    auto files = MakeFiles(dir);
+    BenchThroughput(files, threads, reads);
+    testCoalesce(dir);
+    testInvalidate(dir);
+
+    fs::remove_all(dir);
+    return 0;
+}
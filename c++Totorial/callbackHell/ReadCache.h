@@ -0,0 +1,416 @@
+#pragma once
+
+// 文件读取缓存：同一批配置、资源文件被反复读取时，不必每次都起线程、从磁盘整读一遍
+//   - 按路径缓存，总字节数有上限，超出后按 LRU 淘汰；调用方拿到的是共享的只读缓冲，不再复制字符串
+//   - 每条缓存记录文件的 (inode, mtime, size)；命中时 stat 一次比对，文件被替换或修改过就重新读
+//   - 一个 inotify 线程监视缓存文件所在的目录，文件变化时主动失效，不等下次读取
+//   - 同一路径的并发读取合并成一次加载，其余读者挂在这次加载上一起拿结果
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Future.h"
+
+class ReadCache
+{
+public:
+    using Buffer = std::shared_ptr<const std::string>;
+
+    struct Options
+    {
+        size_t capacity_bytes = 64 << 20;
+        // 命中时是否 stat 校验；只依赖 inotify 失效时可以关掉，省一次系统调用
+        bool validate_on_hit = true;
+        bool watch = true;
+    };
+
+    struct Stats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t coalesced = 0;
+        uint64_t stale = 0;
+        uint64_t invalidations = 0;
+        uint64_t evictions = 0;
+        size_t bytes = 0;
+        size_t entries = 0;
+    };
+
+    ReadCache() : ReadCache(Options()) {}
+
+    explicit ReadCache(Options options) : _options(options)
+    {
+        if (!_options.watch) return;
+        // inotify 不可用（例如达到实例数上限）时退化为只靠 stat 校验
+        _inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        _wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (_inotify_fd < 0 || _wake_fd < 0)
+        {
+            CloseWatchFds();
+            _options.validate_on_hit = true;
+            return;
+        }
+        _watcher = std::thread([this]() { Watch(); });
+    }
+
+    ~ReadCache()
+    {
+        if (_watcher.joinable())
+        {
+            uint64_t one = 1;
+            ssize_t n = write(_wake_fd, &one, sizeof(one));
+            (void)n;
+            _watcher.join();
+        }
+        CloseWatchFds();
+    }
+
+    ReadCache(const ReadCache&) = delete;
+    ReadCache& operator=(const ReadCache&) = delete;
+
+    // 读取整个文件；未命中时在 executor 上加载
+    template<typename Executor>
+    Future<Buffer> Read(Executor& executor, const std::string& path)
+    {
+        struct stat st{};
+        bool exists = stat(path.c_str(), &st) == 0;
+        Buffer hit;
+        Promise<Buffer> promise;
+        Future<Buffer> future = promise.GetFuture();
+        std::shared_ptr<InFlight> load;
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            auto it = _entries.find(path);
+            if (it != _entries.end())
+            {
+                Entry& entry = it->second;
+                if ((!_options.validate_on_hit && entry.watched) || (exists && entry.key == Key::From(st)))
+                {
+                    _lru.splice(_lru.begin(), _lru, entry.lru);
+                    ++_stats.hits;
+                    hit = entry.data;
+                }
+                else
+                {
+                    ++_stats.stale;
+                    EraseLocked(it);
+                }
+            }
+            if (!hit)
+            {
+                auto flight = _in_flight.find(path);
+                if (flight != _in_flight.end())
+                {
+                    ++_stats.coalesced;
+                    flight->second->waiters.push_back(std::move(promise));
+                    return future;
+                }
+                ++_stats.misses;
+                load = std::make_shared<InFlight>();
+                load->waiters.push_back(std::move(promise));
+                _in_flight.emplace(path, load);
+            }
+        }
+        // 在锁外完成：Then 的续体会就地执行，续体里可能又来读缓存
+        if (hit)
+        {
+            promise.SetValue(std::move(hit));
+            return future;
+        }
+        executor.PutTask([this, path, load]() { Complete(path, load); });
+        return future;
+    }
+
+    // 主动失效一个路径；正在加载的结果照常交给等待者，但不进缓存
+    void Invalidate(const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        InvalidateLocked(path);
+    }
+
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        ClearLocked();
+    }
+
+    Stats GetStats()
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        Stats stats = _stats;
+        stats.bytes = _bytes;
+        stats.entries = _entries.size();
+        return stats;
+    }
+
+    // 同步读取整个文件，返回文件内容和读取时的 (inode, mtime, size)
+    static Buffer LoadFile(const std::string& path, struct stat* st_out = nullptr)
+    {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) ThrowErrno("open " + path);
+        struct stat st{};
+        if (fstat(fd, &st) != 0)
+        {
+            int err = errno;
+            close(fd);
+            throw std::system_error(err, std::generic_category(), "fstat " + path);
+        }
+        auto content = std::make_shared<std::string>();
+        content->resize(size_t(st.st_size));
+        size_t done = 0;
+        while (true)
+        {
+            // 文件在读的过程中变长：继续读到 EOF
+            if (done == content->size()) content->resize(done + 4096);
+            ssize_t n = read(fd, &(*content)[done], content->size() - done);
+            if (n < 0)
+            {
+                if (errno == EINTR) continue;
+                int err = errno;
+                close(fd);
+                throw std::system_error(err, std::generic_category(), "read " + path);
+            }
+            if (n == 0) break;
+            done += size_t(n);
+        }
+        close(fd);
+        content->resize(done);
+        if (st_out) *st_out = st;
+        return content;
+    }
+
+private:
+    struct Key
+    {
+        uint64_t inode;
+        int64_t mtime_ns;
+        int64_t size;
+
+        static Key From(const struct stat& st)
+        {
+            return Key{uint64_t(st.st_ino), int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec, int64_t(st.st_size)};
+        }
+        bool operator==(const Key& other) const
+        {
+            return inode == other.inode && mtime_ns == other.mtime_ns && size == other.size;
+        }
+    };
+
+    struct Entry
+    {
+        Buffer data;
+        Key key;
+        std::list<std::string>::iterator lru;
+        // 所在目录没能 watch（inotify 不可用或达到上限）时，命中总要 stat 校验
+        bool watched;
+    };
+
+    struct InFlight
+    {
+        std::vector<Promise<Buffer>> waiters;
+        bool stale = false;
+    };
+
+    void Complete(const std::string& path, const std::shared_ptr<InFlight>& load)
+    {
+        // 先 watch 再读：之后的任何改动都会把这次加载标记为 stale 或者让插入的条目失效，
+        // 不会出现读完之后、watch 生效之前被改掉的文件一直留在缓存里
+        bool watched;
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            watched = WatchDirLocked(path);
+        }
+        Buffer data;
+        struct stat st{};
+        std::exception_ptr error;
+        try
+        {
+            data = LoadFile(path, &st);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        // 读的过程中文件又被改过（前后 stat 对不上）的结果不缓存，下次重新读
+        struct stat now{};
+        bool cacheable = !error && stat(path.c_str(), &now) == 0 && Key::From(now) == Key::From(st);
+        std::vector<Promise<Buffer>> waiters;
+        {
+            std::lock_guard<std::mutex> lock(_mtx);
+            _in_flight.erase(path);
+            waiters.swap(load->waiters);
+            if (cacheable && !load->stale) InsertLocked(path, data, Key::From(st), watched);
+        }
+        for (auto& waiter : waiters)
+        {
+            if (error) waiter.SetException(error);
+            else waiter.SetValue(data);
+        }
+    }
+
+    void InsertLocked(const std::string& path, const Buffer& data, const Key& key, bool watched)
+    {
+        size_t size = data->size();
+        if (size > _options.capacity_bytes) return;
+        while (_bytes + size > _options.capacity_bytes && !_lru.empty())
+        {
+            EraseLocked(_entries.find(_lru.back()));
+            ++_stats.evictions;
+        }
+        _lru.push_front(path);
+        _entries.emplace(path, Entry{data, key, _lru.begin(), watched});
+        _bytes += size;
+    }
+
+    void EraseLocked(std::unordered_map<std::string, Entry>::iterator it)
+    {
+        _bytes -= it->second.data->size();
+        _lru.erase(it->second.lru);
+        _entries.erase(it);
+    }
+
+    void InvalidateLocked(const std::string& path)
+    {
+        auto it = _entries.find(path);
+        if (it != _entries.end())
+        {
+            EraseLocked(it);
+            ++_stats.invalidations;
+        }
+        auto flight = _in_flight.find(path);
+        if (flight != _in_flight.end()) flight->second->stale = true;
+    }
+
+    // 路径所在目录的前缀（带结尾的 /），相对路径且没有目录部分时为空
+    static std::string DirPrefix(const std::string& path)
+    {
+        size_t slash = path.find_last_of('/');
+        return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+    }
+
+    // 监视目录而不是文件：编辑器和部署脚本常用"写临时文件再 rename"的方式替换文件，文件本身的 watch 会丢失
+    // 目录 watch 不随缓存淘汰移除，数量受目录数限制；返回目录是否处于监视之下
+    bool WatchDirLocked(const std::string& path)
+    {
+        if (_inotify_fd < 0) return false;
+        std::string prefix = DirPrefix(path);
+        if (_watched_dirs.count(prefix)) return true;
+        int wd = inotify_add_watch(_inotify_fd, prefix.empty() ? "." : prefix.c_str(),
+            IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF);
+        if (wd < 0) return false;  // 达到 watch 上限时这个目录只靠 stat 校验
+        _watched_dirs.emplace(prefix, wd);
+        // 同一个目录换一种写法（"a/b/" 与 "a//b/"）会拿到同一个 wd
+        _watch_paths[wd].push_back(prefix);
+        return true;
+    }
+
+    void Watch()
+    {
+        alignas(inotify_event) char buffer[16 * 1024];
+        pollfd fds[2] = {{_inotify_fd, POLLIN, 0}, {_wake_fd, POLLIN, 0}};
+        while (true)
+        {
+            if (poll(fds, 2, -1) < 0)
+            {
+                if (errno == EINTR) continue;
+                return;
+            }
+            if (fds[1].revents) return;
+            while (true)
+            {
+                ssize_t n = read(_inotify_fd, buffer, sizeof(buffer));
+                if (n <= 0) break;
+                std::lock_guard<std::mutex> lock(_mtx);
+                for (char* p = buffer; p < buffer + n;)
+                {
+                    auto* event = reinterpret_cast<inotify_event*>(p);
+                    p += sizeof(inotify_event) + event->len;
+                    if (event->mask & IN_Q_OVERFLOW)
+                    {
+                        // 丢了事件，不知道哪些文件变了：全部失效
+                        ClearLocked();
+                        continue;
+                    }
+                    auto it = _watch_paths.find(event->wd);
+                    if (it == _watch_paths.end()) continue;
+                    if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF))
+                    {
+                        // 目录本身没了：其下的缓存全部失效，下次缓存时重新 watch
+                        for (auto entry = _entries.begin(); entry != _entries.end();)
+                        {
+                            auto next = std::next(entry);
+                            for (auto& prefix : it->second)
+                            {
+                                if (DirPrefix(entry->first) == prefix)
+                                {
+                                    InvalidateLocked(entry->first);
+                                    break;
+                                }
+                            }
+                            entry = next;
+                        }
+                        if (event->mask & IN_IGNORED)
+                        {
+                            for (auto& prefix : it->second) _watched_dirs.erase(prefix);
+                            _watch_paths.erase(it);
+                        }
+                        continue;
+                    }
+                    if (event->len == 0) continue;
+                    for (auto& prefix : it->second) InvalidateLocked(prefix + event->name);
+                }
+            }
+        }
+    }
+
+    void ClearLocked()
+    {
+        _stats.invalidations += _entries.size();
+        _entries.clear();
+        _lru.clear();
+        _bytes = 0;
+        for (auto& flight : _in_flight) flight.second->stale = true;
+    }
+
+    void CloseWatchFds()
+    {
+        if (_inotify_fd >= 0) close(_inotify_fd);
+        if (_wake_fd >= 0) close(_wake_fd);
+        _inotify_fd = -1;
+        _wake_fd = -1;
+    }
+
+    [[noreturn]] static void ThrowErrno(const std::string& what)
+    {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    Options _options;
+    std::mutex _mtx;
+    std::unordered_map<std::string, Entry> _entries;
+    std::list<std::string> _lru;
+    size_t _bytes = 0;
+    std::unordered_map<std::string, std::shared_ptr<InFlight>> _in_flight;
+    Stats _stats;
+
+    int _inotify_fd = -1;
+    int _wake_fd = -1;
+    std::unordered_map<std::string, int> _watched_dirs;
+    // wd -> 目录前缀，拼上事件里的文件名就是缓存的路径
+    std::unordered_map<int, std::vector<std::string>> _watch_paths;
+    std::thread _watcher;
+};
@@ -1,11 +1,13 @@
-#include <thread>
+#define DAG_THREAD_POOL_NO_MAIN
+#include "../threadPool/DAGThreadPool.cpp"
 #include <fstream>
-#include <string>
-#include <chrono>
-#include <iostream>
-#include <functional>
+#include <filesystem>
+#include "Future.h"
+#include "GroupCommit.h"
+#include "ReadCache.h"
+#include "Pipeline.h"
 
-using namespace std;
+// 编译：g++ -std=c++17 -O2 -pthread callbackHell.cpp
 
 // 异步读取文件
 void async_read_file(const string& filename,
@@ -49,14 +51,214 @@ void process_file(const string &input_filename, const string &output_filename)
     });
 }
 
-int main() {
-  process_file("input.txt", "output.txt");
+// 同步读写，出错时抛异常
+string read_file(const string& filename)
+{
+    ifstream file(filename, ios::binary);
+    if (!file)
+    {
+        throw runtime_error("Cannot open " + filename);
+    }
+    return string((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+}
+
+void write_file(const string& filename, const string& content)
+{
+    ofstream ofs(filename, ios::binary);
+    if (!(ofs << content))
+    {
+        throw runtime_error("Cannot write " + filename);
+    }
+}
+
+// Future 版本：在线程池上执行，不再每次调用起一个线程；读不到文件时以异常结束
+Future<string> async_read_file(ThreadPool& pool, const string& filename)
+{
+    return Async(pool, [filename]() { return read_file(filename); });
+}
+
+Future<Unit> async_write_file(ThreadPool& pool, const string& filename, string content)
+{
+    return Async(pool, [filename, content = move(content)]() { write_file(filename, content); });
+}
+
+// 缓存版本：反复读取的配置、资源文件直接返回共享的只读缓冲，文件变化后自动重新读
+Future<ReadCache::Buffer> async_read_file(ReadCache& cache, ThreadPool& pool, const string& filename)
+{
+    return cache.Read(pool, filename);
+}
 
-  // 主线程继续执行其他任务
-  for (int i = 0; i < 5; i++) {
-    cout << "Main thread is working..." << endl;
-    this_thread::sleep_for(chrono::seconds(1));
-  }
+// 组提交版本：并发的写入合并成批，每批每个文件一次 fdatasync，Future 完成时数据已经落盘
+Future<Unit> async_write_file(GroupCommitWriter& writer, const string& filename, string content)
+{
+    return writer.Replace(filename, move(content));
+}
+
+// 回调风格：落盘成功时 error 为空，写入失败时把异常交给回调，不会悄悄丢掉
+void async_write_file(GroupCommitWriter& writer, const string& filename, const string& content,
+                      function<void(exception_ptr error)> callback)
+{
+    writer.Replace(filename, content).Finally(move(callback));
+}
+
+// 读取文件 -> 处理数据 -> 写入文件，处理数据在读完文件的那个工作线程上直接执行
+Future<Unit> process_file(ThreadPool& pool, const string& input_filename, const string& output_filename)
+{
+    return async_read_file(pool, input_filename).Then([&pool, output_filename](string content)
+    {
+        return async_write_file(pool, output_filename, content + "processed");
+    });
+}
+
+// 并行读取多个文件，全部读完后按输入顺序合并写出，不需要手写计数器
+Future<Unit> merge_files(ThreadPool& pool, const vector<string>& inputs, const string& output_filename)
+{
+    vector<Future<string>> reads;
+    reads.reserve(inputs.size());
+    for (auto& input : inputs)
+    {
+        reads.push_back(async_read_file(pool, input));
+    }
+    return WhenAll(move(reads)).Then([&pool, output_filename](vector<string> contents)
+    {
+        string merged;
+        for (auto& content : contents) merged += content;
+        return async_write_file(pool, output_filename, move(merged));
+    });
+}
 
-  return 0;
-}
\ No newline at end of file
+// 处理整个目录：读取、处理、写出三段流水线，每段线程数独立，段间队列有界，文件再多内存也不会涨上去
+PipelineReport process_directory(const string& input_dir, const string& output_dir, PipelineOptions options = PipelineOptions())
+{
+    namespace fs = std::filesystem;
+    fs::create_directories(output_dir);
+    vector<string> names;
+    for (auto& entry : fs::directory_iterator(input_dir))
+    {
+        if (entry.is_regular_file()) names.push_back(entry.path().filename().string());
+    }
+    sort(names.begin(), names.end());
+    StagedPipeline<string, string, string> pipeline(
+        [&input_dir](const string& name) { return read_file(input_dir + "/" + name); },
+        [](const string&, string&& content) { return content + "processed"; },
+        [&output_dir](const string& name, string&& content) { write_file(output_dir + "/" + name, content); },
+        options);
+    return pipeline.Run(names);
+}
+
+void testCallback()
+{
+    process_file("input.txt", "output.txt");
+
+    // 主线程继续执行其他任务
+    for (int i = 0; i < 5; i++) {
+        cout << "Main thread is working..." << endl;
+        this_thread::sleep_for(chrono::seconds(1));
+    }
+}
+
+void testFuture()
+{
+    namespace fs = std::filesystem;
+    fs::path dir = fs::temp_directory_path() / "callbackHell_futures";
+    fs::create_directories(dir);
+
+    const int files = 1000;
+    vector<string> inputs;
+    for (int i = 0; i < files; ++i)
+    {
+        inputs.push_back((dir / ("part" + to_string(i) + ".txt")).string());
+        ofstream(inputs.back()) << "line " << i << "\n";
+    }
+
+    ThreadPool pool(4);
+    auto start = chrono::steady_clock::now();
+    string merged_path = (dir / "merged.txt").string();
+    merge_files(pool, inputs, merged_path).Get();
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "merged " << files << " files into " << fs::file_size(merged_path) << " bytes in " << ms << " ms" << endl;
+
+    process_file(pool, inputs[0], (dir / "processed.txt").string()).Get();
+    cout << "process_file: " << async_read_file(pool, (dir / "processed.txt").string()).Get() << endl;
+
+    // 存档：多次写入合并成一批，落盘后一起回调
+    {
+        GroupCommitWriter writer;
+        vector<Future<Unit>> saves;
+        for (int i = 0; i < 8; ++i)
+        {
+            saves.push_back(async_write_file(writer, (dir / ("slot" + to_string(i) + ".sav")).string(), "slot " + to_string(i)));
+        }
+        WhenAll(move(saves)).Get();
+        auto stats = writer.GetStats();
+        cout << "group commit: " << stats.writes << " saves in " << stats.batches << " batches, "
+             << stats.fsyncs << " fsyncs" << endl;
+
+        // 回调风格：目录不存在，写入失败，回调拿到异常
+        Latch done(1);
+        async_write_file(writer, (dir / "missing" / "slot.sav").string(), "slot", [&done](exception_ptr error) {
+            try
+            {
+                if (error) rethrow_exception(error);
+                cout << "callback save: ok" << endl;
+            }
+            catch (const exception& e)
+            {
+                cout << "callback save failed: " << e.what() << endl;
+            }
+            done.CountDown();
+        });
+        done.Wait();
+    }
+
+    // 同一个文件反复读：只有第一次读磁盘
+    {
+        ReadCache cache;
+        size_t bytes = 0;
+        for (int i = 0; i < 100; ++i) bytes += async_read_file(cache, pool, inputs[0]).Get()->size();
+        auto stats = cache.GetStats();
+        cout << "read cache: 100 reads, " << bytes << " bytes, " << stats.misses << " load, " << stats.hits << " hits" << endl;
+    }
+
+    // 整个目录走流水线
+    {
+        PipelineOptions options;
+        options.read_threads = 2;
+        options.transform_threads = 2;
+        options.write_threads = 2;
+        PipelineReport report = process_directory(dir.string(), (dir / "out").string(), options);
+        cout << "process_directory: ";
+        report.Print(cout);
+    }
+
+    // 谁先读完用谁
+    vector<Future<string>> racers;
+    racers.push_back(async_read_file(pool, inputs[1]));
+    racers.push_back(async_read_file(pool, inputs[2]));
+    auto first = WhenAny(move(racers)).Get();
+    cout << "first of two reads: #" << first.first << " " << first.second;
+
+    // 异常沿链条传递：中间的处理函数不会执行，Get 时重新抛出
+    try
+    {
+        merge_files(pool, {inputs[0], (dir / "missing.txt").string()}, (dir / "never.txt").string()).Get();
+    }
+    catch (const exception& e)
+    {
+        cout << "merge with a missing input failed: " << e.what() << endl;
+    }
+    fs::remove_all(dir);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && string(argv[1]) == "callback")
+    {
+        testCallback();
+    }
+    else
+    {
+        testFuture();
+    }
+    return 0;
+}
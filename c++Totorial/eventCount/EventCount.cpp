@@ -0,0 +1,310 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include "EventCount.h"
+
+using namespace std;
+
+// 唤醒风暴基准：生产者每轮投递一小批任务，等它们全部完成后再投下一批
+// 工作线程大部分时间空闲，每次投递都要把线程从睡眠中叫醒，
+// 比较不同等待原语下每完成一个任务发生多少次上下文切换
+//
+// 编译：g++ -std=c++17 -O2 -pthread EventCount.cpp
+// 运行：./a.out [workers] [rounds] [burst]
+
+// 进程内所有线程的上下文切换次数（主动 + 被动）
+long ContextSwitches()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+// 互斥锁 + 条件变量的任务队列，Broadcast 为 true 时每次投递都 notify_all
+template<typename CV, bool Broadcast>
+class CondVarQueue
+{
+public:
+    void Push(function<void()> task)
+    {
+        {
+            lock_guard<mutex> lock(_mutex);
+            _tasks.push_back(move(task));
+        }
+        if (Broadcast) _cv.notify_all();
+        else _cv.notify_one();
+    }
+
+    bool Pop(function<void()>& task)
+    {
+        unique_lock<mutex> lock(_mutex);
+        _cv.wait(lock, [this]() { return _stop || !_tasks.empty(); });
+        if (_tasks.empty()) return false;
+        task = move(_tasks.front());
+        _tasks.pop_front();
+        return true;
+    }
+
+    void Stop()
+    {
+        {
+            lock_guard<mutex> lock(_mutex);
+            _stop = true;
+        }
+        _cv.notify_all();
+    }
+
+private:
+    mutex _mutex;
+    CV _cv;
+    deque<function<void()>> _tasks;
+    bool _stop = false;
+};
+
+// 生产者不持有等待方的锁：任务进入队列后用 EventCount 通知
+// 消费者用 prepare-wait / commit-wait，检查队列和进入睡眠之间的通知不会丢失
+class EventCountQueue
+{
+public:
+    void Push(function<void()> task)
+    {
+        {
+            lock_guard<mutex> lock(_mutex);
+            _tasks.push_back(move(task));
+            _size.store(_tasks.size(), memory_order_release);
+        }
+        _ec.NotifyOne();
+    }
+
+    bool Pop(function<void()>& task)
+    {
+        while (true)
+        {
+            if (TryPop(task)) return true;
+            EventCount::Key key = _ec.PrepareWait();
+            if (TryPop(task))
+            {
+                _ec.CancelWait();
+                return true;
+            }
+            if (_stop.load(memory_order_acquire))
+            {
+                _ec.CancelWait();
+                return false;
+            }
+            _ec.CommitWait(key);
+        }
+    }
+
+    void Stop()
+    {
+        _stop.store(true, memory_order_release);
+        _ec.NotifyAll();
+    }
+
+private:
+    bool TryPop(function<void()>& task)
+    {
+        // 队列为空时只读一个原子变量，不碰锁
+        if (_size.load(memory_order_acquire) == 0) return false;
+        lock_guard<mutex> lock(_mutex);
+        if (_tasks.empty()) return false;
+        task = move(_tasks.front());
+        _tasks.pop_front();
+        _size.store(_tasks.size(), memory_order_release);
+        return true;
+    }
+
+    mutex _mutex;
+    deque<function<void()>> _tasks;
+    atomic<size_t> _size{0};
+    atomic<bool> _stop{false};
+    EventCount _ec;
+};
+
+// 用 ParkingLot 实现的计数信号量：按计数器地址停车，释放时只唤醒一个等待者
+class ParkingSemaphore
+{
+public:
+    void Wait()
+    {
+        while (true)
+        {
+            int count = _count.load(memory_order_acquire);
+            while (count > 0)
+            {
+                if (_count.compare_exchange_weak(count, count - 1, memory_order_acq_rel)) return;
+            }
+            ParkingLot::Park(&_count, [this]() { return _count.load(memory_order_acquire) <= 0; });
+        }
+    }
+
+    void Post(int n = 1)
+    {
+        _count.fetch_add(n, memory_order_release);
+        for (int i = 0; i < n; ++i)
+        {
+            if (!ParkingLot::UnparkOne(&_count)) break;
+        }
+    }
+
+private:
+    atomic<int> _count{0};
+};
+
+class ParkingLotQueue
+{
+public:
+    void Push(function<void()> task)
+    {
+        {
+            lock_guard<mutex> lock(_mutex);
+            _tasks.push_back(move(task));
+        }
+        _sem.Post();
+    }
+
+    bool Pop(function<void()>& task)
+    {
+        _sem.Wait();
+        lock_guard<mutex> lock(_mutex);
+        if (_tasks.empty()) return false;  // Stop 投递的空信号
+        task = move(_tasks.front());
+        _tasks.pop_front();
+        return true;
+    }
+
+    void Stop(int workers) { _sem.Post(workers); }
+
+private:
+    mutex _mutex;
+    deque<function<void()>> _tasks;
+    ParkingSemaphore _sem;
+};
+
+template<typename Queue>
+void StopQueue(Queue& queue, int) { queue.Stop(); }
+void StopQueue(ParkingLotQueue& queue, int workers) { queue.Stop(workers); }
+
+struct BenchResult
+{
+    double ms;
+    double switches_per_task;
+};
+
+template<typename Queue>
+BenchResult RunStorm(int workers, int rounds, int burst)
+{
+    Queue queue;
+    atomic<int> done{0};
+    vector<thread> pool;
+    for (int i = 0; i < workers; ++i)
+    {
+        pool.emplace_back([&queue]() {
+            function<void()> task;
+            while (queue.Pop(task)) task();
+        });
+    }
+
+    long switches_before = ContextSwitches();
+    auto start = chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round)
+    {
+        done.store(0, memory_order_relaxed);
+        for (int i = 0; i < burst; ++i)
+        {
+            queue.Push([&done]() {
+                volatile int sink = 0;
+                for (int k = 0; k < 200; ++k) sink += k;
+                done.fetch_add(1, memory_order_release);
+            });
+        }
+        while (done.load(memory_order_acquire) < burst) this_thread::yield();
+    }
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    long switches = ContextSwitches() - switches_before;
+
+    StopQueue(queue, workers);
+    for (auto& t : pool) t.join();
+    return {ms, double(switches) / (double(rounds) * burst)};
+}
+
+void PrintResult(const string& name, const BenchResult& result)
+{
+    cout << left << setw(28) << name << right << setw(10) << fixed << setprecision(1) << result.ms << " ms"
+         << setw(10) << setprecision(3) << result.switches_per_task << " csw/task" << endl;
+}
+
+// 基本语义检查：prepare 之后的通知不会丢失；ParkingLot 只唤醒等待对应地址的线程
+void test1()
+{
+    EventCount ec;
+    atomic<bool> ready{false};
+    thread waiter([&]() {
+        while (true)
+        {
+            EventCount::Key key = ec.PrepareWait();
+            if (ready.load())
+            {
+                ec.CancelWait();
+                break;
+            }
+            ec.CommitWait(key);
+        }
+    });
+    this_thread::sleep_for(chrono::milliseconds(10));
+    ready.store(true);
+    ec.NotifyOne();
+    waiter.join();
+    cout << "eventcount wakeup ok" << endl;
+
+    int a = 0, b = 0;
+    atomic<int> woken_a{0}, woken_b{0};
+    atomic<bool> release_a{false}, release_b{false};
+    thread ta([&]() { while (!release_a) ParkingLot::Park(&a, [&]() { return !release_a.load(); }); woken_a++; });
+    thread tb([&]() { while (!release_b) ParkingLot::Park(&b, [&]() { return !release_b.load(); }); woken_b++; });
+    this_thread::sleep_for(chrono::milliseconds(10));
+    release_a = true;
+    ParkingLot::UnparkAll(&a);
+    ta.join();
+    cout << "unpark &a: woken_a=" << woken_a << " woken_b=" << woken_b << endl;
+    release_b = true;
+    ParkingLot::UnparkAll(&b);
+    tb.join();
+
+    ParkingCondVar cv;
+    mutex mtx;
+    unique_lock<mutex> lock(mtx);
+    bool notified = cv.wait_for(lock, chrono::milliseconds(5), []() { return false; });
+    cout << "wait_for timeout: " << (notified ? "notified" : "timeout") << endl;
+}
+
+void bench(int workers, int rounds, int burst)
+{
+    cout << workers << " workers, " << rounds << " rounds x " << burst << " tasks" << endl;
+    PrintResult("condvar notify_all", RunStorm<CondVarQueue<condition_variable, true>>(workers, rounds, burst));
+    PrintResult("condvar notify_one", RunStorm<CondVarQueue<condition_variable, false>>(workers, rounds, burst));
+    PrintResult("ParkingCondVar notify_one", RunStorm<CondVarQueue<ParkingCondVar, false>>(workers, rounds, burst));
+    PrintResult("EventCount prepare/commit", RunStorm<EventCountQueue>(workers, rounds, burst));
+    PrintResult("ParkingLot semaphore", RunStorm<ParkingLotQueue>(workers, rounds, burst));
+}
+
+int main(int argc, char** argv)
+{
+    int workers = argc > 1 ? atoi(argv[1]) : 8;
+    int rounds = argc > 2 ? atoi(argv[2]) : 20000;
+    int burst = argc > 3 ? atoi(argv[3]) : 2;
+    test1();
+    bench(workers, rounds, burst);
+    return 0;
+}
@@ -0,0 +1,323 @@
+#pragma once
+
+// 基于 futex 的底层等待原语（仅 Linux）
+//   - Futex:          futex 系统调用的薄封装
+//   - EventCount:     prepare-wait / commit-wait 协议，生产者无锁也不会丢失唤醒
+//   - SharedEventCount: 同样的协议，放在共享内存里跨进程使用
+//   - ParkingLot:     按地址排队的停车场，可以精确唤醒等待某个地址的线程
+//   - ParkingCondVar: condition_variable 的替代品，先自旋再睡眠，没有等待者时通知不进内核
+//
+// 各组件通过编译选项 -DUSE_PARKING_LOT 切换到这里的实现，见 threadPool/、semaphore/、buffer/ 下的代码
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace Futex
+{
+// 当 *addr == expected 时睡眠，直到被唤醒或超时（timeout 为 nullptr 表示不超时）
+inline void Wait(std::atomic<uint32_t>* addr, uint32_t expected, const timespec* timeout = nullptr)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT_PRIVATE, expected, timeout, nullptr, 0);
+}
+
+// 唤醒最多 count 个等待 addr 的线程
+inline void Wake(std::atomic<uint32_t>* addr, int count)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+// 跨进程版本：addr 位于 MAP_SHARED 映射中，按物理页定位等待队列
+inline void WaitShared(std::atomic<uint32_t>* addr, uint32_t expected, const timespec* timeout = nullptr)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT, expected, timeout, nullptr, 0);
+}
+
+inline void WakeShared(std::atomic<uint32_t>* addr, int count)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE, count, nullptr, nullptr, 0);
+}
+
+inline void CpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// 单核机器上自旋只会拖住持有条件的线程，直接睡眠
+inline int SpinLimit(int spins)
+{
+    static const bool multi_core = std::thread::hardware_concurrency() > 1;
+    return multi_core ? spins : 0;
+}
+
+inline timespec ToTimespec(std::chrono::nanoseconds ns)
+{
+    if (ns.count() < 0) ns = std::chrono::nanoseconds(0);
+    timespec ts;
+    ts.tv_sec = time_t(ns.count() / 1000000000);
+    ts.tv_nsec = long(ns.count() % 1000000000);
+    return ts;
+}
+}
+
+// 事件计数器
+// 等待方：
+//     auto key = ec.PrepareWait();
+//     if (条件已满足) { ec.CancelWait(); return; }
+//     ec.CommitWait(key);   // 期间有任何 Notify 都会立即返回
+// 通知方：先让条件成立（可以是无锁操作），再调用 NotifyOne/NotifyAll
+// 没有等待者时 Notify 只是一次原子读，不进内核
+// Shared 为 true 时可以放在共享内存里跨进程使用（SharedEventCount）
+template<bool Shared>
+class BasicEventCount
+{
+public:
+    using Key = uint32_t;
+
+    // 先自旋这么多次再进入 futex 睡眠
+    static constexpr int kSpinCount = 200;
+
+    Key PrepareWait()
+    {
+        // 先登记再读取 epoch，与 Notify 中的栅栏配对
+        _waiters.fetch_add(1, std::memory_order_seq_cst);
+        return _epoch.load(std::memory_order_seq_cst);
+    }
+
+    void CancelWait()
+    {
+        _waiters.fetch_sub(1, std::memory_order_seq_cst);
+    }
+
+    void CommitWait(Key key)
+    {
+        for (int i = 0, n = Futex::SpinLimit(kSpinCount); i < n; ++i)
+        {
+            if (_epoch.load(std::memory_order_acquire) != key)
+            {
+                CancelWait();
+                return;
+            }
+            Futex::CpuRelax();
+        }
+        while (_epoch.load(std::memory_order_acquire) == key)
+        {
+            Wait(key, nullptr);
+        }
+        CancelWait();
+    }
+
+    // 带超时的 CommitWait，超时返回 false
+    bool CommitWaitUntil(Key key, std::chrono::steady_clock::time_point deadline)
+    {
+        while (_epoch.load(std::memory_order_acquire) == key)
+        {
+            auto left = deadline - std::chrono::steady_clock::now();
+            if (left <= std::chrono::steady_clock::duration::zero())
+            {
+                CancelWait();
+                return false;
+            }
+            timespec ts = Futex::ToTimespec(std::chrono::duration_cast<std::chrono::nanoseconds>(left));
+            Wait(key, &ts);
+        }
+        CancelWait();
+        return true;
+    }
+
+    void NotifyOne() { Notify(1); }
+    void NotifyAll() { Notify(INT_MAX); }
+
+private:
+    void Notify(int count)
+    {
+        // 与等待方的 PrepareWait 配对：要么等待方看到新条件，要么这里看到等待者
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_waiters.load(std::memory_order_seq_cst) == 0) return;
+        _epoch.fetch_add(1, std::memory_order_seq_cst);
+        if (Shared) Futex::WakeShared(&_epoch, count);
+        else Futex::Wake(&_epoch, count);
+    }
+
+    void Wait(Key key, const timespec* timeout)
+    {
+        if (Shared) Futex::WaitShared(&_epoch, key, timeout);
+        else Futex::Wait(&_epoch, key, timeout);
+    }
+
+    alignas(64) std::atomic<uint32_t> _epoch{0};
+    std::atomic<uint32_t> _waiters{0};
+};
+
+using EventCount = BasicEventCount<false>;
+using SharedEventCount = BasicEventCount<true>;
+
+// 停车场：按地址把等待线程分桶排队，唤醒时只唤醒等待该地址的线程
+// Park 时在桶锁内调用 validate，返回 false 则不睡眠，用于避免丢失唤醒
+class ParkingLot
+{
+public:
+    template<typename Validate>
+    static bool Park(const void* addr, Validate validate)
+    {
+        Bucket& bucket = BucketFor(addr);
+        Waiter self;
+        self.addr = addr;
+        {
+            std::lock_guard<std::mutex> lock(bucket.mutex);
+            if (!validate()) return false;
+            self.next = nullptr;
+            if (bucket.tail) bucket.tail->next = &self;
+            else bucket.head = &self;
+            bucket.tail = &self;
+        }
+        for (int i = 0, n = Futex::SpinLimit(EventCount::kSpinCount); i < n; ++i)
+        {
+            if (self.state.load(std::memory_order_acquire) != 0) return true;
+            Futex::CpuRelax();
+        }
+        while (self.state.load(std::memory_order_acquire) == 0)
+        {
+            Futex::Wait(&self.state, 0);
+        }
+        return true;
+    }
+
+    // 唤醒一个等待 addr 的线程，返回是否有线程被唤醒
+    static bool UnparkOne(const void* addr) { return Unpark(addr, 1) > 0; }
+    static int UnparkAll(const void* addr) { return Unpark(addr, INT_MAX); }
+
+private:
+    struct Waiter
+    {
+        const void* addr = nullptr;
+        Waiter* next = nullptr;
+        std::atomic<uint32_t> state{0};
+    };
+
+    struct alignas(64) Bucket
+    {
+        std::mutex mutex;
+        Waiter* head = nullptr;
+        Waiter* tail = nullptr;
+    };
+
+    static Bucket& BucketFor(const void* addr)
+    {
+        static Bucket buckets[kBucketCount];
+        uintptr_t key = reinterpret_cast<uintptr_t>(addr);
+        key ^= key >> 17;
+        key *= 0x9E3779B97F4A7C15ULL;
+        return buckets[(key >> 32) % kBucketCount];
+    }
+
+    static int Unpark(const void* addr, int count)
+    {
+        Bucket& bucket = BucketFor(addr);
+        Waiter* woken = nullptr;
+        Waiter** woken_tail = &woken;
+        int n = 0;
+        {
+            std::lock_guard<std::mutex> lock(bucket.mutex);
+            Waiter* prev = nullptr;
+            Waiter* cur = bucket.head;
+            while (cur && n < count)
+            {
+                Waiter* next = cur->next;
+                if (cur->addr == addr)
+                {
+                    if (prev) prev->next = next;
+                    else bucket.head = next;
+                    if (bucket.tail == cur) bucket.tail = prev;
+                    cur->next = nullptr;
+                    *woken_tail = cur;
+                    woken_tail = &cur->next;
+                    ++n;
+                }
+                else
+                {
+                    prev = cur;
+                }
+                cur = next;
+            }
+        }
+        // 出锁后再唤醒；state 置 1 之后 Waiter 随时可能被对方线程销毁，先取 next
+        // 之后的 Wake 可能落在已失效的地址上，最多造成一次虚假唤醒，等待方都会重新检查条件
+        while (woken)
+        {
+            Waiter* next = woken->next;
+            woken->state.store(1, std::memory_order_release);
+            Futex::Wake(&woken->state, 1);
+            woken = next;
+        }
+        return n;
+    }
+
+    static constexpr size_t kBucketCount = 256;
+};
+
+// condition_variable 的替代品，接口与 std::condition_variable 一致（配合 unique_lock<mutex>，也接受任意带 lock/unlock 的锁，相当于 condition_variable_any）
+// 与标准实现的区别：先自旋再睡眠；没有等待者时 notify 不进内核；notify_one 只唤醒一个线程
+class ParkingCondVar
+{
+public:
+    template<typename Lock>
+    void wait(Lock& lock)
+    {
+        EventCount::Key key = _ec.PrepareWait();
+        lock.unlock();
+        _ec.CommitWait(key);
+        lock.lock();
+    }
+
+    template<typename Lock, typename Predicate>
+    void wait(Lock& lock, Predicate pred)
+    {
+        while (!pred()) wait(lock);
+    }
+
+    template<typename Lock, typename Clock, typename Duration>
+    std::cv_status wait_until(Lock& lock, const std::chrono::time_point<Clock, Duration>& deadline)
+    {
+        auto steady_deadline = std::chrono::steady_clock::now() + (deadline - Clock::now());
+        EventCount::Key key = _ec.PrepareWait();
+        lock.unlock();
+        bool notified = _ec.CommitWaitUntil(key, std::chrono::time_point_cast<std::chrono::steady_clock::duration>(steady_deadline));
+        lock.lock();
+        return notified ? std::cv_status::no_timeout : std::cv_status::timeout;
+    }
+
+    template<typename Lock, typename Clock, typename Duration, typename Predicate>
+    bool wait_until(Lock& lock, const std::chrono::time_point<Clock, Duration>& deadline, Predicate pred)
+    {
+        while (!pred())
+        {
+            if (wait_until(lock, deadline) == std::cv_status::timeout) return pred();
+        }
+        return true;
+    }
+
+    template<typename Lock, typename Rep, typename Period, typename Predicate>
+    bool wait_for(Lock& lock, const std::chrono::duration<Rep, Period>& timeout, Predicate pred)
+    {
+        return wait_until(lock, std::chrono::steady_clock::now() + timeout, pred);
+    }
+
+    void notify_one() { _ec.NotifyOne(); }
+    void notify_all() { _ec.NotifyAll(); }
+
+private:
+    EventCount _ec;
+};
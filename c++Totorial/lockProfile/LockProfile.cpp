@@ -0,0 +1,101 @@
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "LockProfile.h"
+
+using namespace std;
+
+// 1. 开销：单线程无竞争加解锁、多线程争同一把锁，std::mutex 与 ProfiledMutex 的每次耗时
+// 2. 报告：一把持有时间长的"热"锁和一把很少竞争的"冷"锁，看排序能不能把热锁排在前面
+//
+// 编译：g++ -std=c++17 -O2 -pthread LockProfile.cpp
+// 运行：./a.out [threads]
+
+template<typename Lock>
+double NsPerLock(Lock& lock, int threads, long iterations)
+{
+    long counter = 0;
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&]() {
+            for (long i = 0; i < iterations; ++i)
+            {
+                lock_guard<Lock> guard(lock);
+                ++counter;
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    return ns / (double(threads) * iterations);
+}
+
+void BenchOverhead(int threads)
+{
+    const long iterations = 2000000;
+    mutex plain;
+    ProfiledMutex profiled;
+    cout << "overhead (ns per lock/unlock):" << endl;
+    cout << "  1 thread      mutex " << fixed << setprecision(1) << NsPerLock(plain, 1, iterations)
+         << "   ProfiledMutex " << NsPerLock(profiled, 1, iterations) << endl;
+    cout << "  " << threads << " threads     mutex " << NsPerLock(plain, threads, iterations / threads)
+         << "   ProfiledMutex " << NsPerLock(profiled, threads, iterations / threads) << endl;
+    cout.unsetf(ios::fixed);
+}
+
+class Service
+{
+public:
+    // 热路径：在锁内做了一段不该在锁内做的工作
+    void Slow()
+    {
+        lock_guard<ProfiledMutex> lock(_hot);
+        volatile long sink = 0;
+        for (int i = 0; i < 20000; ++i) sink += i;
+    }
+
+    void Fast()
+    {
+        lock_guard<ProfiledMutex> lock(_cold);
+        ++_fast_calls;
+    }
+
+private:
+    // 同一个类里有多把锁时，默认都记在构造函数上，用名字把它们分开
+    ProfiledMutex _hot{"Service::_hot"};
+    ProfiledMutex _cold{"Service::_cold"};
+    long _fast_calls = 0;
+};
+
+void BenchReport(int threads)
+{
+    Service service;
+    vector<thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&]() {
+            for (int i = 0; i < 2000; ++i)
+            {
+                service.Slow();
+                for (int k = 0; k < 10; ++k) service.Fast();
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    LockProfiler::Print(cout);
+}
+
+int main(int argc, char** argv)
+{
+    int threads = argc > 1 ? atoi(argv[1]) : 4;
+    BenchOverhead(threads);
+    BenchReport(threads);
+    return 0;
+}
@@ -0,0 +1,444 @@
+#pragma once
+
+// 锁竞争分析：给 std::mutex 和项目里的 SpinLock 套一层统计
+//   - ProfiledLock<Lock> 接口与被包装的锁相同（lock / try_lock / unlock），可以直接配合 lock_guard、unique_lock、
+//     condition_variable_any 使用；被包装的锁需要提供 try_lock
+//   - 每次加锁记录：是否发生竞争、等待时间、持有时间，等待和持有时间各有一个按 2 的幂分桶的直方图
+//   - 锁按构造位置归类（source_location）：成员锁记在所属类的构造函数上，全局锁记在声明处，
+//     同一个类的所有实例汇总为一行；一个类里有多把锁时可以构造时传入名字区分
+//   - 统计数据按线程存放，每个线程只写自己的计数，加锁路径上没有共享写；线程退出时并入全局汇总
+//   - LockProfiler::Report() 按总等待时间排序，Print() 输出前若干项
+//
+// 各组件通过 Mutex 别名接入：编译时加 -DLOCK_PROFILING 才换成 ProfiledMutex，不加时就是 std::mutex，没有任何开销
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// C++17 没有 std::source_location，用编译器内建函数实现同样的效果（GCC / Clang）
+struct SourceLocation
+{
+    const char* file;
+    int line;
+    const char* function;
+
+    static constexpr SourceLocation Current(const char* file = __builtin_FILE(), int line = __builtin_LINE(),
+                                            const char* function = __builtin_FUNCTION())
+    {
+        return SourceLocation{file, line, function};
+    }
+};
+
+namespace lock_profile_detail
+{
+// 直方图第 b 个桶覆盖 [2^(b-1), 2^b) 个 tick，最后一个桶兜住所有更长的时间
+constexpr int kBuckets = 32;
+constexpr size_t kChunkSize = 64;
+constexpr size_t kMaxChunks = 64;
+constexpr size_t kMaxSites = kChunkSize * kMaxChunks;
+
+inline int BucketOf(uint64_t ticks)
+{
+    int bucket = ticks ? 64 - __builtin_clzll(ticks) : 0;
+    return std::min(bucket, kBuckets - 1);
+}
+
+inline uint64_t NowNs()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// 加解锁路径上每次都要取时间，x86 上直接读 TSC，比 steady_clock::now() 便宜一半左右
+inline uint64_t Ticks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return NowNs();
+#endif
+}
+
+// 每纳秒多少个 tick，第一次使用时对照 steady_clock 校准 2ms
+inline double TicksPerNs()
+{
+    static const double ratio = []() {
+#if defined(__x86_64__) || defined(__i386__)
+        uint64_t ns0 = NowNs();
+        uint64_t ticks0 = Ticks();
+        while (NowNs() - ns0 < 2000000) {}
+        return double(Ticks() - ticks0) / double(NowNs() - ns0);
+#else
+        return 1.0;
+#endif
+    }();
+    return ratio;
+}
+
+// 只有所属线程写入，用 relaxed 的 load + store 代替 fetch_add，报告线程可以同时读取
+struct SiteStats
+{
+    std::atomic<uint64_t> acquisitions{0};
+    std::atomic<uint64_t> contended{0};
+    std::atomic<uint64_t> wait_ticks{0};
+    std::atomic<uint64_t> hold_ticks{0};
+    std::atomic<uint64_t> max_wait_ticks{0};
+    std::atomic<uint64_t> max_hold_ticks{0};
+    std::atomic<uint64_t> wait_hist[kBuckets] = {};
+    std::atomic<uint64_t> hold_hist[kBuckets] = {};
+
+    static void Add(std::atomic<uint64_t>& counter, uint64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    static void Max(std::atomic<uint64_t>& counter, uint64_t value)
+    {
+        if (value > counter.load(std::memory_order_relaxed)) counter.store(value, std::memory_order_relaxed);
+    }
+
+    void Record(uint64_t wait, uint64_t hold, bool was_contended)
+    {
+        Add(acquisitions, 1);
+        if (was_contended) Add(contended, 1);
+        Add(wait_ticks, wait);
+        Add(hold_ticks, hold);
+        Max(max_wait_ticks, wait);
+        Max(max_hold_ticks, hold);
+        Add(wait_hist[BucketOf(wait)], 1);
+        Add(hold_hist[BucketOf(hold)], 1);
+    }
+
+    // 汇总到调用方独占的对象上；other 可能仍在被所属线程写入，读到的是某一时刻的近似值
+    void Merge(const SiteStats& other)
+    {
+        Add(acquisitions, other.acquisitions.load(std::memory_order_relaxed));
+        Add(contended, other.contended.load(std::memory_order_relaxed));
+        Add(wait_ticks, other.wait_ticks.load(std::memory_order_relaxed));
+        Add(hold_ticks, other.hold_ticks.load(std::memory_order_relaxed));
+        Max(max_wait_ticks, other.max_wait_ticks.load(std::memory_order_relaxed));
+        Max(max_hold_ticks, other.max_hold_ticks.load(std::memory_order_relaxed));
+        for (int b = 0; b < kBuckets; ++b)
+        {
+            Add(wait_hist[b], other.wait_hist[b].load(std::memory_order_relaxed));
+            Add(hold_hist[b], other.hold_hist[b].load(std::memory_order_relaxed));
+        }
+    }
+};
+
+// 每个线程一张表，按锁位置编号索引；分块分配，已有的块地址不会变，报告线程可以安全遍历
+struct ThreadTable
+{
+    std::atomic<SiteStats*> chunks[kMaxChunks] = {};
+
+    ~ThreadTable()
+    {
+        for (auto& chunk : chunks) delete[] chunk.load(std::memory_order_relaxed);
+    }
+
+    SiteStats& Get(uint32_t site)
+    {
+        std::atomic<SiteStats*>& slot = chunks[site / kChunkSize];
+        SiteStats* chunk = slot.load(std::memory_order_relaxed);
+        if (!chunk)
+        {
+            chunk = new SiteStats[kChunkSize];
+            slot.store(chunk, std::memory_order_release);
+        }
+        return chunk[site % kChunkSize];
+    }
+
+    const SiteStats* Find(uint32_t site) const
+    {
+        SiteStats* chunk = chunks[site / kChunkSize].load(std::memory_order_acquire);
+        return chunk ? &chunk[site % kChunkSize] : nullptr;
+    }
+};
+
+struct SiteInfo
+{
+    std::string file;
+    int line;
+    std::string function;
+    std::string name;
+};
+
+// 故意不析构：全局锁可能在静态析构阶段还在加解锁
+class Registry
+{
+public:
+    static Registry& Instance()
+    {
+        static Registry* registry = new Registry();
+        return *registry;
+    }
+
+    uint32_t Intern(const SourceLocation& site, const char* name)
+    {
+        std::string key = std::string(site.file) + ":" + std::to_string(site.line) + ":" + site.function + ":" + name;
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _index.find(key);
+        if (it != _index.end()) return it->second;
+        if (_sites.size() >= kMaxSites) return uint32_t(kMaxSites - 1);
+        uint32_t id = uint32_t(_sites.size());
+        _sites.push_back(SiteInfo{site.file, site.line, site.function, name});
+        _index.emplace(std::move(key), id);
+        return id;
+    }
+
+    void Attach(ThreadTable* table)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _threads.push_back(table);
+    }
+
+    // 线程退出：计数并入全局汇总后删除该线程的表
+    void Detach(ThreadTable* table)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _threads.erase(std::remove(_threads.begin(), _threads.end(), table), _threads.end());
+        for (uint32_t site = 0; site < _sites.size(); ++site)
+        {
+            if (const SiteStats* stats = table->Find(site)) _retired.Get(site).Merge(*stats);
+        }
+    }
+
+    // 线程表已经析构（线程退出阶段）时直接记到全局汇总
+    void RecordRetired(uint32_t site, uint64_t wait, uint64_t hold, bool contended)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _retired.Get(site).Record(wait, hold, contended);
+    }
+
+    template<typename Fn>
+    void Visit(Fn fn)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (uint32_t site = 0; site < _sites.size(); ++site)
+        {
+            SiteStats total;
+            if (const SiteStats* stats = _retired.Find(site)) total.Merge(*stats);
+            for (ThreadTable* table : _threads)
+            {
+                if (const SiteStats* stats = table->Find(site)) total.Merge(*stats);
+            }
+            fn(_sites[site], total);
+        }
+    }
+
+private:
+    Registry() { TicksPerNs(); }
+
+    std::mutex _mutex;
+    std::vector<SiteInfo> _sites;
+    std::unordered_map<std::string, uint32_t> _index;
+    std::vector<ThreadTable*> _threads;
+    ThreadTable _retired;
+};
+
+inline thread_local ThreadTable* tls_table = nullptr;
+inline thread_local bool tls_exited = false;
+
+struct TableHolder
+{
+    ThreadTable* table = nullptr;
+
+    ~TableHolder()
+    {
+        tls_table = nullptr;
+        tls_exited = true;
+        if (table)
+        {
+            Registry::Instance().Detach(table);
+            delete table;
+        }
+    }
+};
+
+inline void Record(uint32_t site, uint64_t wait, uint64_t hold, bool contended)
+{
+    ThreadTable* table = tls_table;
+    if (!table)
+    {
+        if (tls_exited)
+        {
+            Registry::Instance().RecordRetired(site, wait, hold, contended);
+            return;
+        }
+        thread_local TableHolder holder;
+        holder.table = new ThreadTable();
+        Registry::Instance().Attach(holder.table);
+        tls_table = table = holder.table;
+    }
+    table->Get(site).Record(wait, hold, contended);
+}
+
+// 直方图分位数，返回所在桶的上界（tick）
+inline uint64_t Percentile(const std::atomic<uint64_t> (&hist)[kBuckets], uint64_t count, double q)
+{
+    uint64_t target = uint64_t(q * double(count));
+    uint64_t seen = 0;
+    for (int b = 0; b < kBuckets; ++b)
+    {
+        seen += hist[b].load(std::memory_order_relaxed);
+        if (seen > target) return b == 0 ? 0 : uint64_t(1) << b;
+    }
+    return uint64_t(1) << (kBuckets - 1);
+}
+}
+
+template<typename Lock>
+class ProfiledLock
+{
+public:
+    explicit ProfiledLock(SourceLocation site = SourceLocation::Current())
+        : _site(lock_profile_detail::Registry::Instance().Intern(site, ""))
+    {
+    }
+
+    explicit ProfiledLock(const char* name, SourceLocation site = SourceLocation::Current())
+        : _site(lock_profile_detail::Registry::Instance().Intern(site, name))
+    {
+    }
+
+    ProfiledLock(const ProfiledLock&) = delete;
+    ProfiledLock& operator=(const ProfiledLock&) = delete;
+
+    void lock()
+    {
+        // 先试一次：拿到了就是无竞争，只需要取一次时间
+        if (_lock.try_lock())
+        {
+            _acquired_at = lock_profile_detail::Ticks();
+            _wait_ticks = 0;
+            _contended = false;
+            return;
+        }
+        uint64_t start = lock_profile_detail::Ticks();
+        _lock.lock();
+        _acquired_at = lock_profile_detail::Ticks();
+        _wait_ticks = _acquired_at - start;
+        _contended = true;
+    }
+
+    bool try_lock()
+    {
+        if (!_lock.try_lock()) return false;
+        _acquired_at = lock_profile_detail::Ticks();
+        _wait_ticks = 0;
+        _contended = false;
+        return true;
+    }
+
+    // 持有期间这几个字段只有持有者访问，解锁前读出来再一起记账
+    void unlock()
+    {
+        uint64_t hold = lock_profile_detail::Ticks() - _acquired_at;
+        uint64_t wait = _wait_ticks;
+        bool contended = _contended;
+        _lock.unlock();
+        lock_profile_detail::Record(_site, wait, hold, contended);
+    }
+
+private:
+    Lock _lock;
+    uint32_t _site;
+    uint64_t _acquired_at = 0;
+    uint64_t _wait_ticks = 0;
+    bool _contended = false;
+};
+
+using ProfiledMutex = ProfiledLock<std::mutex>;
+
+struct LockReport
+{
+    std::string site;      // 文件:行
+    std::string function;  // 构造时传入的名字，没有名字时是构造锁的函数（成员锁就是所属类的构造函数）
+    uint64_t acquisitions = 0;
+    uint64_t contended = 0;
+    uint64_t wait_ns = 0;
+    uint64_t hold_ns = 0;
+    uint64_t max_wait_ns = 0;
+    uint64_t max_hold_ns = 0;
+    uint64_t p50_wait_ns = 0;
+    uint64_t p99_wait_ns = 0;
+    uint64_t p50_hold_ns = 0;
+    uint64_t p99_hold_ns = 0;
+};
+
+class LockProfiler
+{
+public:
+    // 所有被使用过的锁位置，按总等待时间从大到小排列
+    static std::vector<LockReport> Report()
+    {
+        using namespace lock_profile_detail;
+        std::vector<LockReport> reports;
+        Registry::Instance().Visit([&](const SiteInfo& info, const SiteStats& stats) {
+            uint64_t count = stats.acquisitions.load(std::memory_order_relaxed);
+            if (count == 0) return;
+            LockReport report;
+            const char* file = std::strrchr(info.file.c_str(), '/');
+            report.site = std::string(file ? file + 1 : info.file.c_str()) + ":" + std::to_string(info.line);
+            if (!info.name.empty()) report.function = info.name;
+            else if (info.function.rfind("__static_initialization", 0) == 0) report.function = "<global>";
+            else report.function = info.function;
+            auto ns = [ratio = TicksPerNs()](uint64_t ticks) { return uint64_t(double(ticks) / ratio); };
+            report.acquisitions = count;
+            report.contended = stats.contended.load(std::memory_order_relaxed);
+            report.wait_ns = ns(stats.wait_ticks.load(std::memory_order_relaxed));
+            report.hold_ns = ns(stats.hold_ticks.load(std::memory_order_relaxed));
+            report.max_wait_ns = ns(stats.max_wait_ticks.load(std::memory_order_relaxed));
+            report.max_hold_ns = ns(stats.max_hold_ticks.load(std::memory_order_relaxed));
+            report.p50_wait_ns = ns(Percentile(stats.wait_hist, count, 0.50));
+            report.p99_wait_ns = ns(Percentile(stats.wait_hist, count, 0.99));
+            report.p50_hold_ns = ns(Percentile(stats.hold_hist, count, 0.50));
+            report.p99_hold_ns = ns(Percentile(stats.hold_hist, count, 0.99));
+            reports.push_back(std::move(report));
+        });
+        std::sort(reports.begin(), reports.end(), [](const LockReport& a, const LockReport& b) {
+            return a.wait_ns > b.wait_ns;
+        });
+        return reports;
+    }
+
+    static void Print(std::ostream& os, size_t top = 10)
+    {
+        std::vector<LockReport> reports = Report();
+        os << "lock profile (by total wait):" << std::endl;
+        os << "  " << std::left << std::setw(28) << "site" << std::setw(20) << "owner" << std::right
+           << std::setw(10) << "acquires" << std::setw(10) << "contended" << std::setw(12) << "wait ms"
+           << std::setw(12) << "p99 wait" << std::setw(12) << "hold ms" << std::setw(12) << "p99 hold" << std::endl;
+        for (size_t i = 0; i < reports.size() && i < top; ++i)
+        {
+            const LockReport& r = reports[i];
+            os << "  " << std::left << std::setw(28) << r.site << std::setw(20) << r.function << std::right
+               << std::setw(10) << r.acquisitions << std::setw(10) << r.contended
+               << std::setw(12) << std::fixed << std::setprecision(3) << r.wait_ns / 1e6
+               << std::setw(12) << FormatNs(r.p99_wait_ns)
+               << std::setw(12) << r.hold_ns / 1e6
+               << std::setw(12) << FormatNs(r.p99_hold_ns) << std::endl;
+            os.unsetf(std::ios::fixed);
+        }
+    }
+
+private:
+    static std::string FormatNs(uint64_t ns)
+    {
+        if (ns == 0) return "0";
+        if (ns < 1000) return "<" + std::to_string(ns) + "ns";
+        if (ns < 1000000) return "<" + std::to_string(ns / 1000) + "us";
+        return "<" + std::to_string(ns / 1000000) + "ms";
+    }
+};
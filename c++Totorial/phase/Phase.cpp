@@ -0,0 +1,160 @@
+#define DAG_THREAD_POOL_NO_MAIN
+#include "../threadPool/DAGThreadPool.cpp"
+#include <iomanip>
+#include "Phase.h"
+#if __has_include(<barrier>)
+#include <barrier>
+#endif
+
+// 1. Latch + 线程池：2 个工作线程都在等门闩，而负责倒计数的任务还排在队列里
+//    普通等待会死锁，带线程池的等待会先把排队的任务跑掉
+// 2. Phaser：运行中有参与者退出、有新参与者加入
+// 3. 屏障吞吐：每个线程反复 arrive_and_wait，统计每秒完成多少轮
+//    CombiningBarrier、std::barrier（需要 C++20）、mutex + condition_variable 实现的集中式屏障
+//
+// 编译：g++ -std=c++20 -O2 -pthread Phase.cpp   （-std=c++17 也可以，只是没有 std::barrier 那一列）
+// 运行：./a.out [max_threads]
+
+// 集中式屏障：所有线程抢同一把锁、同一个计数器
+class CentralBarrier
+{
+public:
+    explicit CentralBarrier(size_t parties) : _parties(parties) {}
+
+    void ArriveAndWait()
+    {
+        unique_lock<mutex> lock(_mtx);
+        size_t generation = _generation;
+        if (++_arrived == _parties)
+        {
+            _arrived = 0;
+            ++_generation;
+            _cv.notify_all();
+            return;
+        }
+        _cv.wait(lock, [&]() { return _generation != generation; });
+    }
+
+private:
+    size_t _parties;
+    size_t _arrived = 0;
+    size_t _generation = 0;
+    mutex _mtx;
+    condition_variable _cv;
+};
+
+void testLatchHelping()
+{
+    ThreadPool tp(2);
+    Latch latch(4);
+    Latch released(2);
+    for (int i = 0; i < 2; ++i)
+    {
+        tp.PutTask([&]() { latch.Wait(tp); released.CountDown(); });
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+        tp.PutTask([&]() { latch.CountDown(); });
+    }
+    released.Wait();
+    cout << "latch: both waiting workers released, count-down tasks ran on the waiters" << endl;
+}
+
+void testPhaser()
+{
+    Phaser phaser(1);  // 主线程也是参与者，负责打印
+    vector<thread> workers;
+    mutex mtx;
+    vector<int> arrivals(8, 0);
+    auto worker = [&](int first, int last) {
+        for (int p = first; p < last; ++p)
+        {
+            {
+                lock_guard<mutex> lock(mtx);
+                ++arrivals[p];
+            }
+            if (p + 1 == last) phaser.ArriveAndDeregister();
+            else phaser.ArriveAndAwaitAdvance();
+        }
+    };
+    // 3 个参与者做 0~3 阶段，一个只做 0~1 阶段；第 2 阶段开始再加入 2 个
+    for (int i = 0; i < 3; ++i)
+    {
+        phaser.Register();
+        workers.emplace_back(worker, 0, 4);
+    }
+    phaser.Register();
+    workers.emplace_back(worker, 0, 2);
+    for (int p = 0; p < 4; ++p)
+    {
+        if (p == 2)
+        {
+            for (int i = 0; i < 2; ++i)
+            {
+                phaser.Register();
+                workers.emplace_back(worker, 2, 4);
+            }
+        }
+        phaser.ArriveAndAwaitAdvance();
+    }
+    phaser.ArriveAndDeregister();
+    for (auto& w : workers) w.join();
+    cout << "phaser: arrivals per phase";
+    for (int p = 0; p < 4; ++p) cout << " " << arrivals[p];
+    cout << " (expect 4 4 5 5), final phase " << phaser.CurrentPhase() << endl;
+}
+
+template<typename Body>
+double EpisodesPerSec(int threads, long episodes, Body body)
+{
+    vector<thread> workers;
+    auto start = chrono::steady_clock::now();
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t]() {
+            for (long e = 0; e < episodes; ++e) body(t);
+        });
+    }
+    for (auto& w : workers) w.join();
+    return episodes / chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void BenchBarrier(int threads)
+{
+    long episodes = max(200L, 40000L / threads);
+    long completions = 0;
+
+    CombiningBarrier tree(threads, [&]() { ++completions; });
+    double tree_rate = EpisodesPerSec(threads, episodes, [&](int t) { tree.ArriveAndWait(t); });
+    if (completions != episodes) {
+        throw runtime_error("CombiningBarrier completed a wrong number of episodes");
+    }
+
+    CentralBarrier central(threads);
+    double central_rate = EpisodesPerSec(threads, episodes, [&](int) { central.ArriveAndWait(); });
+
+    cout << "  " << setw(3) << threads << " threads  " << fixed << setprecision(0)
+         << "combining " << setw(9) << tree_rate << "   mutex+cv " << setw(9) << central_rate;
+#ifdef __cpp_lib_barrier
+    std::barrier<> std_barrier(threads);
+    double std_rate = EpisodesPerSec(threads, episodes, [&](int) { std_barrier.arrive_and_wait(); });
+    cout << "   std::barrier " << setw(9) << std_rate;
+#endif
+    cout << endl;
+    cout.unsetf(ios::fixed);
+}
+
+int main(int argc, char** argv)
+{
+    int max_threads = argc > 1 ? atoi(argv[1]) : 64;
+
+    testLatchHelping();
+    testPhaser();
+
+    cout << "barrier episodes per second:" << endl;
+    for (int threads = 2; threads <= max_threads; threads *= 2)
+    {
+        BenchBarrier(threads);
+    }
+    return 0;
+}
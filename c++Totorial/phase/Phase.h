@@ -0,0 +1,359 @@
+#pragma once
+
+// 分阶段并行用的同步原语
+//   - Latch:            一次性倒计数门闩，计数归零后所有等待者放行
+//   - CombiningBarrier: 可重复使用的组合树屏障，到达时按 4 叉树逐层汇合，64 个线程也不会挤在同一个计数器上
+//   - Phaser:           阶段同步器，参与者可以在运行中注册、注销
+//
+// 等待方式都是先自旋、再让出几次 CPU、最后 futex 睡眠（单核机器不自旋，见 Futex::SpinLimit）
+// 每个等待函数都有一个接受线程池的重载：工作线程在等待期间先帮线程池执行排队中的任务，
+// 没有任务可做时才睡眠，并且每隔 kHelpInterval 醒来看一眼队列，避免所有工作线程都在等待而任务无人执行
+// 线程池需要提供 bool RunOneTask()：取出一个就绪任务在当前线程执行，队列为空时返回 false
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "../eventCount/EventCount.h"
+
+namespace phase_detail
+{
+constexpr int kSpinCount = 200;
+constexpr int kYieldCount = 16;
+constexpr std::chrono::microseconds kHelpInterval{200};
+
+struct NoHelp
+{
+    bool operator()() const { return false; }
+};
+
+// 等待用的 32 位字：最低位表示有线程在 futex 上睡眠，其余位是值（所以值只有 31 位，按相等比较，回绕无妨）
+inline uint32_t Value(const std::atomic<uint32_t>& word)
+{
+    return word.load(std::memory_order_acquire) >> 1;
+}
+
+// 31 位值的回绕比较：a 在 b 之后（领先不超过 2^30）
+inline bool After(uint32_t a, uint32_t b)
+{
+    uint32_t diff = (a - b) & 0x7fffffff;
+    return diff != 0 && diff < 0x40000000;
+}
+
+// 已发布的值越过了 phase
+struct Passed
+{
+    uint32_t phase;
+    bool operator()(uint32_t published) const { return After(published, phase); }
+};
+
+// 等到 word 的值满足 done(value)
+// help() 返回 true 表示执行了一个任务，此时重新检查条件；helping 为 false 时一直睡到被唤醒
+template<typename Done, typename Help>
+void WaitUntil(std::atomic<uint32_t>& word, Done done, Help help, bool helping)
+{
+    for (int i = 0, n = Futex::SpinLimit(kSpinCount); i < n; ++i)
+    {
+        if (done(Value(word))) return;
+        Futex::CpuRelax();
+    }
+    // 自旋之后先让出几次 CPU：屏障的最后一个到达者往往就在就绪队列里，单核机器上这比睡眠再被唤醒便宜得多
+    for (int i = 0; i < kYieldCount; ++i)
+    {
+        if (done(Value(word))) return;
+        if (helping && help()) continue;
+        std::this_thread::yield();
+    }
+    timespec interval = Futex::ToTimespec(kHelpInterval);
+    while (true)
+    {
+        uint32_t cur = word.load(std::memory_order_acquire);
+        if (done(cur >> 1)) return;
+        if (helping && help()) continue;
+        // 先置上等待位再睡；置位之后值变了，futex 会立即返回
+        if (!(cur & 1) && !word.compare_exchange_weak(cur, cur | 1, std::memory_order_acq_rel)) continue;
+        Futex::Wait(&word, cur | 1, helping ? &interval : nullptr);
+    }
+}
+
+// 等到 word 的值不再等于 old
+template<typename Help>
+void WaitWhileEqual(std::atomic<uint32_t>& word, uint32_t old, Help help, bool helping)
+{
+    old &= 0x7fffffff;
+    WaitUntil(word, [old](uint32_t value) { return value != old; }, help, helping);
+}
+
+// 写入新值，有人睡眠才进内核
+// 用一次 exchange 同时拿到等待位，之后不再读写这个对象：等待者看到新值就可能立刻销毁它（例如栈上的 Latch）
+inline void Publish(std::atomic<uint32_t>& word, uint32_t value)
+{
+    if (word.exchange(value << 1, std::memory_order_acq_rel) & 1) Futex::Wake(&word, INT_MAX);
+}
+
+// 只向前推进：value 不在当前值之后时什么也不做
+// 多个发布者的先后可能与推进的先后不同（例如发布前被切走），值也不会倒退
+inline void PublishAhead(std::atomic<uint32_t>& word, uint32_t value)
+{
+    value &= 0x7fffffff;
+    uint32_t cur = word.load(std::memory_order_relaxed);
+    do
+    {
+        if (!After(value, cur >> 1)) return;
+    } while (!word.compare_exchange_weak(cur, value << 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+    if (cur & 1) Futex::Wake(&word, INT_MAX);
+}
+}
+
+class Latch
+{
+public:
+    explicit Latch(ptrdiff_t count) : _count(count)
+    {
+        if (count < 0) {
+            throw std::invalid_argument("Latch count must not be negative");
+        }
+        if (count == 0) _done.store(1 << 1, std::memory_order_relaxed);
+    }
+
+    Latch(const Latch&) = delete;
+    Latch& operator=(const Latch&) = delete;
+
+    void CountDown(ptrdiff_t n = 1)
+    {
+        ptrdiff_t before = _count.fetch_sub(n, std::memory_order_acq_rel);
+        if (before < n) {
+            throw std::logic_error("Latch counted down below zero");
+        }
+        if (before == n) phase_detail::Publish(_done, 1);
+    }
+
+    bool TryWait() const { return phase_detail::Value(_done) != 0; }
+
+    void Wait() { phase_detail::WaitWhileEqual(_done, 0, phase_detail::NoHelp(), false); }
+
+    template<typename Pool>
+    void Wait(Pool& pool)
+    {
+        phase_detail::WaitWhileEqual(_done, 0, [&pool]() { return pool.RunOneTask(); }, true);
+    }
+
+    void ArriveAndWait(ptrdiff_t n = 1)
+    {
+        CountDown(n);
+        Wait();
+    }
+
+private:
+    std::atomic<ptrdiff_t> _count;
+    std::atomic<uint32_t> _done{0};
+};
+
+// 组合树屏障：参与者 i 先在第 i / kFanIn 个叶子节点汇合，每个节点最后到达的线程再去父节点汇合，
+// 最后到达根节点的线程执行完成回调并推进 generation，其余线程只读 generation
+// 一次汇合只在 kFanIn 个线程之间竞争同一个计数器
+class CombiningBarrier
+{
+public:
+    static constexpr size_t kFanIn = 4;
+
+    explicit CombiningBarrier(size_t parties, std::function<void()> on_completion = nullptr)
+        : _parties(parties), _on_completion(std::move(on_completion))
+    {
+        if (parties == 0) {
+            throw std::invalid_argument("Barrier needs at least one party");
+        }
+        // 自底向上建树：每层节点数是下一层的 1/kFanIn，直到只剩根节点
+        size_t width = parties;
+        size_t level_begin = 0;
+        do
+        {
+            size_t nodes = (width + kFanIn - 1) / kFanIn;
+            for (size_t i = 0; i < nodes; ++i)
+            {
+                size_t children = std::min(kFanIn, width - i * kFanIn);
+                _nodes.emplace_back(new Node(children));
+            }
+            // 上一层节点指向本层的父节点
+            if (level_begin != _nodes.size() - nodes)
+            {
+                for (size_t i = level_begin; i < _nodes.size() - nodes; ++i)
+                {
+                    _nodes[i]->parent = _nodes[_nodes.size() - nodes + (i - level_begin) / kFanIn].get();
+                }
+            }
+            level_begin = _nodes.size() - nodes;
+            width = nodes;
+        } while (width > 1);
+    }
+
+    CombiningBarrier(const CombiningBarrier&) = delete;
+    CombiningBarrier& operator=(const CombiningBarrier&) = delete;
+
+    size_t Parties() const { return _parties; }
+
+    // id 为参与者编号，取值 [0, Parties())，每个参与者固定使用自己的编号
+    void ArriveAndWait(size_t id)
+    {
+        uint32_t generation = Arrive(id);
+        phase_detail::WaitWhileEqual(_generation, generation, phase_detail::NoHelp(), false);
+    }
+
+    template<typename Pool>
+    void ArriveAndWait(size_t id, Pool& pool)
+    {
+        uint32_t generation = Arrive(id);
+        phase_detail::WaitWhileEqual(_generation, generation, [&pool]() { return pool.RunOneTask(); }, true);
+    }
+
+private:
+    struct alignas(64) Node
+    {
+        explicit Node(size_t children) : expected(uint32_t(children)) {}
+
+        std::atomic<uint32_t> arrived{0};
+        uint32_t expected;
+        Node* parent = nullptr;
+    };
+
+    // 返回到达时的 generation；最后一个到达的线程推进 generation 后返回，不会等待
+    uint32_t Arrive(size_t id)
+    {
+        if (id >= _parties) {
+            throw std::out_of_range("Barrier participant id out of range");
+        }
+        uint32_t generation = phase_detail::Value(_generation);
+        Node* node = _nodes[id / kFanIn].get();
+        while (node)
+        {
+            if (node->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 != node->expected)
+            {
+                return generation;
+            }
+            // 本节点的其他线程都已到达并在等待 generation，下一轮之前不会再碰这个计数器
+            node->arrived.store(0, std::memory_order_relaxed);
+            node = node->parent;
+        }
+        if (_on_completion) _on_completion();
+        phase_detail::Publish(_generation, generation + 1);
+        return generation;
+    }
+
+    size_t _parties;
+    std::function<void()> _on_completion;
+    std::vector<std::unique_ptr<Node>> _nodes;
+    alignas(64) std::atomic<uint32_t> _generation{0};
+};
+
+// 阶段同步器：状态打包在一个 64 位原子变量里 —— 阶段号(32) | 参与者数(16) | 本阶段未到达数(16)
+// 最后一个到达（或注销）的参与者在同一次 CAS 里推进阶段，阶段号以 _state 为准
+// _phase 是给 futex 等待用的副本，只会向前推进（PublishAhead）；等待者等到它越过目标阶段，而不是等到它变化：
+// 推进后、发布前注册或到达的参与者拿到的是新阶段号，等待它时不会因为 _phase 还是旧值而直接返回
+class Phaser
+{
+public:
+    static constexpr uint32_t kMaxParties = 0xffff;
+
+    explicit Phaser(uint32_t parties = 0)
+    {
+        if (parties > kMaxParties) {
+            throw std::invalid_argument("Too many phaser parties");
+        }
+        _state.store(Pack(0, parties, parties), std::memory_order_relaxed);
+    }
+
+    Phaser(const Phaser&) = delete;
+    Phaser& operator=(const Phaser&) = delete;
+
+    // 新增一个参与者，从当前阶段开始参与，返回当前阶段号
+    uint32_t Register()
+    {
+        uint64_t state = _state.load(std::memory_order_acquire);
+        while (true)
+        {
+            if (Parties(state) == kMaxParties) {
+                throw std::overflow_error("Too many phaser parties");
+            }
+            uint64_t next = Pack(Phase(state), Parties(state) + 1, Unarrived(state) + 1);
+            if (_state.compare_exchange_weak(state, next, std::memory_order_acq_rel)) return Phase(state);
+        }
+    }
+
+    // 到达但不等待，返回到达时的阶段号
+    uint32_t Arrive() { return DoArrive(false); }
+
+    // 到达并退出，之后的阶段不再等待它
+    uint32_t ArriveAndDeregister() { return DoArrive(true); }
+
+    // 等待阶段 phase 结束；phase 已经过去时立即返回
+    void AwaitAdvance(uint32_t phase)
+    {
+        phase_detail::WaitUntil(_phase, phase_detail::Passed{phase}, phase_detail::NoHelp(), false);
+    }
+
+    template<typename Pool>
+    void AwaitAdvance(uint32_t phase, Pool& pool)
+    {
+        phase_detail::WaitUntil(_phase, phase_detail::Passed{phase}, [&pool]() { return pool.RunOneTask(); }, true);
+    }
+
+    uint32_t ArriveAndAwaitAdvance()
+    {
+        uint32_t phase = Arrive();
+        AwaitAdvance(phase);
+        return phase + 1;
+    }
+
+    template<typename Pool>
+    uint32_t ArriveAndAwaitAdvance(Pool& pool)
+    {
+        uint32_t phase = Arrive();
+        AwaitAdvance(phase, pool);
+        return phase + 1;
+    }
+
+    uint32_t CurrentPhase() const { return Phase(_state.load(std::memory_order_acquire)); }
+    uint32_t RegisteredParties() const { return Parties(_state.load(std::memory_order_acquire)); }
+
+private:
+    static uint64_t Pack(uint32_t phase, uint32_t parties, uint32_t unarrived)
+    {
+        return (uint64_t(phase) << 32) | (uint64_t(parties) << 16) | unarrived;
+    }
+    static uint32_t Phase(uint64_t state) { return uint32_t(state >> 32); }
+    static uint32_t Parties(uint64_t state) { return uint32_t(state >> 16) & 0xffff; }
+    static uint32_t Unarrived(uint64_t state) { return uint32_t(state) & 0xffff; }
+
+    uint32_t DoArrive(bool deregister)
+    {
+        uint64_t state = _state.load(std::memory_order_acquire);
+        while (true)
+        {
+            uint32_t phase = Phase(state);
+            uint32_t parties = Parties(state) - (deregister ? 1 : 0);
+            uint32_t unarrived = Unarrived(state);
+            if (unarrived == 0) {
+                throw std::logic_error("Phaser arrival without registration");
+            }
+            uint64_t next;
+            bool advance = unarrived == 1;
+            if (advance) next = Pack(phase + 1, parties, parties);
+            else next = Pack(phase, parties, unarrived - 1);
+            if (_state.compare_exchange_weak(state, next, std::memory_order_acq_rel))
+            {
+                if (advance) phase_detail::PublishAhead(_phase, phase + 1);
+                return phase;
+            }
+        }
+    }
+
+    std::atomic<uint64_t> _state;
+    std::atomic<uint32_t> _phase{0};
+};
@@ -0,0 +1,350 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Reclaim.h"
+#include "../eventCount/EventCount.h"
+
+using namespace std;
+
+// 用 EpochDomain / HazardDomain 回收节点的无锁队列和线程池，以及回收泄漏的压力测试
+//
+// 编译：g++ -std=c++17 -O2 -pthread Reclaim.cpp
+// 检查释放后使用：g++ -std=c++17 -O1 -g -pthread -fsanitize=address Reclaim.cpp
+// 运行：./a.out [threads] [ops_per_thread]
+
+// Michael-Scott 无锁队列，回收策略作为模板参数
+// 出队的线程把旧的哨兵节点退休，其他线程可能还在读它，由 Domain 决定什么时候真正释放
+template<typename T, typename Domain>
+class LockFreeQueue
+{
+public:
+    explicit LockFreeQueue(Domain& domain) : _domain(domain)
+    {
+        Node* dummy = new Node();
+        _head.store(dummy);
+        _tail.store(dummy);
+    }
+
+    ~LockFreeQueue()
+    {
+        Node* node = _head.load();
+        while (node)
+        {
+            Node* next = node->next.load();
+            delete node;
+            node = next;
+        }
+    }
+
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    void Push(T value)
+    {
+        Node* node = new Node(move(value));
+        typename Domain::Guard guard(_domain);
+        while (true)
+        {
+            Node* tail = guard.Protect(0, _tail);
+            Node* next = tail->next.load(memory_order_acquire);
+            if (tail != _tail.load(memory_order_acquire)) continue;
+            if (next)
+            {
+                // 队尾落后了，帮忙推进
+                _tail.compare_exchange_weak(tail, next, memory_order_acq_rel);
+                continue;
+            }
+            if (tail->next.compare_exchange_weak(next, node, memory_order_acq_rel))
+            {
+                _tail.compare_exchange_strong(tail, node, memory_order_acq_rel);
+                return;
+            }
+        }
+    }
+
+    bool TryPop(T& value)
+    {
+        typename Domain::Guard guard(_domain);
+        while (true)
+        {
+            Node* head = guard.Protect(0, _head);
+            Node* next = guard.Protect(1, head->next);
+            if (head != _head.load(memory_order_acquire)) continue;
+            if (!next) return false;
+            Node* tail = _tail.load(memory_order_acquire);
+            if (head == tail)
+            {
+                _tail.compare_exchange_weak(tail, next, memory_order_acq_rel);
+                continue;
+            }
+            if (_head.compare_exchange_weak(head, next, memory_order_acq_rel))
+            {
+                // next 成为新的哨兵，只有抢到它的线程会读取它的值
+                value = move(next->value);
+                _domain.Retire(head);
+                return true;
+            }
+        }
+    }
+
+    bool Empty() const
+    {
+        Node* head = _head.load(memory_order_acquire);
+        return head == _tail.load(memory_order_acquire) && !head->next.load(memory_order_acquire);
+    }
+
+private:
+    struct Node
+    {
+        Node() = default;
+        explicit Node(T v) : value(move(v)) {}
+
+        atomic<Node*> next{nullptr};
+        T value{};
+    };
+
+    Domain& _domain;
+    alignas(64) atomic<Node*> _head{nullptr};
+    alignas(64) atomic<Node*> _tail{nullptr};
+};
+
+// 任务队列无锁的线程池
+// AddThread 启动的工作线程在开始时登记到回收域，退出时注销并把没回收完的节点交给域
+template<typename Domain>
+class ThreadPool
+{
+public:
+    ThreadPool(int numThreads, Domain& domain) : _domain(domain), _tasks(domain)
+    {
+        for (int i = 0; i < numThreads; i++)
+        {
+            AddThread();
+        }
+    }
+
+    ~ThreadPool()
+    {
+        _stop.store(true, memory_order_release);
+        _ec.NotifyAll();
+        for (auto& thread : _pool)
+        {
+            if (thread.joinable()) thread.join();
+        }
+    }
+
+    void AddThread()
+    {
+        _pool.emplace_back([this]() {
+            _domain.AttachThread();
+            function<void()> task;
+            while (true)
+            {
+                if (_tasks.TryPop(task))
+                {
+                    task();
+                    continue;
+                }
+                EventCount::Key key = _ec.PrepareWait();
+                if (!_tasks.Empty())
+                {
+                    _ec.CancelWait();
+                    continue;
+                }
+                if (_stop.load(memory_order_acquire))
+                {
+                    _ec.CancelWait();
+                    break;
+                }
+                _ec.CommitWait(key);
+            }
+            _domain.DetachThread();
+        });
+    }
+
+    void PutTask(function<void()> task)
+    {
+        _tasks.Push(move(task));
+        _ec.NotifyOne();
+    }
+
+private:
+    Domain& _domain;
+    LockFreeQueue<function<void()>, Domain> _tasks;
+    vector<thread> _pool;
+    EventCount _ec;
+    atomic<bool> _stop{false};
+};
+
+// 统计存活实例数，检查是否有节点没被释放；magic 用来粗略发现释放后使用
+struct Tracked
+{
+    static atomic<long> live;
+    static constexpr uint32_t kAlive = 0x600DF00D;
+    static constexpr uint32_t kDead = 0xDEADBEEF;
+
+    Tracked() { live.fetch_add(1, memory_order_relaxed); }
+    explicit Tracked(int v) : value(v) { live.fetch_add(1, memory_order_relaxed); }
+    Tracked(const Tracked& other) : value(other.value) { live.fetch_add(1, memory_order_relaxed); }
+    Tracked& operator=(const Tracked& other)
+    {
+        if (magic != kAlive || other.magic != kAlive) abort();
+        value = other.value;
+        return *this;
+    }
+    ~Tracked()
+    {
+        magic = kDead;
+        live.fetch_sub(1, memory_order_relaxed);
+    }
+
+    uint32_t magic = kAlive;
+    int value = 0;
+};
+atomic<long> Tracked::live{0};
+
+void PrintStats(const string& name, const ReclaimStats& stats)
+{
+    cout << name << ": retired=" << stats.retired << " reclaimed=" << stats.reclaimed
+         << " pending=" << stats.Pending() << " peak per-thread pending=" << stats.peak_pending << endl;
+}
+
+// 一半线程入队、一半线程出队，结束后队列和域都析构，检查存活实例数回到 0
+template<typename Domain>
+void StressLeak(const string& name, int threads, int ops)
+{
+    long sum_pushed = 0;
+    atomic<long> sum_popped{0};
+    ReclaimStats stats;
+    {
+        Domain domain;
+        LockFreeQueue<Tracked, Domain> queue(domain);
+        atomic<int> producers_done{0};
+        int producers = max(1, threads / 2);
+        int consumers = max(1, threads - producers);
+        vector<thread> workers;
+        for (int p = 0; p < producers; ++p)
+        {
+            sum_pushed += long(ops) * (ops + 1) / 2;
+            workers.emplace_back([&queue, &producers_done, ops]() {
+                for (int i = 1; i <= ops; ++i) queue.Push(Tracked(i));
+                producers_done.fetch_add(1);
+            });
+        }
+        for (int c = 0; c < consumers; ++c)
+        {
+            workers.emplace_back([&, producers]() {
+                Tracked item;
+                long local = 0;
+                while (true)
+                {
+                    if (queue.TryPop(item))
+                    {
+                        if (item.magic != Tracked::kAlive) abort();
+                        local += item.value;
+                        continue;
+                    }
+                    if (producers_done.load() == producers && queue.Empty()) break;
+                    this_thread::yield();
+                }
+                sum_popped.fetch_add(local);
+            });
+        }
+        for (auto& t : workers) t.join();
+        domain.Collect();
+        stats = domain.Stats();
+    }
+    cout << name << ": " << (sum_pushed == sum_popped.load() ? "sum ok" : "SUM MISMATCH")
+         << ", live after teardown=" << Tracked::live.load() << endl;
+    PrintStats("  before teardown", stats);
+}
+
+// 线程池的工作线程退出时把垃圾交给域，域在 Collect 后应该没有剩余
+template<typename Domain>
+void PoolLifecycle(const string& name)
+{
+    Domain domain;
+    atomic<int> done{0};
+    const int tasks = 100000;
+    {
+        ThreadPool<Domain> pool(2, domain);
+        for (int i = 0; i < tasks / 2; ++i) pool.PutTask([&done]() { done.fetch_add(1, memory_order_relaxed); });
+        pool.AddThread();
+        pool.AddThread();
+        for (int i = 0; i < tasks / 2; ++i) pool.PutTask([&done]() { done.fetch_add(1, memory_order_relaxed); });
+    }
+    domain.Collect();
+    ReclaimStats stats = domain.Stats();
+    cout << name << " pool: executed " << done.load() << "/" << tasks << endl;
+    PrintStats("  after workers exit", stats);
+}
+
+// 读端临界区开销：每次读取一个共享指针
+template<typename Read>
+double MeasureRead(int readers, int iterations, Read read)
+{
+    atomic<bool> start{false};
+    vector<thread> threads;
+    vector<double> ns(readers);
+    for (int r = 0; r < readers; ++r)
+    {
+        threads.emplace_back([&, r]() {
+            while (!start.load()) this_thread::yield();
+            auto begin = chrono::steady_clock::now();
+            long sink = 0;
+            for (int i = 0; i < iterations; ++i) sink += read();
+            ns[r] = chrono::duration<double, nano>(chrono::steady_clock::now() - begin).count() / iterations;
+            if (sink == 42) cout << "";
+        });
+    }
+    start.store(true);
+    for (auto& t : threads) t.join();
+    double total = 0;
+    for (double v : ns) total += v;
+    return total / readers;
+}
+
+void BenchReadSide(int readers)
+{
+    const int iterations = 5000000;
+    atomic<Tracked*> shared{new Tracked(1)};
+    EpochDomain ebr;
+    HazardDomain hp;
+
+    double raw = MeasureRead(readers, iterations, [&]() { return shared.load(memory_order_acquire)->value; });
+    double epoch = MeasureRead(readers, iterations, [&]() {
+        EpochDomain::Guard guard(ebr);
+        return guard.Protect(0, shared)->value;
+    });
+    double hazard = MeasureRead(readers, iterations, [&]() {
+        HazardDomain::Guard guard(hp);
+        return guard.Protect(0, shared)->value;
+    });
+    delete shared.load();
+
+    cout << readers << " readers, read-side cost per critical section:" << endl;
+    cout << fixed << setprecision(2);
+    cout << "  raw atomic load:  " << setw(8) << raw << " ns" << endl;
+    cout << "  EpochDomain:      " << setw(8) << epoch << " ns" << endl;
+    cout << "  HazardDomain:     " << setw(8) << hazard << " ns" << endl;
+    cout.unsetf(ios::fixed);
+}
+
+int main(int argc, char** argv)
+{
+    int threads = argc > 1 ? atoi(argv[1]) : 4;
+    int ops = argc > 2 ? atoi(argv[2]) : 200000;
+
+    StressLeak<EpochDomain>("EBR", threads, ops);
+    StressLeak<HazardDomain>("HP", threads, ops);
+    PoolLifecycle<EpochDomain>("EBR");
+    PoolLifecycle<HazardDomain>("HP");
+    BenchReadSide(1);
+    BenchReadSide(threads);
+    return 0;
+}
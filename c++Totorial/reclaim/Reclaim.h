@@ -0,0 +1,595 @@
+#pragma once
+
+// 无锁容器的安全内存回收
+//   - EpochDomain:  基于纪元的回收（EBR），读端只需在进入/退出临界区时各写一次本线程的纪元
+//   - HazardDomain: 风险指针（Hazard Pointer），读端每个指针都要发布，但一个卡住的读线程不会挡住全部回收
+//
+// 两者提供相同的接口，容器可以把回收策略作为模板参数：
+//     typename Domain::Guard guard(domain);         // 进入读端临界区
+//     Node* p = guard.Protect(0, head);             // 读取并保护一个共享指针
+//     domain.Retire(p);                             // 从结构中摘除后退休，等没有读者时再释放
+//
+// 线程第一次使用某个域时自动登记，线程退出时自动注销；线程池也可以在 AddThread 的工作线程里
+// 显式调用 AttachThread/DetachThread，让退出的工作线程立即把剩余垃圾交给域统一处理
+// 域必须比使用它的线程活得久，或者这些线程在域析构前已经 DetachThread
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace reclaim_detail
+{
+class DomainBase;
+
+struct Registry
+{
+    std::mutex mutex;
+    std::unordered_map<uint64_t, DomainBase*> live;
+    uint64_t next_id = 1;
+};
+
+inline Registry& GetRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+
+// 每个线程登记过的 (域 id, 线程记录)，线程退出时注销仍然存活的域上的记录
+struct ThreadAttachments
+{
+    std::vector<std::pair<uint64_t, void*>> items;
+    uint64_t cached_id = 0;
+    void* cached_record = nullptr;
+
+    ~ThreadAttachments();
+};
+
+inline ThreadAttachments& LocalAttachments()
+{
+    static thread_local ThreadAttachments attachments;
+    return attachments;
+}
+
+class DomainBase
+{
+public:
+    DomainBase()
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        _id = registry.next_id++;
+        registry.live[_id] = this;
+    }
+    virtual ~DomainBase() = default;
+
+    DomainBase(const DomainBase&) = delete;
+    DomainBase& operator=(const DomainBase&) = delete;
+
+    // 由线程退出时调用，派生类把记录上的垃圾转交给域并归还记录
+    virtual void ReleaseRecord(void* record) = 0;
+
+protected:
+    virtual void* AcquireRecord() = 0;
+
+    // 派生类析构函数的第一步：之后退出的线程不会再访问本域
+    void Unlink()
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.live.erase(_id);
+    }
+
+    void* LocalRecord()
+    {
+        ThreadAttachments& attachments = LocalAttachments();
+        if (attachments.cached_id == _id) return attachments.cached_record;
+        void* record = nullptr;
+        for (auto& item : attachments.items)
+        {
+            if (item.first == _id) record = item.second;
+        }
+        if (!record)
+        {
+            record = AcquireRecord();
+            attachments.items.emplace_back(_id, record);
+        }
+        attachments.cached_id = _id;
+        attachments.cached_record = record;
+        return record;
+    }
+
+    void DropLocalRecord()
+    {
+        ThreadAttachments& attachments = LocalAttachments();
+        auto& items = attachments.items;
+        for (size_t i = 0; i < items.size(); ++i)
+        {
+            if (items[i].first != _id) continue;
+            void* record = items[i].second;
+            items.erase(items.begin() + i);
+            if (attachments.cached_id == _id)
+            {
+                attachments.cached_id = 0;
+                attachments.cached_record = nullptr;
+            }
+            ReleaseRecord(record);
+            return;
+        }
+    }
+
+private:
+    uint64_t _id = 0;
+};
+
+inline ThreadAttachments::~ThreadAttachments()
+{
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto& item : items)
+    {
+        auto it = registry.live.find(item.first);
+        if (it != registry.live.end()) it->second->ReleaseRecord(item.second);
+    }
+}
+
+struct Retired
+{
+    void* ptr;
+    void (*deleter)(void*);
+    uint64_t epoch;
+};
+
+template<typename T>
+void DeleteAs(void* ptr)
+{
+    delete static_cast<T*>(ptr);
+}
+
+inline void AtomicMax(std::atomic<size_t>& target, size_t value)
+{
+    size_t cur = target.load(std::memory_order_relaxed);
+    while (cur < value && !target.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {}
+}
+}
+
+struct ReclaimStats
+{
+    uint64_t retired = 0;
+    uint64_t reclaimed = 0;
+    size_t peak_pending = 0;  // 单个线程未回收对象数的峰值
+
+    uint64_t Pending() const { return retired - reclaimed; }
+};
+
+// 基于纪元的回收
+// 全局纪元单调递增；线程进入临界区时把当前纪元写到自己的记录里
+// 所有活跃线程都追上当前纪元后全局纪元才能推进；在纪元 e 退休的对象，等全局纪元到 e + 2 时一定没有读者
+class EpochDomain : public reclaim_detail::DomainBase
+{
+    struct Record;
+
+public:
+    static constexpr size_t kMaxThreads = 128;
+    static constexpr size_t kScanThreshold = 64;  // 每退休这么多对象尝试推进纪元并回收一次
+    static constexpr size_t kMaxPending = 4096;   // 每线程 limbo 列表上限，超过后在临界区外阻塞回收
+
+    EpochDomain() = default;
+
+    ~EpochDomain() override
+    {
+        Unlink();
+        // 此时不应再有线程在临界区内，剩余垃圾全部释放
+        for (size_t i = 0; i < kMaxThreads; ++i)
+        {
+            for (auto& retired : _records[i].limbo) FreeOne(retired);
+            _records[i].limbo.clear();
+        }
+        for (auto& retired : _orphans) FreeOne(retired);
+        _orphans.clear();
+    }
+
+    static EpochDomain& Global()
+    {
+        static EpochDomain domain;
+        return domain;
+    }
+
+    class Guard
+    {
+    public:
+        explicit Guard(EpochDomain& domain) : _domain(domain), _record(domain.Local()) { _domain.Enter(_record); }
+        ~Guard() { _domain.Exit(_record); }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        // 纪元保护的是整个临界区，读取共享指针不需要额外操作
+        template<typename T>
+        T* Protect(int, const std::atomic<T*>& src) { return src.load(std::memory_order_acquire); }
+
+    private:
+        EpochDomain& _domain;
+        Record* _record;
+    };
+
+    void AttachThread() { Local(); }
+    void DetachThread() { DropLocalRecord(); }
+
+    template<typename T>
+    void Retire(T* ptr) { Retire(ptr, &reclaim_detail::DeleteAs<T>); }
+
+    void Retire(void* ptr, void (*deleter)(void*))
+    {
+        Record* record = Local();
+        record->limbo.push_back({ptr, deleter, _global.load(std::memory_order_seq_cst)});
+        _retired.fetch_add(1, std::memory_order_relaxed);
+        reclaim_detail::AtomicMax(_peak_pending, record->limbo.size());
+        if (++record->since_scan >= kScanThreshold)
+        {
+            record->since_scan = 0;
+            TryAdvance();
+            ReclaimLocal(record);
+        }
+        // 自己在临界区内时会挡住纪元推进，超限的部分留到退出临界区时处理
+        if (record->nesting == 0) Throttle(record);
+    }
+
+    // 尽力回收本线程和已退出线程留下的垃圾
+    void Collect()
+    {
+        for (int i = 0; i < 3; ++i) TryAdvance();
+        Record* record = Local();
+        if (record->nesting == 0) ReclaimLocal(record);
+        ReclaimOrphans();
+    }
+
+    ReclaimStats Stats() const
+    {
+        ReclaimStats stats;
+        stats.retired = _retired.load(std::memory_order_relaxed);
+        stats.reclaimed = _reclaimed.load(std::memory_order_relaxed);
+        stats.peak_pending = _peak_pending.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    uint64_t Epoch() const { return _global.load(std::memory_order_relaxed); }
+
+    void ReleaseRecord(void* ptr) override
+    {
+        Record* record = static_cast<Record*>(ptr);
+        record->epoch.store(kQuiescent, std::memory_order_release);
+        TryAdvance();
+        ReclaimLocal(record);
+        if (!record->limbo.empty())
+        {
+            std::lock_guard<std::mutex> lock(_orphan_mutex);
+            _orphans.insert(_orphans.end(), record->limbo.begin(), record->limbo.end());
+            record->limbo.clear();
+        }
+        record->nesting = 0;
+        record->since_scan = 0;
+        record->in_use.store(false, std::memory_order_release);
+    }
+
+private:
+    static constexpr uint64_t kQuiescent = 0;
+
+    struct alignas(64) Record
+    {
+        std::atomic<uint64_t> epoch{kQuiescent};
+        std::atomic<bool> in_use{false};
+        int nesting = 0;
+        size_t since_scan = 0;
+        std::deque<reclaim_detail::Retired> limbo;  // 按退休纪元有序
+    };
+
+    Record* Local() { return static_cast<Record*>(LocalRecord()); }
+
+    void* AcquireRecord() override
+    {
+        for (size_t i = 0; i < kMaxThreads; ++i)
+        {
+            bool expected = false;
+            if (!_records[i].in_use.load(std::memory_order_relaxed) &&
+                _records[i].in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+            {
+                size_t high = _high_water.load(std::memory_order_relaxed);
+                while (high < i + 1 && !_high_water.compare_exchange_weak(high, i + 1)) {}
+                return &_records[i];
+            }
+        }
+        throw std::runtime_error("EpochDomain: too many threads");
+    }
+
+    void Enter(Record* record)
+    {
+        if (record->nesting++ > 0) return;
+        // 发布纪元后重新检查，保证发布时全局纪元没有变化，之后读到的指针不会被当前纪元之前的回收释放
+        uint64_t epoch = _global.load(std::memory_order_seq_cst);
+        while (true)
+        {
+            record->epoch.store(epoch, std::memory_order_seq_cst);
+            uint64_t now = _global.load(std::memory_order_seq_cst);
+            if (now == epoch) break;
+            epoch = now;
+        }
+    }
+
+    void Exit(Record* record)
+    {
+        if (--record->nesting > 0) return;
+        record->epoch.store(kQuiescent, std::memory_order_release);
+        if (record->limbo.size() > kMaxPending) Throttle(record);
+    }
+
+    // 垃圾有上限：超过后推进纪元直到降回上限以内，期间当前线程不产生新的垃圾
+    void Throttle(Record* record)
+    {
+        while (record->limbo.size() > kMaxPending)
+        {
+            TryAdvance();
+            if (ReclaimLocal(record) == 0) std::this_thread::yield();
+        }
+    }
+
+    // 所有活跃线程都已经看到当前纪元时推进一步
+    void TryAdvance()
+    {
+        uint64_t epoch = _global.load(std::memory_order_seq_cst);
+        size_t high = _high_water.load(std::memory_order_acquire);
+        for (size_t i = 0; i < high; ++i)
+        {
+            if (!_records[i].in_use.load(std::memory_order_acquire)) continue;
+            uint64_t local = _records[i].epoch.load(std::memory_order_seq_cst);
+            if (local != kQuiescent && local != epoch) return;
+        }
+        _global.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+    }
+
+    size_t ReclaimLocal(Record* record)
+    {
+        uint64_t global = _global.load(std::memory_order_seq_cst);
+        size_t freed = 0;
+        while (!record->limbo.empty() && record->limbo.front().epoch + 2 <= global)
+        {
+            FreeOne(record->limbo.front());
+            record->limbo.pop_front();
+            ++freed;
+        }
+        return freed;
+    }
+
+    void ReclaimOrphans()
+    {
+        std::unique_lock<std::mutex> lock(_orphan_mutex, std::try_to_lock);
+        if (!lock.owns_lock() || _orphans.empty()) return;
+        uint64_t global = _global.load(std::memory_order_seq_cst);
+        auto keep = std::partition(_orphans.begin(), _orphans.end(),
+                                   [global](const reclaim_detail::Retired& r) { return r.epoch + 2 > global; });
+        for (auto it = keep; it != _orphans.end(); ++it) FreeOne(*it);
+        _orphans.erase(keep, _orphans.end());
+    }
+
+    void FreeOne(const reclaim_detail::Retired& retired)
+    {
+        retired.deleter(retired.ptr);
+        _reclaimed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    alignas(64) std::atomic<uint64_t> _global{1};
+    std::atomic<size_t> _high_water{0};
+    Record _records[kMaxThreads];
+
+    std::mutex _orphan_mutex;
+    std::vector<reclaim_detail::Retired> _orphans;  // 已退出线程留下的垃圾
+
+    std::atomic<uint64_t> _retired{0};
+    std::atomic<uint64_t> _reclaimed{0};
+    std::atomic<size_t> _peak_pending{0};
+};
+
+// 风险指针
+// 每个线程有 kHazardsPerThread 个槽位，读取共享指针前先发布到槽位里
+// 退休列表达到阈值时扫描所有槽位，没有被任何槽位引用的对象直接释放
+// 每线程未回收的对象数不超过阈值，与读线程是否卡住无关
+class HazardDomain : public reclaim_detail::DomainBase
+{
+    struct Record;
+
+public:
+    static constexpr size_t kMaxThreads = 128;
+    static constexpr size_t kHazardsPerThread = 4;
+    static constexpr size_t kSlotsPerGuard = 2;
+    static constexpr size_t kScanThreshold = 64;
+
+    HazardDomain() = default;
+
+    ~HazardDomain() override
+    {
+        Unlink();
+        for (size_t i = 0; i < kMaxThreads; ++i)
+        {
+            for (auto& retired : _records[i].retired) FreeOne(retired);
+            _records[i].retired.clear();
+        }
+        for (auto& retired : _orphans) FreeOne(retired);
+        _orphans.clear();
+    }
+
+    static HazardDomain& Global()
+    {
+        static HazardDomain domain;
+        return domain;
+    }
+
+    // 每个 Guard 占用本线程的 kSlotsPerGuard 个槽位，析构时清空
+    class Guard
+    {
+    public:
+        explicit Guard(HazardDomain& domain) : _record(domain.Local())
+        {
+            if (_record->used + kSlotsPerGuard > kHazardsPerThread)
+            {
+                throw std::runtime_error("HazardDomain: too many nested guards");
+            }
+            _base = _record->used;
+            _record->used += kSlotsPerGuard;
+        }
+
+        ~Guard()
+        {
+            for (size_t i = 0; i < kSlotsPerGuard; ++i)
+            {
+                _record->hazards[_base + i].store(nullptr, std::memory_order_release);
+            }
+            _record->used -= kSlotsPerGuard;
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        // 发布后重新读取，确认发布时指针仍然挂在结构上
+        template<typename T>
+        T* Protect(int slot, const std::atomic<T*>& src)
+        {
+            std::atomic<void*>& hazard = _record->hazards[_base + slot];
+            T* ptr = src.load(std::memory_order_relaxed);
+            while (true)
+            {
+                hazard.store(ptr, std::memory_order_seq_cst);
+                T* again = src.load(std::memory_order_seq_cst);
+                if (again == ptr) return ptr;
+                ptr = again;
+            }
+        }
+
+    private:
+        Record* _record;
+        size_t _base = 0;
+    };
+
+    void AttachThread() { Local(); }
+    void DetachThread() { DropLocalRecord(); }
+
+    template<typename T>
+    void Retire(T* ptr) { Retire(ptr, &reclaim_detail::DeleteAs<T>); }
+
+    void Retire(void* ptr, void (*deleter)(void*))
+    {
+        Record* record = Local();
+        record->retired.push_back({ptr, deleter, 0});
+        _retired.fetch_add(1, std::memory_order_relaxed);
+        reclaim_detail::AtomicMax(_peak_pending, record->retired.size());
+        if (record->retired.size() >= Threshold()) Scan(record->retired);
+    }
+
+    void Collect()
+    {
+        Scan(Local()->retired);
+        std::unique_lock<std::mutex> lock(_orphan_mutex, std::try_to_lock);
+        if (lock.owns_lock()) Scan(_orphans);
+    }
+
+    ReclaimStats Stats() const
+    {
+        ReclaimStats stats;
+        stats.retired = _retired.load(std::memory_order_relaxed);
+        stats.reclaimed = _reclaimed.load(std::memory_order_relaxed);
+        stats.peak_pending = _peak_pending.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void ReleaseRecord(void* ptr) override
+    {
+        Record* record = static_cast<Record*>(ptr);
+        for (auto& hazard : record->hazards) hazard.store(nullptr, std::memory_order_release);
+        Scan(record->retired);
+        if (!record->retired.empty())
+        {
+            std::lock_guard<std::mutex> lock(_orphan_mutex);
+            _orphans.insert(_orphans.end(), record->retired.begin(), record->retired.end());
+            record->retired.clear();
+        }
+        record->used = 0;
+        record->in_use.store(false, std::memory_order_release);
+    }
+
+private:
+    struct alignas(64) Record
+    {
+        std::atomic<void*> hazards[kHazardsPerThread] = {};
+        std::atomic<bool> in_use{false};
+        size_t used = 0;
+        std::vector<reclaim_detail::Retired> retired;
+    };
+
+    Record* Local() { return static_cast<Record*>(LocalRecord()); }
+
+    void* AcquireRecord() override
+    {
+        for (size_t i = 0; i < kMaxThreads; ++i)
+        {
+            bool expected = false;
+            if (!_records[i].in_use.load(std::memory_order_relaxed) &&
+                _records[i].in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+            {
+                size_t high = _high_water.load(std::memory_order_relaxed);
+                while (high < i + 1 && !_high_water.compare_exchange_weak(high, i + 1)) {}
+                return &_records[i];
+            }
+        }
+        throw std::runtime_error("HazardDomain: too many threads");
+    }
+
+    // 阈值随线程数增长，保证每次扫描至少能释放一半
+    size_t Threshold() const
+    {
+        return std::max(kScanThreshold, 2 * kHazardsPerThread * _high_water.load(std::memory_order_relaxed));
+    }
+
+    void Scan(std::vector<reclaim_detail::Retired>& list)
+    {
+        if (list.empty()) return;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::vector<void*> hazards;
+        size_t high = _high_water.load(std::memory_order_acquire);
+        for (size_t i = 0; i < high; ++i)
+        {
+            for (auto& hazard : _records[i].hazards)
+            {
+                void* ptr = hazard.load(std::memory_order_seq_cst);
+                if (ptr) hazards.push_back(ptr);
+            }
+        }
+        std::sort(hazards.begin(), hazards.end());
+        auto keep = std::partition(list.begin(), list.end(), [&hazards](const reclaim_detail::Retired& r) {
+            return std::binary_search(hazards.begin(), hazards.end(), r.ptr);
+        });
+        for (auto it = keep; it != list.end(); ++it) FreeOne(*it);
+        list.erase(keep, list.end());
+    }
+
+    void FreeOne(const reclaim_detail::Retired& retired)
+    {
+        retired.deleter(retired.ptr);
+        _reclaimed.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::atomic<size_t> _high_water{0};
+    Record _records[kMaxThreads];
+
+    std::mutex _orphan_mutex;
+    std::vector<reclaim_detail::Retired> _orphans;
+
+    std::atomic<uint64_t> _retired{0};
+    std::atomic<uint64_t> _reclaimed{0};
+    std::atomic<size_t> _peak_pending{0};
+};
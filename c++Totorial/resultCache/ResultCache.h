@@ -0,0 +1,369 @@
+#pragma once
+
+// 模块结果缓存：键是输入内容的哈希，值是序列化后的输出
+//   - xxh::hash64：xxHash64，对序列化后的输入（模块名 + 版本号 + 输入）求哈希，作为缓存的键
+//   - Serialize / Deserialize：算术类型按字节写入，string/vector 先写长度再写内容
+//       同一套函数既用于计算输入哈希，也用于把输出写入缓存
+//       Deserialize 的每次读取都检查剩余长度，数据被截断或损坏时返回 false，不会读出缓冲区
+//   - ResultCache：按字节数限制大小的 LRU，可选落盘目录
+//       内存未命中时查磁盘，命中后重新放回内存，下次启动的重复构建也能复用
+//       磁盘文件带头部（魔数、格式版本、键、长度），任何一项对不上都按未命中处理
+//       磁盘读写都在锁外进行，查内存的模块不会排在别人的文件 I/O 后面；
+//       磁盘层的任何失败（目录建不了、写不进、改名失败）只会让缓存少命中，不会让计算成功的模块失败
+//
+// 用法见 DAG/dag_pretask.cpp 的 memo_module 和 threadPool/DAGThreadPool.cpp 的 MemoModule
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace xxh
+{
+const uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+const uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+const uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+inline uint64_t read64(const unsigned char* p) { uint64_t v; memcpy(&v, p, 8); return v; }
+inline uint32_t read32(const unsigned char* p) { uint32_t v; memcpy(&v, p, 4); return v; }
+
+inline uint64_t round(uint64_t acc, uint64_t input)
+{
+    acc += input * kPrime2;
+    acc = rotl(acc, 31);
+    return acc * kPrime1;
+}
+
+inline uint64_t merge(uint64_t acc, uint64_t val)
+{
+    acc ^= round(0, val);
+    return acc * kPrime1 + kPrime4;
+}
+
+inline uint64_t hash64(const void* data, size_t len, uint64_t seed = 0)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + len;
+    uint64_t h;
+    if (len >= 32)
+    {
+        uint64_t v1 = seed + kPrime1 + kPrime2;
+        uint64_t v2 = seed + kPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - kPrime1;
+        do
+        {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+            p += 32;
+        } while (p + 32 <= end);
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge(h, v1);
+        h = merge(h, v2);
+        h = merge(h, v3);
+        h = merge(h, v4);
+    }
+    else
+    {
+        h = seed + kPrime5;
+    }
+    h += len;
+    for (; p + 8 <= end; p += 8)
+    {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * kPrime1 + kPrime4;
+    }
+    if (p + 4 <= end)
+    {
+        h ^= uint64_t(read32(p)) * kPrime1;
+        h = rotl(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p < end; ++p)
+    {
+        h ^= (*p) * kPrime5;
+        h = rotl(h, 11) * kPrime1;
+    }
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+}
+
+template<typename T>
+typename std::enable_if<std::is_arithmetic<T>::value>::type Serialize(std::string& out, const T& v)
+{
+    out.append(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+inline void Serialize(std::string& out, const std::string& v)
+{
+    Serialize(out, uint64_t(v.size()));
+    out.append(v);
+}
+template<typename T>
+void Serialize(std::string& out, const std::vector<T>& v)
+{
+    Serialize(out, uint64_t(v.size()));
+    for (const T& item : v) Serialize(out, item);
+}
+
+// 反序列化的读取位置，只能在 [begin, end) 内前进
+class ByteReader
+{
+public:
+    explicit ByteReader(const std::string& data) : _p(data.data()), _end(data.data() + data.size()) {}
+
+    bool Read(void* dst, size_t bytes)
+    {
+        if (bytes > Remaining()) return false;
+        memcpy(dst, _p, bytes);
+        _p += bytes;
+        return true;
+    }
+    size_t Remaining() const { return size_t(_end - _p); }
+    // 恰好读完：多出来的字节同样说明数据和类型对不上
+    bool Done() const { return _p == _end; }
+
+private:
+    const char* _p;
+    const char* _end;
+};
+
+template<typename T>
+typename std::enable_if<std::is_arithmetic<T>::value, bool>::type Deserialize(ByteReader& in, T& v)
+{
+    return in.Read(&v, sizeof(T));
+}
+inline bool Deserialize(ByteReader& in, std::string& v)
+{
+    uint64_t size = 0;
+    if (!Deserialize(in, size) || size > in.Remaining()) return false;
+    v.resize(size);
+    return in.Read(&v[0], size);
+}
+template<typename T>
+bool Deserialize(ByteReader& in, std::vector<T>& v)
+{
+    uint64_t size = 0;
+    // 每个元素至少占 1 字节，先用剩余长度挡住损坏的长度字段，避免按它分配巨大的内存
+    if (!Deserialize(in, size) || size > in.Remaining()) return false;
+    v.resize(size);
+    for (T& item : v)
+    {
+        if (!Deserialize(in, item)) return false;
+    }
+    return true;
+}
+
+class ResultCache
+{
+public:
+    explicit ResultCache(size_t capacity_bytes, std::string disk_dir = "")
+        : _capacity(capacity_bytes), _disk_dir(std::move(disk_dir))
+    {
+        // 目录建不了就只用内存
+        std::error_code ec;
+        if (!_disk_dir.empty() && !std::filesystem::create_directories(_disk_dir, ec) && ec) _disk_dir.clear();
+    }
+
+    // 取出 key 对应的结果交给 decode(const std::string&) 解码，decode 返回 false 表示数据与期望的类型对不上
+    // 这种条目会被删除，按未命中计数，调用方重新计算后 Put 覆盖即可
+    template<typename Decode>
+    bool Get(uint64_t key, Decode&& decode)
+    {
+        std::string value;
+        size_t* counter = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto it = _index.find(key);
+            if (it != _index.end())
+            {
+                // 命中：移到链表头部
+                _lru.splice(_lru.begin(), _lru, it->second);
+                value = it->second->second;
+                counter = &_hits;
+                ++_hits;
+            }
+        }
+        if (!counter)
+        {
+            // 内存未命中：在锁外读磁盘，读到后再放回内存
+            bool loaded = LoadFromDisk(key, value);
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!loaded)
+            {
+                ++_misses;
+                return false;
+            }
+            Insert(key, value);
+            counter = &_disk_hits;
+            ++_disk_hits;
+        }
+        // 解码在锁外进行，不挡住其他模块查缓存
+        if (decode(static_cast<const std::string&>(value))) return true;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            --*counter;
+            ++_misses;
+            RemoveFromMemory(key);
+        }
+        RemoveFromDisk(key);
+        return false;
+    }
+
+    void Put(uint64_t key, const std::string& value)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            Insert(key, value);
+        }
+        SaveToDisk(key, value);
+    }
+
+    // 只清空内存部分，用来模拟进程重启
+    void ClearMemory()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _lru.clear();
+        _index.clear();
+        _size = 0;
+    }
+
+    size_t Hits() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _hits;
+    }
+    size_t DiskHits() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _disk_hits;
+    }
+    size_t Misses() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _misses;
+    }
+
+private:
+    // 磁盘文件头，后面紧跟 length 字节的结果
+    struct DiskHeader
+    {
+        uint32_t magic;
+        uint32_t format;
+        uint64_t key;
+        uint64_t length;
+    };
+    static constexpr uint32_t kMagic = 0x4F4D454D;  // "MEMO"
+    static constexpr uint32_t kFormat = 1;
+
+    void Insert(uint64_t key, const std::string& value)
+    {
+        RemoveFromMemory(key);
+        if (value.size() > _capacity) return;
+        _lru.emplace_front(key, value);
+        _index[key] = _lru.begin();
+        _size += value.size();
+        // 超出容量时淘汰最久未使用的结果
+        while (_size > _capacity)
+        {
+            _size -= _lru.back().second.size();
+            _index.erase(_lru.back().first);
+            _lru.pop_back();
+        }
+    }
+
+    void RemoveFromMemory(uint64_t key)
+    {
+        auto it = _index.find(key);
+        if (it == _index.end()) return;
+        _size -= it->second->second.size();
+        _lru.erase(it->second);
+        _index.erase(it);
+    }
+
+    void RemoveFromDisk(uint64_t key)
+    {
+        if (_disk_dir.empty()) return;
+        std::error_code ec;
+        std::filesystem::remove(DiskPath(key), ec);
+    }
+
+    std::string DiskPath(uint64_t key) const
+    {
+        std::stringstream ss;
+        ss << _disk_dir << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+        return ss.str();
+    }
+
+    // 文件被截断、来自别的格式版本或者存的是别的键（文件被改名、复制）时都返回 false
+    bool LoadFromDisk(uint64_t key, std::string& value)
+    {
+        if (_disk_dir.empty()) return false;
+        std::ifstream ifs(DiskPath(key), std::ios::binary);
+        if (!ifs) return false;
+        std::string data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+        DiskHeader header;
+        if (data.size() < sizeof(header)) return false;
+        memcpy(&header, data.data(), sizeof(header));
+        if (header.magic != kMagic || header.format != kFormat || header.key != key ||
+            header.length != data.size() - sizeof(header))
+        {
+            return false;
+        }
+        value.assign(data, sizeof(header), std::string::npos);
+        return true;
+    }
+
+    // 失败时放弃这次落盘，下次启动按未命中重新计算
+    void SaveToDisk(uint64_t key, const std::string& value)
+    {
+        if (_disk_dir.empty()) return;
+        // 先写临时文件再改名，避免并发读到写了一半的结果；临时文件名各不相同，同一个键并发 Put 不会互相覆盖
+        std::string path = DiskPath(key);
+        std::string tmp = path + ".tmp" + std::to_string(_tmp_seq.fetch_add(1, std::memory_order_relaxed));
+        bool written;
+        {
+            DiskHeader header{kMagic, kFormat, key, value.size()};
+            std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+            ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            ofs.write(value.data(), value.size());
+            ofs.close();
+            written = ofs.good();
+        }
+        std::error_code ec;
+        if (written) std::filesystem::rename(tmp, path, ec);
+        if (!written || ec) std::filesystem::remove(tmp, ec);
+    }
+
+private:
+    size_t _capacity;
+    size_t _size = 0;
+    std::string _disk_dir;
+    std::list<std::pair<uint64_t, std::string>> _lru;
+    std::unordered_map<uint64_t, std::list<std::pair<uint64_t, std::string>>::iterator> _index;
+    mutable std::mutex _mutex;
+    size_t _hits = 0;
+    size_t _disk_hits = 0;
+    size_t _misses = 0;
+    std::atomic<uint64_t> _tmp_seq{0};
+};
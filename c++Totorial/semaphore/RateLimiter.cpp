@@ -0,0 +1,142 @@
+#define DAG_THREAD_POOL_NO_MAIN
+#include "../threadPool/DAGThreadPool.cpp"
+#include <iomanip>
+
+// 2 倍过载下的准入控制：任务是 1ms 的 IO 等待，先测出线程池的吞吐能力 C，
+// 再以 2C 的速率开环提交 2 秒，统计每个被接受任务从计划提交到执行完的延迟
+//   none:   不做准入控制，队列无限增长
+//   reject: 令牌桶限速到 0.9C，排队延迟超过 5ms 直接拒绝
+//   defer:  同上，但令牌不够时允许延后最多 10ms 再执行
+//
+// 编译：g++ -std=c++17 -O2 -pthread RateLimiter.cpp
+// 运行：./a.out [workers] [seconds]
+
+void IoTask()
+{
+    this_thread::sleep_for(chrono::milliseconds(1));
+}
+
+// 线程池能承受的吞吐（任务/秒）
+double MeasureCapacity(int workers)
+{
+    const int tasks = 1000;
+    atomic<int> done{0};
+    auto start = chrono::steady_clock::now();
+    {
+        ThreadPool tp(workers);
+        for (int i = 0; i < tasks; ++i)
+        {
+            tp.PutTask([&done]() { IoTask(); done.fetch_add(1); });
+        }
+    }
+    return tasks / chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+struct OverloadResult
+{
+    long offered = 0;
+    long accepted = 0;
+    long rejected = 0;
+    vector<int64_t> latencies;  // 纳秒
+};
+
+OverloadResult RunOverload(int workers, double rate, double seconds, AdmissionHook hook)
+{
+    OverloadResult result;
+    long total = long(rate * seconds);
+    result.latencies.assign(total, -1);
+    atomic<long> done{0};
+    {
+        ThreadPool tp(workers);
+        tp.SetAdmission(move(hook));
+        auto start = chrono::steady_clock::now();
+        auto interval = chrono::nanoseconds(int64_t(1e9 / rate));
+        // 每毫秒补齐一批，按计划时间计算延迟，提交线程自己的抖动也算在里面
+        for (long i = 0; i < total;)
+        {
+            auto now = chrono::steady_clock::now();
+            for (; i < total && start + interval * i <= now; ++i)
+            {
+                auto planned = start + interval * i;
+                int64_t* slot = &result.latencies[i];
+                bool ok = tp.Submit([slot, planned, &done]() {
+                    IoTask();
+                    *slot = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - planned).count();
+                    done.fetch_add(1);
+                });
+                if (ok) ++result.accepted;
+                else ++result.rejected;
+            }
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        result.offered = total;
+    }
+    result.latencies.erase(remove(result.latencies.begin(), result.latencies.end(), -1), result.latencies.end());
+    sort(result.latencies.begin(), result.latencies.end());
+    return result;
+}
+
+double PercentileMs(const vector<int64_t>& sorted, double q)
+{
+    if (sorted.empty()) return 0;
+    return sorted[min(sorted.size() - 1, size_t(q * sorted.size()))] / 1e6;
+}
+
+void Print(const string& name, const OverloadResult& r)
+{
+    cout << "  " << left << setw(8) << name << right
+         << " accepted " << setw(6) << r.accepted << " rejected " << setw(6) << r.rejected
+         << fixed << setprecision(2)
+         << "   p50 " << setw(8) << PercentileMs(r.latencies, 0.50) << " ms"
+         << "   p99 " << setw(8) << PercentileMs(r.latencies, 0.99) << " ms"
+         << "   max " << setw(8) << PercentileMs(r.latencies, 1.0) << " ms" << endl;
+    cout.unsetf(ios::fixed);
+}
+
+// 加权获取与异步获取：代价 4 的任务消耗 4 个令牌；令牌不够时任务进入线程池的延时队列，不占用工作线程
+void testWeighted()
+{
+    TokenBucket bucket(100, 10);  // 100 令牌/秒，最多攒 10 个
+    ThreadPool tp(2);
+    auto start = chrono::steady_clock::now();
+    atomic<int> done{0};
+    mutex mtx;
+    vector<pair<int, double>> finished;
+    for (int i = 0; i < 6; ++i)
+    {
+        double cost = i % 2 ? 4 : 1;
+        bucket.AcquireAsync(tp, [&, i]() {
+            double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            lock_guard<mutex> lock(mtx);
+            finished.emplace_back(i, ms);
+            done.fetch_add(1);
+        }, cost);
+    }
+    while (done.load() < 6) this_thread::sleep_for(chrono::milliseconds(5));
+    cout << "weighted async acquire (100/s, burst 10, costs 1,4,1,4,1,4):" << endl;
+    for (auto& f : finished) cout << "  task " << f.first << " ran at " << fixed << setprecision(1) << f.second << " ms" << endl;
+    cout.unsetf(ios::fixed);
+}
+
+int main(int argc, char** argv)
+{
+    int workers = argc > 1 ? atoi(argv[1]) : 4;
+    double seconds = argc > 2 ? atof(argv[2]) : 2.0;
+
+    testWeighted();
+
+    double capacity = MeasureCapacity(workers);
+    double offered = 2 * capacity;
+    cout << workers << " workers, capacity " << int(capacity) << " tasks/s, offered " << int(offered) << " tasks/s for " << seconds << " s:" << endl;
+
+    Print("none", RunOverload(workers, offered, seconds, nullptr));
+
+    TokenBucket reject_bucket(0.9 * capacity, 0.9 * capacity * 0.01);
+    Print("reject", RunOverload(workers, offered, seconds,
+        AdmissionPolicy(reject_bucket, chrono::milliseconds(5), chrono::nanoseconds(0))));
+
+    TokenBucket defer_bucket(0.9 * capacity, 0.9 * capacity * 0.01);
+    Print("defer", RunOverload(workers, offered, seconds,
+        AdmissionPolicy(defer_bucket, chrono::milliseconds(5), chrono::milliseconds(10))));
+    return 0;
+}
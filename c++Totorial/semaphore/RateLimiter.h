@@ -0,0 +1,227 @@
+#pragma once
+
+// 限速与准入控制
+//   - Semaphore 限制的是同时在跑的任务数，TokenBucket 限制的是单位时间内放进来的任务量
+//   - TokenBucket：无锁令牌桶，按 GCRA（理论到达时间）实现，整个状态只有一个原子变量
+//       rate 个令牌/秒匀速补充，最多攒 burst 个；每次获取可以指定消耗几个令牌（按任务代价加权）
+//   - AcquireAsync：令牌不够时不占用工作线程等待，而是把任务交给线程池的延时队列，到点再执行
+//   - AdmissionPolicy：给线程池的准入钩子，根据令牌桶和当前排队延迟决定接受、延后还是拒绝
+//   - DelayedQueue / AdmissionGate：线程池共用的延时队列和准入控制
+//       threadPool/ 下的 threadPool、priorityThreadPool、DAGThreadPool 各持有一份，
+//       对外提供延时提交、SetAdmission / Submit / QueueLatency
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+class TokenBucket
+{
+public:
+    TokenBucket(double rate_per_sec, double burst)
+    {
+        if (rate_per_sec <= 0 || burst < 1) {
+            throw std::invalid_argument("Invalid token bucket parameters");
+        }
+        _ns_per_token = 1e9 / rate_per_sec;
+        _burst_ns = int64_t(burst * _ns_per_token);
+        _tat.store(NowNs(), std::memory_order_relaxed);
+    }
+
+    // 预订 cost 个令牌，返回还需要等待的时间；需要等待超过 max_wait 时不预订，返回 -1
+    // 预订成功后令牌已经扣除，调用方等够返回的时间再执行即可
+    int64_t Reserve(double cost, int64_t max_wait_ns)
+    {
+        int64_t now = NowNs();
+        int64_t increment = int64_t(std::llround(cost * _ns_per_token));
+        int64_t tat = _tat.load(std::memory_order_relaxed);
+        while (true)
+        {
+            int64_t next = std::max(tat, now) + increment;
+            int64_t wait = std::max<int64_t>(next - now - _burst_ns, 0);
+            if (wait > max_wait_ns) return -1;
+            if (_tat.compare_exchange_weak(tat, next, std::memory_order_relaxed)) return wait;
+        }
+    }
+
+    // 有足够令牌就扣除并返回 true，否则不扣除
+    bool TryAcquire(double cost = 1.0) { return Reserve(cost, 0) == 0; }
+
+    // 阻塞直到拿到令牌
+    void Acquire(double cost = 1.0)
+    {
+        int64_t wait = Reserve(cost, INT64_MAX);
+        if (wait > 0) std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+    }
+
+    // 异步获取：立即预订，任务交给线程池的延时队列，到点后由工作线程执行
+    template<typename Pool, typename F>
+    void AcquireAsync(Pool& pool, F&& task, double cost = 1.0)
+    {
+        int64_t wait = Reserve(cost, INT64_MAX);
+        pool.PutTaskAfter(std::chrono::nanoseconds(wait), std::forward<F>(task));
+    }
+
+    // 当前可用的令牌数（近似值，只用于观察）
+    double Available() const
+    {
+        int64_t now = NowNs();
+        int64_t tat = std::max(_tat.load(std::memory_order_relaxed), now);
+        return double(_burst_ns - (tat - now)) / _ns_per_token;
+    }
+
+    static int64_t NowNs()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+private:
+    double _ns_per_token;
+    int64_t _burst_ns;
+    // 理论到达时间：令牌恰好用完的时刻，早于当前时间说明桶是满的
+    std::atomic<int64_t> _tat{0};
+};
+
+// 准入决定：接受、延后 delay 再执行、拒绝
+struct Admission
+{
+    enum Kind { kAccept, kDefer, kReject };
+
+    Kind kind;
+    std::chrono::nanoseconds delay{0};
+
+    static Admission Accept() { return Admission{kAccept}; }
+    static Admission Defer(std::chrono::nanoseconds delay) { return Admission{kDefer, delay}; }
+    static Admission Reject() { return Admission{kReject}; }
+};
+
+// 常用的准入策略：
+//   1. 排队延迟已经超过 max_queue_latency：队列在变长，直接拒绝，不再往里放
+//   2. 令牌桶有令牌：接受
+//   3. 令牌不够但等待不超过 max_defer：预订令牌，延后执行
+//   4. 否则拒绝
+class AdmissionPolicy
+{
+public:
+    AdmissionPolicy(TokenBucket& bucket, std::chrono::nanoseconds max_queue_latency, std::chrono::nanoseconds max_defer)
+        : _bucket(bucket), _max_queue_latency(max_queue_latency), _max_defer(max_defer) {}
+
+    Admission operator()(std::chrono::nanoseconds queue_latency, double cost) const
+    {
+        if (queue_latency > _max_queue_latency) return Admission::Reject();
+        int64_t wait = _bucket.Reserve(cost, _max_defer.count());
+        if (wait < 0) return Admission::Reject();
+        if (wait == 0) return Admission::Accept();
+        return Admission::Defer(std::chrono::nanoseconds(wait));
+    }
+
+private:
+    TokenBucket& _bucket;
+    std::chrono::nanoseconds _max_queue_latency;
+    std::chrono::nanoseconds _max_defer;
+};
+
+// 准入钩子：参数是当前排队延迟和任务代价，AdmissionPolicy 就是一种
+using AdmissionHook = std::function<Admission(std::chrono::nanoseconds, double)>;
+
+// 线程池的准入控制：保存钩子，按它的决定把任务直接入队、延后入队或者拒绝
+class AdmissionGate
+{
+public:
+    void Set(AdmissionHook hook)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _hook = std::move(hook);
+    }
+
+    // 没有钩子时全部接受；accept() 直接入队，defer(delay) 交给延时队列，被拒绝时返回 false，任务不会执行
+    template<typename Accept, typename Defer>
+    bool Submit(std::chrono::nanoseconds queue_latency, double cost, Accept&& accept, Defer&& defer)
+    {
+        AdmissionHook hook;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            hook = _hook;
+        }
+        // 钩子在锁外调用，策略里查令牌桶不会挡住其他提交方
+        Admission admission = hook ? hook(queue_latency, cost) : Admission::Accept();
+        switch (admission.kind)
+        {
+        case Admission::kReject:
+            return false;
+        case Admission::kDefer:
+            defer(admission.delay);
+            return true;
+        default:
+            accept();
+            return true;
+        }
+    }
+
+private:
+    std::mutex _mutex;
+    AdmissionHook _hook;
+};
+
+// 线程池的延时队列：按到期时间排序，到期前不占用工作线程，到期后由线程池搬进自己的就绪队列
+// 本身不加锁，由线程池在保护就绪队列的那把锁内调用
+template<typename Task>
+class DelayedQueue
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // 返回 true 表示新任务成了最早到期的一个：正按原来的到期时间睡眠的工作线程要叫醒一个，重新计算等待时间
+    bool Push(std::chrono::nanoseconds delay, Task task)
+    {
+        Clock::time_point due = Clock::now() + delay;
+        bool earliest = _heap.empty() || due < _heap.top().due;
+        _heap.push(Entry{due, std::move(task)});
+        return earliest;
+    }
+
+    bool Empty() const { return _heap.empty(); }
+
+    // 把到期的任务交给 sink(Task&&)，返回个数；all 为 true 时不管是否到期全部交出（线程池停止时，保证提交过的任务都会执行）
+    // 到期的任务只被调用的这一个工作线程看到，它取走一个之后要叫醒别的线程来执行剩下的
+    template<typename Sink>
+    size_t Promote(bool all, Sink&& sink)
+    {
+        size_t promoted = 0;
+        Clock::time_point now = Clock::now();
+        while (!_heap.empty() && (all || _heap.top().due <= now))
+        {
+            sink(std::move(_heap.top().task));
+            _heap.pop();
+            ++promoted;
+        }
+        return promoted;
+    }
+
+    // 就绪队列为空时的睡眠：没有延时任务就一直等通知，否则最多睡到最早的一个到期
+    template<typename CondVar, typename Lock>
+    void Wait(CondVar& cv, Lock& lock) const
+    {
+        if (_heap.empty()) cv.wait(lock);
+        else cv.wait_until(lock, _heap.top().due);
+    }
+
+private:
+    struct Entry
+    {
+        Clock::time_point due;
+        // priority_queue 的 top() 只能拿到 const 引用，mutable 才能在出队前把任务移出来
+        mutable Task task;
+        bool operator<(const Entry& other) const { return due > other.due; }
+    };
+
+    std::priority_queue<Entry> _heap;
+};
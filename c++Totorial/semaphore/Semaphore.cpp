@@ -3,6 +3,8 @@
 #include <mutex>
 #include <condition_variable>
 
+#include "../syncTypes/SyncTypes.h"
+
 
 class Semaphore
 {
@@ -26,10 +28,12 @@ public:
     }
 private:
     std::mutex _mutex; // 互斥锁
-    std::condition_variable _condition; // 条件变量
+    CondVar _condition; // 条件变量
     int _count; // 信号量计数器,可用资源数
 };
 
+// bench/ 下的基准复用本文件的信号量时会定义这个宏
+#ifndef SEMAPHORE_NO_MAIN
 void task(std::shared_ptr<Semaphore> sem)
 {
     sem->wait();
@@ -49,4 +53,4 @@ int main()
 
     return 0;
 }
-
+#endif
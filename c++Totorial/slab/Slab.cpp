@@ -0,0 +1,252 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "Slab.h"
+
+using namespace std;
+
+// slab 分配器 vs glibc malloc
+//   cross-thread: 每个线程分配一批对象交给下一个线程释放（远程释放）
+//   pool:         多个线程向线程池提交 40 字节闭包的任务（std::function + malloc vs SlabTask）
+//   executor:     每轮重建 64 个模块的 visited 表（Executor::ExecuteAll 的临时容器）
+// 每项在单独的子进程里跑，峰值 RSS 互不影响
+//
+// 编译：g++ -std=c++17 -O2 -pthread Slab.cpp
+// 运行：./a.out [threads] [scale]
+
+struct MallocPolicy
+{
+    static constexpr const char* kName = "malloc";
+    static void* Allocate(size_t bytes) { return malloc(bytes); }
+    static void Deallocate(void* p, size_t) { free(p); }
+};
+
+struct SlabPolicy
+{
+    static constexpr const char* kName = "slab";
+    static void* Allocate(size_t bytes) { return SlabHeap::Allocate(bytes); }
+    static void Deallocate(void* p, size_t bytes) { SlabHeap::Deallocate(p, bytes); }
+};
+
+long PeakRssKb()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// 在子进程中运行 bench，bench 返回每秒操作数
+template<typename Bench>
+void RunIsolated(const string& name, const char* mode, Bench bench)
+{
+    cout.flush();
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        double ops = bench();
+        cout << "  " << left << setw(14) << name << setw(8) << mode << right << fixed << setprecision(2)
+             << setw(9) << ops / 1e6 << " Mops/s" << setw(9) << PeakRssKb() / 1024.0 << " MB peak RSS";
+        slab_detail::SlabStats stats = SlabHeap::Stats();
+        if (stats.mapped_slabs) cout << "  (" << stats.MappedBytes() / 1024 << " KB in slabs)";
+        cout << endl;
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+}
+
+template<typename Policy>
+double BenchCrossThread(int threads, long ops)
+{
+    constexpr int kBatch = 256;
+    struct Mailbox
+    {
+        mutex mtx;
+        vector<pair<void*, size_t>> items;
+    };
+    vector<Mailbox> mailboxes(threads);
+    long rounds = ops / threads / kBatch;
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t]() {
+            uint32_t seed = uint32_t(t) * 2654435761u + 1;
+            vector<pair<void*, size_t>> batch, inbox;
+            for (long r = 0; r < rounds; ++r)
+            {
+                batch.clear();
+                for (int i = 0; i < kBatch; ++i)
+                {
+                    seed = seed * 1103515245u + 12345u;
+                    size_t bytes = 16 + (seed >> 16) % 496;
+                    void* p = Policy::Allocate(bytes);
+                    memset(p, 0, 16);
+                    batch.emplace_back(p, bytes);
+                }
+                Mailbox& next = mailboxes[(t + 1) % threads];
+                {
+                    lock_guard<mutex> lock(next.mtx);
+                    next.items.insert(next.items.end(), batch.begin(), batch.end());
+                }
+                {
+                    lock_guard<mutex> lock(mailboxes[t].mtx);
+                    inbox.swap(mailboxes[t].items);
+                }
+                for (auto& item : inbox) Policy::Deallocate(item.first, item.second);
+                inbox.clear();
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    for (auto& mailbox : mailboxes)
+    {
+        for (auto& item : mailbox.items) Policy::Deallocate(item.first, item.second);
+    }
+    return 2.0 * rounds * kBatch * threads / seconds;
+}
+
+// 与 DAGThreadPool.cpp 中 ThreadPool 相同的结构，任务类型作为模板参数
+template<typename TaskT>
+class Pool
+{
+public:
+    explicit Pool(int workers)
+    {
+        for (int i = 0; i < workers; ++i)
+        {
+            _threads.emplace_back([this]() {
+                while (true)
+                {
+                    TaskT task;
+                    {
+                        unique_lock<mutex> lock(_mutex);
+                        _cv.wait(lock, [this]() { return _stop || !_tasks.empty(); });
+                        if (_stop && _tasks.empty()) return;
+                        task = move(_tasks.front());
+                        _tasks.pop_front();
+                    }
+                    task();
+                }
+            });
+        }
+    }
+
+    ~Pool()
+    {
+        {
+            lock_guard<mutex> lock(_mutex);
+            _stop = true;
+        }
+        _cv.notify_all();
+        for (auto& t : _threads) t.join();
+    }
+
+    template<typename F>
+    void PutTask(F&& f)
+    {
+        {
+            lock_guard<mutex> lock(_mutex);
+            _tasks.emplace_back(forward<F>(f));
+        }
+        _cv.notify_one();
+    }
+
+private:
+    deque<TaskT> _tasks;
+    vector<thread> _threads;
+    mutex _mutex;
+    condition_variable _cv;
+    bool _stop = false;
+};
+
+template<typename TaskT>
+double BenchPool(int threads, long tasks)
+{
+    atomic<long> done{0};
+    long per_submitter = tasks / threads;
+    auto start = chrono::steady_clock::now();
+    {
+        Pool<TaskT> pool(threads);
+        vector<thread> submitters;
+        for (int s = 0; s < threads; ++s)
+        {
+            submitters.emplace_back([&, s]() {
+                for (long i = 0; i < per_submitter; ++i)
+                {
+                    array<int, 8> payload{};
+                    payload[0] = s;
+                    payload[7] = int(i);
+                    pool.PutTask([&done, payload]() {
+                        done.fetch_add(payload[0] + payload[7] >= 0 ? 1 : 0, memory_order_relaxed);
+                    });
+                }
+            });
+        }
+        for (auto& s : submitters) s.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return done.load() / seconds;
+}
+
+template<template<typename> class Alloc>
+double BenchExecutorMaps(int threads, long iterations)
+{
+    using VisitedMap = unordered_map<string, bool, hash<string>, equal_to<string>, Alloc<pair<const string, bool>>>;
+    vector<string> names;
+    for (int i = 0; i < 64; ++i) names.push_back("module_" + to_string(i));
+
+    long per_thread = iterations / threads;
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    atomic<long> sink{0};
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&]() {
+            long local = 0;
+            for (long i = 0; i < per_thread; ++i)
+            {
+                VisitedMap visited;
+                for (auto& name : names) visited[name] = true;
+                local += long(visited.size());
+            }
+            sink.fetch_add(local);
+        });
+    }
+    for (auto& w : workers) w.join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    // 每轮 64 次插入
+    return sink.load() / seconds;
+}
+
+int main(int argc, char** argv)
+{
+    int threads = argc > 1 ? atoi(argv[1]) : 4;
+    long scale = argc > 2 ? atol(argv[2]) : 1;
+    cout << threads << " threads:" << endl;
+
+    RunIsolated("cross-thread", MallocPolicy::kName, [&]() { return BenchCrossThread<MallocPolicy>(threads, 4000000 * scale); });
+    RunIsolated("cross-thread", SlabPolicy::kName, [&]() { return BenchCrossThread<SlabPolicy>(threads, 4000000 * scale); });
+    RunIsolated("pool", MallocPolicy::kName, [&]() { return BenchPool<function<void()>>(threads, 500000 * scale); });
+    RunIsolated("pool", SlabPolicy::kName, [&]() { return BenchPool<SlabTask>(threads, 500000 * scale); });
+    RunIsolated("executor", MallocPolicy::kName, [&]() { return BenchExecutorMaps<allocator>(threads, 50000 * scale); });
+    RunIsolated("executor", SlabPolicy::kName, [&]() { return BenchExecutorMaps<SlabAllocator>(threads, 50000 * scale); });
+    return 0;
+}
@@ -0,0 +1,494 @@
+#pragma once
+
+// 线程本地 slab 分配器，给任务闭包、任务组状态和执行期的临时容器用
+//   - 小对象按 2 的幂分成 8 档（16B ~ 2KB），每档由若干 64KB 的 slab 切分而来
+//   - slab 按 64KB 对齐，释放时把指针低位清零就能找到所属 slab，对象本身不带头部
+//   - 每个线程有自己的缓存：分配、以及释放本线程的对象，都只操作 slab 的本地空闲链表，不加锁
+//   - 其他线程释放的对象压入 slab 的远程空闲链表（无锁栈），所有者在本地链表用完时一次性取走
+//   - 全部释放的 slab 交回全局池复用；线程退出时还有对象在用的 slab 放进遗弃列表，由之后需要同档 slab 的线程接管
+//   - 超过 2KB 的请求直接走 ::operator new
+//
+// 释放必须给出尺寸（Deallocate(p, bytes)），SlabAllocator 和 SlabTask 都能给出
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace slab_detail
+{
+constexpr size_t kSlabSize = 64 * 1024;
+constexpr size_t kHeaderSize = 128;
+constexpr size_t kNumClasses = 8;
+constexpr size_t kMaxSmall = size_t(16) << (kNumClasses - 1);
+// 全局池最多缓存的空 slab 数，超出的还给系统
+constexpr size_t kMaxPooledSlabs = 16;
+
+// 16 -> 0, 32 -> 1, ..., 2048 -> 7
+inline size_t ClassOf(size_t bytes)
+{
+    if (bytes <= 16) return 0;
+    return size_t(64 - __builtin_clzll(bytes - 1)) - 4;
+}
+
+inline size_t ClassSize(size_t size_class) { return size_t(16) << size_class; }
+
+class ThreadCache;
+
+struct FreeNode
+{
+    FreeNode* next;
+};
+
+struct Slab
+{
+    // 其他线程释放时只访问这一行
+    alignas(64) std::atomic<FreeNode*> remote{nullptr};
+    std::atomic<ThreadCache*> owner{nullptr};
+
+    // 以下字段只有所有者线程读写
+    alignas(64) FreeNode* local = nullptr;
+    char* bump = nullptr;
+    char* end = nullptr;
+    uint32_t size_class = 0;
+    uint32_t object_size = 0;
+    // 所有者视角下未回收的对象数；远程释放的对象要等 Drain 之后才计入
+    uint32_t used = 0;
+
+    void Init(size_t c)
+    {
+        remote.store(nullptr, std::memory_order_relaxed);
+        local = nullptr;
+        size_class = uint32_t(c);
+        object_size = uint32_t(ClassSize(c));
+        used = 0;
+        bump = reinterpret_cast<char*>(this) + kHeaderSize;
+        end = bump + (kSlabSize - kHeaderSize) / object_size * object_size;
+    }
+
+    void* Pop()
+    {
+        if (!local && bump == end) Drain();
+        if (local)
+        {
+            FreeNode* node = local;
+            local = node->next;
+            ++used;
+            return node;
+        }
+        if (bump != end)
+        {
+            void* p = bump;
+            bump += object_size;
+            ++used;
+            return p;
+        }
+        return nullptr;
+    }
+
+    void Push(void* p)
+    {
+        FreeNode* node = static_cast<FreeNode*>(p);
+        node->next = local;
+        local = node;
+        --used;
+    }
+
+    void PushRemote(void* p)
+    {
+        FreeNode* node = static_cast<FreeNode*>(p);
+        FreeNode* head = remote.load(std::memory_order_relaxed);
+        do
+        {
+            node->next = head;
+        } while (!remote.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // 把远程链表整体接到本地链表前面；只有所有者会取，所以不存在 ABA
+    void Drain()
+    {
+        if (!remote.load(std::memory_order_relaxed)) return;
+        FreeNode* head = remote.exchange(nullptr, std::memory_order_acquire);
+        FreeNode* tail = head;
+        uint32_t count = 1;
+        while (tail->next)
+        {
+            tail = tail->next;
+            ++count;
+        }
+        tail->next = local;
+        local = head;
+        used -= count;
+    }
+
+    bool HasFree() const
+    {
+        return local || bump != end || remote.load(std::memory_order_relaxed);
+    }
+};
+static_assert(sizeof(Slab) <= kHeaderSize, "slab header must fit before the first object");
+
+inline Slab* SlabOf(void* p)
+{
+    return reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(p) & ~uintptr_t(kSlabSize - 1));
+}
+
+class ThreadCache
+{
+public:
+    void* Allocate(size_t c)
+    {
+        Slab* slab = _active[c];
+        if (slab)
+        {
+            if (void* p = slab->Pop()) return p;
+        }
+        return Refill(c);
+    }
+
+    void Free(Slab* slab, void* p)
+    {
+        slab->Push(p);
+        if (slab->used == 0 && slab != _active[slab->size_class]) Release(slab);
+    }
+
+    // 线程退出：空的 slab 交回全局池，其余的留给其他线程接管
+    void Abandon();
+
+private:
+    void* Refill(size_t c);
+    void Release(Slab* slab);
+
+    Slab* _active[kNumClasses] = {};
+    std::vector<Slab*> _slabs[kNumClasses];
+};
+
+struct SlabStats
+{
+    size_t mapped_slabs = 0;     // 向系统申请且尚未归还的 slab
+    size_t pooled_slabs = 0;     // 全局池中的空 slab
+    size_t abandoned_slabs = 0;  // 所有者已退出、等待接管的 slab
+
+    size_t MappedBytes() const { return mapped_slabs * kSlabSize; }
+};
+
+// 全局部分：空 slab 池、遗弃列表，以及线程缓存已析构时使用的后备缓存
+// 故意不析构，静态对象在 main 返回之后释放内存也是安全的
+class Central
+{
+public:
+    static Central& Instance()
+    {
+        static Central* central = new Central();
+        return *central;
+    }
+
+    Slab* Acquire(size_t c, ThreadCache* owner)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto& abandoned = _abandoned[c];
+            for (size_t i = 0; i < abandoned.size(); ++i)
+            {
+                Slab* slab = abandoned[i];
+                if (!slab->HasFree()) continue;
+                abandoned[i] = abandoned.back();
+                abandoned.pop_back();
+                slab->owner.store(owner, std::memory_order_relaxed);
+                return slab;
+            }
+            if (!_pool.empty())
+            {
+                Slab* slab = _pool.back();
+                _pool.pop_back();
+                slab->Init(c);
+                slab->owner.store(owner, std::memory_order_relaxed);
+                return slab;
+            }
+        }
+        void* mem = std::aligned_alloc(kSlabSize, kSlabSize);
+        if (!mem) throw std::bad_alloc();
+        _mapped.fetch_add(1, std::memory_order_relaxed);
+        Slab* slab = new (mem) Slab();
+        slab->Init(c);
+        slab->owner.store(owner, std::memory_order_relaxed);
+        return slab;
+    }
+
+    void Release(Slab* slab)
+    {
+        slab->owner.store(nullptr, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_pool.size() < kMaxPooledSlabs)
+            {
+                _pool.push_back(slab);
+                return;
+            }
+        }
+        slab->~Slab();
+        std::free(slab);
+        _mapped.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void Abandon(Slab* slab)
+    {
+        slab->owner.store(nullptr, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(_mutex);
+        _abandoned[slab->size_class].push_back(slab);
+    }
+
+    void* FallbackAllocate(size_t c)
+    {
+        std::lock_guard<std::mutex> lock(_fallback_mutex);
+        return _fallback.Allocate(c);
+    }
+
+    SlabStats Stats()
+    {
+        SlabStats stats;
+        stats.mapped_slabs = _mapped.load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(_mutex);
+        stats.pooled_slabs = _pool.size();
+        for (auto& abandoned : _abandoned) stats.abandoned_slabs += abandoned.size();
+        return stats;
+    }
+
+private:
+    Central() = default;
+
+    std::mutex _mutex;
+    std::vector<Slab*> _pool;
+    std::vector<Slab*> _abandoned[kNumClasses];
+    std::atomic<size_t> _mapped{0};
+
+    // 后备缓存的 slab 只会收到远程释放，分配时由持锁的线程取回
+    std::mutex _fallback_mutex;
+    ThreadCache _fallback;
+};
+
+// 当前 slab 用完：先在自己的其他 slab 里找空闲（顺带归还已经全部释放的），找不到再向全局要
+inline void* ThreadCache::Refill(size_t c)
+{
+    auto& slabs = _slabs[c];
+    Slab* found = nullptr;
+    for (size_t i = 0; i < slabs.size();)
+    {
+        Slab* slab = slabs[i];
+        slab->Drain();
+        if (slab->used == 0 && found)
+        {
+            slabs[i] = slabs.back();
+            slabs.pop_back();
+            Central::Instance().Release(slab);
+            continue;
+        }
+        if (!found && slab->HasFree()) found = slab;
+        ++i;
+    }
+    if (!found)
+    {
+        found = Central::Instance().Acquire(c, this);
+        slabs.push_back(found);
+    }
+    _active[c] = found;
+    return found->Pop();
+}
+
+inline void ThreadCache::Release(Slab* slab)
+{
+    auto& slabs = _slabs[slab->size_class];
+    for (size_t i = 0; i < slabs.size(); ++i)
+    {
+        if (slabs[i] != slab) continue;
+        slabs[i] = slabs.back();
+        slabs.pop_back();
+        break;
+    }
+    Central::Instance().Release(slab);
+}
+
+inline void ThreadCache::Abandon()
+{
+    for (size_t c = 0; c < kNumClasses; ++c)
+    {
+        for (Slab* slab : _slabs[c])
+        {
+            slab->Drain();
+            if (slab->used == 0) Central::Instance().Release(slab);
+            else Central::Instance().Abandon(slab);
+        }
+        _slabs[c].clear();
+        _active[c] = nullptr;
+    }
+}
+
+// 指针本身没有析构函数，线程退出过程中任何时候都能安全读取
+inline thread_local ThreadCache* tls_cache = nullptr;
+inline thread_local bool tls_exited = false;
+
+struct CacheHolder
+{
+    ThreadCache* cache = nullptr;
+
+    ~CacheHolder()
+    {
+        tls_cache = nullptr;
+        tls_exited = true;
+        if (cache)
+        {
+            cache->Abandon();
+            delete cache;
+        }
+    }
+};
+
+// 线程缓存已经析构（线程退出阶段）时返回 nullptr，调用方改用后备缓存
+inline ThreadCache* LocalCache()
+{
+    ThreadCache* cache = tls_cache;
+    if (cache || tls_exited) return cache;
+    thread_local CacheHolder holder;
+    holder.cache = new ThreadCache();
+    tls_cache = holder.cache;
+    return tls_cache;
+}
+}
+
+class SlabHeap
+{
+public:
+    static void* Allocate(size_t bytes)
+    {
+        if (bytes > slab_detail::kMaxSmall) return ::operator new(bytes);
+        size_t c = slab_detail::ClassOf(bytes);
+        slab_detail::ThreadCache* cache = slab_detail::LocalCache();
+        if (cache) return cache->Allocate(c);
+        return slab_detail::Central::Instance().FallbackAllocate(c);
+    }
+
+    static void Deallocate(void* p, size_t bytes) noexcept
+    {
+        if (!p) return;
+        if (bytes > slab_detail::kMaxSmall)
+        {
+            ::operator delete(p);
+            return;
+        }
+        slab_detail::Slab* slab = slab_detail::SlabOf(p);
+        slab_detail::ThreadCache* cache = slab_detail::tls_cache;
+        if (cache && slab->owner.load(std::memory_order_relaxed) == cache) cache->Free(slab, p);
+        else slab->PushRemote(p);
+    }
+
+    static slab_detail::SlabStats Stats() { return slab_detail::Central::Instance().Stats(); }
+};
+
+// 标准库容器用的分配器，例如 unordered_map<string, bool, hash<string>, equal_to<string>, SlabAllocator<...>>
+template<typename T>
+struct SlabAllocator
+{
+    using value_type = T;
+
+    SlabAllocator() noexcept = default;
+    template<typename U>
+    SlabAllocator(const SlabAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n)
+    {
+        if (n > size_t(-1) / sizeof(T)) throw std::bad_array_new_length();
+        if (alignof(T) > 16) return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+        return static_cast<T*>(SlabHeap::Allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) noexcept
+    {
+        if (alignof(T) > 16) ::operator delete(p, std::align_val_t(alignof(T)));
+        else SlabHeap::Deallocate(p, n * sizeof(T));
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const SlabAllocator<T>&, const SlabAllocator<U>&) { return true; }
+template<typename T, typename U>
+bool operator!=(const SlabAllocator<T>&, const SlabAllocator<U>&) { return false; }
+
+// 只能移动的 void() 任务包装，闭包放在 slab 上
+// std::function 要求可拷贝，闭包超过 16 字节就走 malloc，出队时再拷贝一次又是一次分配
+class SlabTask
+{
+public:
+    SlabTask() = default;
+
+    template<typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, SlabTask>::value>>
+    SlabTask(F&& f)
+    {
+        using Fn = std::decay_t<F>;
+        static_assert(alignof(Fn) <= 16, "over-aligned closures are not supported");
+        void* mem = SlabHeap::Allocate(sizeof(Fn));
+        try
+        {
+            _obj = new (mem) Fn(std::forward<F>(f));
+        }
+        catch (...)
+        {
+            SlabHeap::Deallocate(mem, sizeof(Fn));
+            throw;
+        }
+        _invoke = &Invoke<Fn>;
+        _destroy = &Destroy<Fn>;
+    }
+
+    SlabTask(SlabTask&& other) noexcept
+        : _obj(other._obj), _invoke(other._invoke), _destroy(other._destroy)
+    {
+        other._obj = nullptr;
+    }
+
+    SlabTask& operator=(SlabTask&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            _obj = other._obj;
+            _invoke = other._invoke;
+            _destroy = other._destroy;
+            other._obj = nullptr;
+        }
+        return *this;
+    }
+
+    SlabTask(const SlabTask&) = delete;
+    SlabTask& operator=(const SlabTask&) = delete;
+
+    ~SlabTask() { Reset(); }
+
+    explicit operator bool() const { return _obj != nullptr; }
+    void operator()() { _invoke(_obj); }
+
+private:
+    template<typename Fn>
+    static void Invoke(void* obj) { (*static_cast<Fn*>(obj))(); }
+
+    template<typename Fn>
+    static void Destroy(void* obj)
+    {
+        static_cast<Fn*>(obj)->~Fn();
+        SlabHeap::Deallocate(obj, sizeof(Fn));
+    }
+
+    void Reset()
+    {
+        if (_obj) _destroy(_obj);
+        _obj = nullptr;
+    }
+
+    void* _obj = nullptr;
+    void (*_invoke)(void*) = nullptr;
+    void (*_destroy)(void*) = nullptr;
+};
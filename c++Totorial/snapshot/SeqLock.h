@@ -0,0 +1,91 @@
+#pragma once
+
+// 顺序锁：适合频繁读取、很少修改的小块 POD 数据（缓冲区尺寸、配置项等）
+// 写者把序号改成奇数、写数据、再改成偶数；读者读两次序号，前后一致且为偶数才算读到完整快照
+// 读者只读共享内存，不加锁也不写任何共享缓存行，写者之间用互斥锁串行
+//
+// 数据按 8 字节拆成原子变量保存，读者与写者并发访问不构成数据竞争
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+template<typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock<T> requires a trivially copyable T");
+
+public:
+    SeqLock() : SeqLock(T{}) {}
+    explicit SeqLock(const T& value) { WriteWords(value); }
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    T Load() const
+    {
+        uint64_t words[kWords];
+        while (true)
+        {
+            uint32_t before = _seq.load(std::memory_order_acquire);
+            if (before & 1)
+            {
+                Relax();
+                continue;
+            }
+            for (size_t i = 0; i < kWords; ++i) words[i] = _data[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (_seq.load(std::memory_order_relaxed) == before) break;
+        }
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+    void Store(const T& value)
+    {
+        std::lock_guard<std::mutex> lock(_writer);
+        uint32_t seq = _seq.load(std::memory_order_relaxed);
+        _seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        WriteWords(value);
+        _seq.store(seq + 2, std::memory_order_release);
+    }
+
+    // 读-改-写，多个写者之间不会丢失修改
+    template<typename F>
+    void Update(F&& mutate)
+    {
+        std::lock_guard<std::mutex> lock(_writer);
+        T value = Load();
+        mutate(value);
+        uint32_t seq = _seq.load(std::memory_order_relaxed);
+        _seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        WriteWords(value);
+        _seq.store(seq + 2, std::memory_order_release);
+    }
+
+private:
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    void WriteWords(const T& value)
+    {
+        uint64_t words[kWords] = {};
+        std::memcpy(words, &value, sizeof(T));
+        for (size_t i = 0; i < kWords; ++i) _data[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    static void Relax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+    alignas(64) std::atomic<uint32_t> _seq{0};
+    std::atomic<uint64_t> _data[kWords];
+    std::mutex _writer;
+};
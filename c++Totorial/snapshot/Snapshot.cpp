@@ -0,0 +1,136 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "SeqLock.h"
+#include "Snapshot.h"
+
+using namespace std;
+
+// 读多写少的共享状态：互斥锁 / 读写锁 / SeqLock / RCU 快照的读端吞吐对比
+// 多个读线程不停查询，一个写线程每毫秒修改一次
+//
+// 编译：g++ -std=c++17 -O2 -pthread Snapshot.cpp
+// 运行：./a.out [readers] [milliseconds]
+
+struct Dimensions
+{
+    int width;
+    int height;
+    uint32_t format;
+};
+
+using Registry = unordered_map<string, int>;
+
+Registry MakeRegistry(int version)
+{
+    Registry registry;
+    for (int i = 0; i < 64; ++i) registry["module_" + to_string(i)] = version;
+    return registry;
+}
+
+// 在 duration 内让 readers 个线程不停调用 read，同时 write 每毫秒调用一次，返回每个读线程每秒的读取次数
+template<typename Read, typename Write>
+double Measure(int readers, int ms, Read read, Write write)
+{
+    atomic<bool> stop{false};
+    atomic<long> total{0};
+    vector<thread> threads;
+    for (int r = 0; r < readers; ++r)
+    {
+        threads.emplace_back([&, r]() {
+            long count = 0;
+            long sink = 0;
+            while (!stop.load(memory_order_relaxed))
+            {
+                sink += read(r);
+                ++count;
+            }
+            if (sink == 42) cout << "";
+            total.fetch_add(count);
+        });
+    }
+    thread writer([&]() {
+        int version = 0;
+        while (!stop.load(memory_order_relaxed))
+        {
+            write(++version);
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+    });
+    this_thread::sleep_for(chrono::milliseconds(ms));
+    stop.store(true);
+    for (auto& t : threads) t.join();
+    writer.join();
+    return total.load() / (ms / 1000.0) / readers;
+}
+
+void Print(const string& name, double reads_per_sec)
+{
+    cout << "  " << left << setw(16) << name << right << setw(10) << fixed << setprecision(2)
+         << reads_per_sec / 1e6 << " M reads/s per reader" << endl;
+    cout.unsetf(ios::fixed);
+}
+
+void BenchDimensions(int readers, int ms)
+{
+    cout << "dimensions (" << sizeof(Dimensions) << " bytes), " << readers << " readers:" << endl;
+
+    mutex mtx;
+    Dimensions locked{1920, 1080, 1};
+    Print("mutex", Measure(readers, ms,
+        [&](int) { lock_guard<mutex> lock(mtx); return long(locked.width) * locked.height; },
+        [&](int v) { lock_guard<mutex> lock(mtx); locked = Dimensions{1920 + v % 2, 1080 + v % 2, 1}; }));
+
+    SeqLock<Dimensions> seq(Dimensions{1920, 1080, 1});
+    atomic<bool> torn{false};
+    Print("SeqLock", Measure(readers, ms,
+        [&](int) {
+            Dimensions d = seq.Load();
+            if (d.width - 1920 != d.height - 1080) torn.store(true);
+            return long(d.width) * d.height;
+        },
+        [&](int v) { seq.Store(Dimensions{1920 + v % 2, 1080 + v % 2, 1}); }));
+    cout << "  seqlock torn reads: " << (torn ? "YES" : "none") << endl;
+}
+
+void BenchRegistry(int readers, int ms)
+{
+    cout << "registry (64 entries), " << readers << " readers:" << endl;
+
+    mutex mtx;
+    Registry locked = MakeRegistry(0);
+    Print("mutex", Measure(readers, ms,
+        [&](int r) { lock_guard<mutex> lock(mtx); return long(locked.at("module_" + to_string(r % 64))); },
+        [&](int v) { Registry next = MakeRegistry(v); lock_guard<mutex> lock(mtx); locked.swap(next); }));
+
+    shared_mutex rw;
+    Registry shared = MakeRegistry(0);
+    Print("shared_mutex", Measure(readers, ms,
+        [&](int r) { shared_lock<shared_mutex> lock(rw); return long(shared.at("module_" + to_string(r % 64))); },
+        [&](int v) { Registry next = MakeRegistry(v); unique_lock<shared_mutex> lock(rw); shared.swap(next); }));
+
+    Snapshot<Registry> snapshot(MakeRegistry(0));
+    Print("Snapshot", Measure(readers, ms,
+        [&](int r) { auto registry = snapshot.Read(); return long(registry->at("module_" + to_string(r % 64))); },
+        [&](int v) { snapshot.Store(MakeRegistry(v)); }));
+    EpochDomain::Global().Collect();
+    ReclaimStats stats = EpochDomain::Global().Stats();
+    cout << "  snapshot versions retired=" << stats.retired << " reclaimed=" << stats.reclaimed << endl;
+}
+
+int main(int argc, char** argv)
+{
+    int readers = argc > 1 ? atoi(argv[1]) : 4;
+    int ms = argc > 2 ? atoi(argv[2]) : 500;
+    BenchDimensions(readers, ms);
+    BenchRegistry(readers, ms);
+    return 0;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+// RCU 风格的快照：适合频繁读取、很少修改的较大结构（模块注册表等）
+// 读者在 EBR 临界区内拿到当前版本的指针，只写本线程自己的纪元记录，不加锁
+// 写者复制一份、修改、原子替换指针，旧版本交给 EpochDomain 延迟释放
+//
+// 读端临界区要短：持有 ReadPtr 期间会挡住纪元推进，不要在里面阻塞等待
+
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include "../reclaim/Reclaim.h"
+
+template<typename T>
+class Snapshot
+{
+public:
+    explicit Snapshot(EpochDomain& domain = EpochDomain::Global()) : Snapshot(T{}, domain) {}
+    explicit Snapshot(T value, EpochDomain& domain = EpochDomain::Global())
+        : _domain(domain), _current(new T(std::move(value)))
+    {
+    }
+
+    ~Snapshot() { delete _current.load(std::memory_order_relaxed); }
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    // 读端句柄：生命周期内指向的版本不会被释放
+    class ReadPtr
+    {
+    public:
+        explicit ReadPtr(const Snapshot& snapshot)
+            : _guard(snapshot._domain), _ptr(_guard.Protect(0, snapshot._current))
+        {
+        }
+
+        ReadPtr(const ReadPtr&) = delete;
+        ReadPtr& operator=(const ReadPtr&) = delete;
+
+        const T& operator*() const { return *_ptr; }
+        const T* operator->() const { return _ptr; }
+        const T* Get() const { return _ptr; }
+
+    private:
+        EpochDomain::Guard _guard;
+        const T* _ptr;
+    };
+
+    ReadPtr Read() const { return ReadPtr(*this); }
+
+    // 复制当前版本，修改后整体替换
+    template<typename F>
+    void Update(F&& mutate)
+    {
+        std::lock_guard<std::mutex> lock(_writer);
+        const T* old = _current.load(std::memory_order_relaxed);
+        T* next = new T(*old);
+        mutate(*next);
+        Publish(next);
+    }
+
+    void Store(T value)
+    {
+        std::lock_guard<std::mutex> lock(_writer);
+        Publish(new T(std::move(value)));
+    }
+
+private:
+    void Publish(T* next)
+    {
+        const T* old = _current.exchange(next, std::memory_order_acq_rel);
+        _domain.Retire(const_cast<T*>(old));
+    }
+
+    EpochDomain& _domain;
+    std::atomic<const T*> _current;
+    std::mutex _writer;
+};
@@ -25,6 +25,11 @@ public:
             << " acquired the lock." << std::endl;
     }
 
+    // 不自旋，只试一次；ProfiledLock 用它区分有没有发生竞争
+    bool try_lock() {
+        return !flag.test_and_set(std::memory_order_acquire);
+    }
+
     void unlock() {
         // 将flag变量设置为false，释放锁
         // 这里使用clear函数进行原子操作，设置内存序为memory_order_release以保证同步
@@ -43,6 +48,14 @@ private:
     // 构造函数初始化列表的问题：在构造函数的初始化列表中直接使用 ATOMIC_FLAG_INIT 来初始化 std::atomic_flag 会导致编译器无法正确解析，因而报错。
 };
 
+// 编译时加 -DLOCK_PROFILING 统计 test2 中计数器锁的等待/持有时间（见 lockProfile/LockProfile.h）
+#ifdef LOCK_PROFILING
+#include "../lockProfile/LockProfile.h"
+using CounterLock = ProfiledLock<SpinLock>;
+#else
+using CounterLock = SpinLock;
+#endif
+
 void test1()
 {
     // 创建SpinLock对象
@@ -72,7 +85,7 @@ void test1()
 
 void test2()
 {
-    SpinLock spinLock2;
+    CounterLock spinLock2;
     int counter = 0;
 
     const int num_threads = 4;
@@ -105,6 +118,9 @@ void test2()
 int main() {
     test1();
     test2();
+#ifdef LOCK_PROFILING
+    LockProfiler::Print(std::cout);
+#endif
 
     return 0;
 }
@@ -0,0 +1,37 @@
+#pragma once
+
+// 各组件共用的锁、条件变量和任务类型，由编译开关统一选择，换实现时不用改组件代码
+//   -DUSE_PARKING_LOT  CondVar 换成基于 futex 的等待原语 ParkingCondVar（见 eventCount/EventCount.h）
+//   -DLOCK_PROFILING   Mutex 换成统计等待/持有时间的 ProfiledMutex（见 lockProfile/LockProfile.h），
+//                      CondVar 相应换成能配合任意锁的 condition_variable_any
+//   -DUSE_SLAB_ALLOC   任务闭包 TaskFunc、任务组状态和执行期临时容器的 TaskAlloc 走线程本地 slab 分配器（见 slab/Slab.h）
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#ifdef USE_PARKING_LOT
+#include "../eventCount/EventCount.h"
+using CondVar = ParkingCondVar;
+#elif defined(LOCK_PROFILING)
+using CondVar = std::condition_variable_any;
+#else
+using CondVar = std::condition_variable;
+#endif
+
+#ifdef LOCK_PROFILING
+#include "../lockProfile/LockProfile.h"
+using Mutex = ProfiledMutex;
+#else
+using Mutex = std::mutex;
+#endif
+
+#ifdef USE_SLAB_ALLOC
+#include "../slab/Slab.h"
+using TaskFunc = SlabTask;
+template<typename T> using TaskAlloc = SlabAllocator<T>;
+#else
+using TaskFunc = std::function<void()>;
+template<typename T> using TaskAlloc = std::allocator<T>;
+#endif
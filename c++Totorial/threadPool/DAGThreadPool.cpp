@@ -8,8 +8,23 @@
 #include <functional>
 #include <queue>
 #include <sstream>
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <exception>
+#include <cstdint>
+#include <cstddef>
+#include <memory_resource>
+#include <algorithm>
+#include <chrono>
 using namespace std;
 
+#include "../syncTypes/SyncTypes.h"
+#include "../snapshot/Snapshot.h"
+#include "../semaphore/RateLimiter.h"
+#include "../resultCache/ResultCache.h"
+
 class ThreadPool
 {
 public:
@@ -23,7 +38,7 @@ public:
     ~ThreadPool()
     {
         {
-            unique_lock<mutex> lock(_mutex);
+            unique_lock<Mutex> lock(_mutex);
             _stop = true;
         }
         _cv.notify_all();
@@ -40,19 +55,29 @@ public:
     {
         _pool.emplace_back([this]()
         {
+            CurrentPool() = this;
             while (true)
             {
-                function<void()> func;
+                TaskFunc func;
+                size_t wake = 0;
                 {
-                    unique_lock<mutex> lock(_mutex);
-                    _cv.wait(lock, [this]() { return _stop || !_tasks.empty(); });
-                    if (_stop && _tasks.empty())
+                    unique_lock<Mutex> lock(_mutex);
+                    size_t promoted = 0;
+                    while (true)
+                    {
+                        promoted += PromoteDelayed();
+                        if (!_tasks.empty() || _stop) break;
+                        _delayed.Wait(_cv, lock);
+                    }
+                    if (_tasks.empty())
                     {
                         return;
                     }
-                    func = move(_tasks.front());
+                    func = move(_tasks.front().func);
                     _tasks.pop_front();
+                    wake = min(promoted, _tasks.size());
                 }
+                WakeWorkers(wake);
                 func();
             }
         });
@@ -63,20 +88,212 @@ public:
     {
         auto func = bind(forward<F>(f), forward<Args>(args)...);
         {
-            unique_lock<mutex> lck(_mutex);
-            _tasks.emplace_back(func);
+            unique_lock<Mutex> lck(_mutex);
+            _tasks.push_back(QueuedTask{move(func), NowNs()});
         }
         _cv.notify_one();
     }
+
+    // 延时任务（见 semaphore/RateLimiter.h 的 DelayedQueue）；线程池析构时剩余的延时任务立即执行
+    template<typename F>
+    void PutTaskAfter(chrono::nanoseconds delay, F &&f)
+    {
+        if (delay <= chrono::nanoseconds::zero())
+        {
+            PutTask(forward<F>(f));
+            return;
+        }
+        bool earliest;
+        {
+            unique_lock<Mutex> lck(_mutex);
+            earliest = _delayed.Push(delay, TaskFunc(forward<F>(f)));
+        }
+        if (earliest) _cv.notify_one();
+    }
+
+    // 准入控制只管 Submit 提交的任务，PutTask 不受影响（例如 TaskGroup 内部的任务）
+    void SetAdmission(AdmissionHook hook) { _admission.Set(move(hook)); }
+
+    // 经过准入控制的提交，被拒绝时返回 false，任务不会执行
+    template<typename F>
+    bool Submit(F &&f, double cost = 1.0)
+    {
+        return _admission.Submit(QueueLatency(), cost,
+            [&]() { PutTask(forward<F>(f)); },
+            [&](chrono::nanoseconds delay) { PutTaskAfter(delay, forward<F>(f)); });
+    }
+
+    // 排队延迟：队首任务已经等了多久（队列为空时为 0），新任务至少还要再等这么久才会被执行
+    chrono::nanoseconds QueueLatency()
+    {
+        unique_lock<Mutex> lck(_mutex);
+        if (_tasks.empty()) return chrono::nanoseconds::zero();
+        return chrono::nanoseconds(NowNs() - _tasks.front().enqueued_ns);
+    }
+
+    // 当前线程是不是本线程池的工作线程；Future 的续体据此决定就地执行还是入队（见 callbackHell/Future.h）
+    bool InWorker() const { return CurrentPool() == this; }
+
+    // 在调用线程上取一个就绪任务执行，队列为空时立即返回 false
+    // 给等待中的工作线程用（见 phase/Phase.h）：与其睡眠，不如先帮忙把排队的任务跑掉
+    bool RunOneTask()
+    {
+        TaskFunc func;
+        size_t wake = 0;
+        {
+            unique_lock<Mutex> lock(_mutex);
+            size_t promoted = PromoteDelayed();
+            if (_tasks.empty()) return false;
+            func = move(_tasks.front().func);
+            _tasks.pop_front();
+            wake = min(promoted, _tasks.size());
+        }
+        WakeWorkers(wake);
+        func();
+        return true;
+    }
+
 private:
-    deque<function<void()>> _tasks;
+    struct QueuedTask
+    {
+        TaskFunc func;
+        int64_t enqueued_ns;
+    };
+
+    // 到期的延时任务移到就绪队列，取走一个后用 WakeWorkers 叫醒别的线程执行剩下的
+    size_t PromoteDelayed()
+    {
+        return _delayed.Promote(_stop, [this](TaskFunc&& func) {
+            _tasks.push_back(QueuedTask{move(func), NowNs()});
+        });
+    }
+
+    void WakeWorkers(size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            _cv.notify_one();
+        }
+    }
+
+    // 入队时间戳用的时钟，与 chrono::steady_clock 相同
+    static int64_t NowNs()
+    {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static ThreadPool*& CurrentPool()
+    {
+        static thread_local ThreadPool* pool = nullptr;
+        return pool;
+    }
+
+    deque<QueuedTask> _tasks;
+    DelayedQueue<TaskFunc> _delayed;
     vector<thread> _pool;
-    mutex _mutex;
-    condition_variable _cv;
+    Mutex _mutex;
+    CondVar _cv;
     bool _stop;
+    AdmissionGate _admission;
+};
+
+// 停止令牌：任务通过它轮询是否被取消（协作式取消，不会强行打断线程）
+class StopToken
+{
+public:
+    StopToken() = default;
+    explicit StopToken(shared_ptr<atomic<bool>> flag) : _flag(move(flag)) {}
+    bool StopRequested() const { return _flag && _flag->load(memory_order_acquire); }
+private:
+    shared_ptr<atomic<bool>> _flag;
+};
+
+// 任务组：一组任务共享生命周期，支持 Wait() 等待全部结束、Cancel() 取消剩余任务
+// 已入队但被取消的任务在出队时只检查一次标记位就丢弃，O(1)，任务体不会执行
+class TaskGroup
+{
+public:
+    explicit TaskGroup(ThreadPool& tp) : _tp(tp), _state(allocate_shared<State>(TaskAlloc<State>())) {}
+    ~TaskGroup()
+    {
+        Cancel();
+        WaitNoThrow();
+    }
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    // 提交任务，任务签名为 void(StopToken)
+    void Run(function<void(StopToken)> func)
+    {
+        {
+            lock_guard<Mutex> lock(_state->mtx);
+            ++_state->pending;
+        }
+        shared_ptr<State> state = _state;
+        _tp.PutTask([state, func = move(func)]()
+        {
+            if (!state->cancelled->load(memory_order_acquire))
+            {
+                try
+                {
+                    func(StopToken(state->cancelled));
+                }
+                catch (...)
+                {
+                    // 记录第一个异常，并取消组内其余任务
+                    lock_guard<Mutex> lock(state->mtx);
+                    if (!state->error) state->error = current_exception();
+                    state->cancelled->store(true, memory_order_release);
+                }
+            }
+            lock_guard<Mutex> lock(state->mtx);
+            if (--state->pending == 0)
+            {
+                state->cv.notify_all();
+            }
+        });
+    }
+
+    // 请求取消：正在执行的任务通过 StopToken 感知，排队中的任务直接丢弃
+    void Cancel() { _state->cancelled->store(true, memory_order_release); }
+    bool Cancelled() const { return _state->cancelled->load(memory_order_acquire); }
+    StopToken GetToken() const { return StopToken(_state->cancelled); }
+
+    // 等待组内所有任务结束（包括被丢弃的任务出队），有任务抛异常则重新抛出
+    void Wait()
+    {
+        WaitNoThrow();
+        lock_guard<Mutex> lock(_state->mtx);
+        if (_state->error)
+        {
+            exception_ptr err = _state->error;
+            _state->error = nullptr;
+            rethrow_exception(err);
+        }
+    }
+
+private:
+    void WaitNoThrow()
+    {
+        unique_lock<Mutex> lock(_state->mtx);
+        _state->cv.wait(lock, [this]() { return _state->pending == 0; });
+    }
+
+    // 共享状态由任务闭包持有，保证组对象先析构时任务仍能安全访问
+    struct State
+    {
+        shared_ptr<atomic<bool>> cancelled = allocate_shared<atomic<bool>>(TaskAlloc<atomic<bool>>(), false);
+        Mutex mtx;
+        CondVar cv;
+        int pending = 0;
+        exception_ptr error;
+    };
+
+    ThreadPool& _tp;
+    shared_ptr<State> _state;
 };
 
-mutex g_log_mtx;
+Mutex g_log_mtx;
 
 class LogQueue
 {
@@ -87,7 +304,7 @@ public:
     // 3. 支持移动语义，避免不必要的拷贝
     void Push(string&& str)
     { 
-        lock_guard<mutex> lock(mtx_);
+        lock_guard<Mutex> lock(mtx_);
         log_que_.emplace(str);  // 直接移动构造，没有拷贝
         cv_.notify_one();
     }
@@ -95,7 +312,7 @@ public:
     // 如果使用 & (左值引用)
     // void Push(string& str)
     // { 
-    //     lock_guard<mutex> lock(mtx_);
+    //     lock_guard<Mutex> lock(mtx_);
     //     log_que_.push(str);  // 会产生一次拷贝
     //     cv_.notify_one();
     // }
@@ -106,7 +323,7 @@ public:
 
     void Cout()
     {
-        unique_lock<mutex> lock(mtx_);
+        unique_lock<Mutex> lock(mtx_);
         cv_.wait_for(lock, chrono::milliseconds(100), [this]() { return !log_que_.empty(); });
         if (!log_que_.empty())
         {
@@ -118,30 +335,217 @@ public:
 
 private:
     queue<string> log_que_;
-    mutex mtx_;
-    condition_variable cv_;
+    Mutex mtx_;
+    CondVar cv_;
 };
 LogQueue g_log_que;
 
+// 带版本号的输入值：每次 Set 版本号加一，模块据此判断输入是否变化
+// 注意：只在两轮执行之间写入，执行过程中只读
+class VersionedBase
+{
+public:
+    virtual ~VersionedBase() = default;
+    uint64_t Version() const { return version_.load(memory_order_acquire); }
+protected:
+    void Bump() { version_.fetch_add(1, memory_order_release); }
+private:
+    atomic<uint64_t> version_{1};
+};
+
+template<typename T>
+class Versioned : public VersionedBase
+{
+public:
+    explicit Versioned(T value) : value_(move(value)) {}
+    const T& Get() const { return value_; }
+    void Set(T value)
+    {
+        value_ = move(value);
+        Bump();
+    }
+private:
+    T value_;
+};
+
+// 单轮执行的单调内存池：模块输出都分配在这里，本轮结束时整体释放
+// 底层缓冲区在多轮之间复用，并按上一轮的峰值扩容，稳定后每一轮都不再向系统申请内存
+class RunArena
+{
+public:
+    explicit RunArena(size_t initial_bytes = 64 * 1024)
+        : _backing(initial_bytes), _locked(this)
+    {
+        _mono = make_unique<pmr::monotonic_buffer_resource>(_backing.data(), _backing.size(), &_upstream);
+    }
+    ~RunArena() { Reset(); }
+    RunArena(const RunArena&) = delete;
+    RunArena& operator=(const RunArena&) = delete;
+
+    // 在 arena 上构造对象；pmr 容器会通过 uses-allocator 构造把元素也放进 arena
+    template<typename T, typename... Args>
+    T* New(Args&&... args)
+    {
+        void* mem = _locked.allocate(sizeof(T), alignof(T));
+        pmr::polymorphic_allocator<T> alloc(&_locked);
+        T* obj = static_cast<T*>(mem);
+        alloc.construct(obj, forward<Args>(args)...);
+        if (!is_trivially_destructible<T>::value)
+        {
+            lock_guard<Mutex> lock(_mutex);
+            _dtors.emplace_back(obj, [](void* p) { static_cast<T*>(p)->~T(); });
+        }
+        return obj;
+    }
+
+    pmr::memory_resource* Resource() { return &_locked; }
+
+    // 一次性释放本轮所有对象；用量超过底层缓冲区时扩容，下一轮就能全部放下
+    void Reset()
+    {
+        lock_guard<Mutex> lock(_mutex);
+        for (auto it = _dtors.rbegin(); it != _dtors.rend(); ++it)
+        {
+            it->second(it->first);
+        }
+        _dtors.clear();
+        _mono.reset();
+        if (_used > _backing.size())
+        {
+            size_t capacity = _backing.size();
+            while (capacity < _used) capacity *= 2;
+            _backing = vector<byte>(capacity);
+        }
+        _mono = make_unique<pmr::monotonic_buffer_resource>(_backing.data(), _backing.size(), &_upstream);
+        _used = 0;
+        _generation++;
+    }
+
+    size_t BytesUsed() const { return _used; }
+    size_t Capacity() const { return _backing.size(); }
+    uint64_t Generation() const { return _generation; }
+    // 累计向系统申请内存的次数，稳定状态下不再增长
+    size_t UpstreamAllocs() const { return _upstream.allocs; }
+
+private:
+    // monotonic_buffer_resource 不是线程安全的，模块会并发输出，外面包一层锁
+    class LockedResource : public pmr::memory_resource
+    {
+    public:
+        explicit LockedResource(RunArena* arena) : _arena(arena) {}
+    private:
+        void* do_allocate(size_t bytes, size_t align) override
+        {
+            lock_guard<Mutex> lock(_arena->_mutex);
+            // 按最坏情况计入对齐填充，扩容时才不会把缓冲区估小
+            _arena->_used += bytes + align - 1;
+            return _arena->_mono->allocate(bytes, align);
+        }
+        // 单调分配，释放为空操作，Reset 时整体回收
+        void do_deallocate(void*, size_t, size_t) override {}
+        bool do_is_equal(const pmr::memory_resource& other) const noexcept override { return this == &other; }
+        RunArena* _arena;
+    };
+
+    class CountingResource : public pmr::memory_resource
+    {
+    public:
+        size_t allocs = 0;
+    private:
+        void* do_allocate(size_t bytes, size_t align) override
+        {
+            allocs++;
+            return pmr::new_delete_resource()->allocate(bytes, align);
+        }
+        void do_deallocate(void* p, size_t bytes, size_t align) override
+        {
+            pmr::new_delete_resource()->deallocate(p, bytes, align);
+        }
+        bool do_is_equal(const pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    vector<byte> _backing;
+    CountingResource _upstream;
+    unique_ptr<pmr::monotonic_buffer_resource> _mono;
+    LockedResource _locked;
+    vector<pair<void*, void (*)(void*)>> _dtors;
+    Mutex _mutex;
+    size_t _used = 0;
+    uint64_t _generation = 0;
+};
+
+// 模块执行状态：kSucc/kFailed/kCancelled 都是终态
+enum class ModuleState : int
+{
+    kPending = 0,
+    kSucc,
+    kFailed,
+    kCancelled,
+};
+
 class Module
 {
 public:
     Module(string name, vector<string> deps) : name_(name), deps_(deps) {}
+    virtual ~Module() = default;
     virtual void Execute() = 0;
     const string& Name() const { return name_; }
     const vector<string>& Deps() const { return deps_; }
-    bool CheckSucc() { return is_succ_; }
-    void SetSucc() { is_succ_ = true; }
+    bool CheckSucc() { return state_ == ModuleState::kSucc; }
+    bool CheckDone() { return state_ != ModuleState::kPending; }
+    ModuleState State() const { return state_; }
+    void SetSucc() { state_ = ModuleState::kSucc; }
+    void SetFailed() { state_ = ModuleState::kFailed; }
+    void SetCancelled() { state_ = ModuleState::kCancelled; }
+    void SetStopToken(StopToken token) { stop_token_ = move(token); }
+    void SetRunArena(RunArena* arena) { run_arena_ = arena; }
+    RunArena* Arena() const { return run_arena_; }
+    // 模块通过进程内内存交换结果（端口、MemoModule 的输出），跨进程执行时下游读不到，见 processThreadPool.cpp
+    void MarkInProcessOutput() { in_process_output_ = true; }
+    bool HasInProcessOutput() const { return in_process_output_; }
+    // 输入端口会把上游模块自动加入依赖
+    void AddDep(const string& dep)
+    {
+        if (find(deps_.begin(), deps_.end(), dep) == deps_.end()) deps_.push_back(dep);
+    }
+
+    // 声明输入：增量模式下输入版本变化的模块会被重新执行
+    void DeclareInput(const VersionedBase* input) { inputs_.emplace_back(input, 0); }
+    // 手动标记为脏，下一轮增量执行时重新计算
+    void MarkDirty() { dirty_ = true; }
+    // 没有成功结果、被手动标脏或任一输入版本变化，都需要重新执行
+    bool IsDirty() const
+    {
+        if (dirty_ || state_ != ModuleState::kSucc) return true;
+        for (auto& input : inputs_)
+        {
+            if (input.first->Version() != input.second) return true;
+        }
+        return false;
+    }
+    // 执行成功后记录本次看到的输入版本
+    void CommitInputs()
+    {
+        for (auto& input : inputs_)
+        {
+            input.second = input.first->Version();
+        }
+        dirty_ = false;
+    }
+
     void ClearState()
     {
-        is_succ_ = false;
-        if (commit_log_thread_->joinable()) commit_log_thread_->join();
+        state_ = ModuleState::kPending;
+        if (commit_log_thread_ && commit_log_thread_->joinable()) commit_log_thread_->join();
     }
 
 protected:
+    // 耗时的模块应在计算过程中检查，被取消时尽早返回
+    bool StopRequested() const { return stop_token_.StopRequested(); }
+
     void AsyncCommitLog()
     {
-        lock_guard<mutex> log_lock(g_log_mtx);
+        lock_guard<Mutex> log_lock(g_log_mtx);
         commit_log_thread_ = make_unique<thread>([this]
         {
             stringstream ss;
@@ -155,7 +559,134 @@ protected:
 private:
     string name_;
     vector<string> deps_;
-    bool is_succ_{false};
+    atomic<ModuleState> state_{ModuleState::kPending};
+    StopToken stop_token_;
+    RunArena* run_arena_{nullptr};
+    vector<pair<const VersionedBase*, uint64_t>> inputs_;
+    bool dirty_{false};
+    bool in_process_output_{false};
+};
+
+// 输出端口：模块把结果构造在本轮的 RunArena 上，下游通过 InputPort 拿到 const 引用，不拷贝
+// 输出只在本轮有效，arena 重置后再读取会抛异常
+template<typename T>
+class OutputPort
+{
+public:
+    explicit OutputPort(Module* owner) : owner_(owner)
+    {
+        owner->MarkInProcessOutput();
+    }
+
+    template<typename... Args>
+    T& Emplace(Args&&... args)
+    {
+        RunArena* arena = owner_->Arena();
+        if (!arena)
+        {
+            throw runtime_error("Module " + owner_->Name() + " has no run arena");
+        }
+        value_ = arena->New<T>(forward<Args>(args)...);
+        generation_ = arena->Generation();
+        return *value_;
+    }
+
+    const T& Get() const
+    {
+        RunArena* arena = owner_->Arena();
+        if (!value_ || !arena || arena->Generation() != generation_)
+        {
+            throw runtime_error("Output of " + owner_->Name() + " is not ready");
+        }
+        return *value_;
+    }
+
+    const Module* Owner() const { return owner_; }
+
+private:
+    Module* owner_;
+    T* value_{nullptr};
+    uint64_t generation_{0};
+};
+
+// 输入端口：绑定上游的输出端口，类型在编译期检查
+template<typename T>
+class InputPort
+{
+public:
+    InputPort(Module* owner, const OutputPort<T>& source) : source_(&source)
+    {
+        owner->AddDep(source.Owner()->Name());
+        owner->MarkInProcessOutput();
+    }
+    const T& Get() const { return source_->Get(); }
+
+private:
+    const OutputPort<T>* source_;
+};
+
+// 带类型输出的记忆化模块：键 = xxHash(模块名 + 版本号 + 序列化后的输入)，输入不变时从缓存取出输出，跳过 Compute()
+// 输出放在模块自己身上而不是 RunArena 里：命中缓存时不重新构造，跨轮也能保留
+// 修改了计算逻辑时要递增 version，让旧结果失效
+template<typename Out>
+class MemoModule : public Module
+{
+public:
+    MemoModule(string name, vector<string> deps, ResultCache* cache, uint32_t version = 1)
+        : Module(name, deps), cache_(cache), version_(version)
+    {
+        MarkInProcessOutput();
+    }
+
+    void Execute() override
+    {
+        string key_bytes;
+        Serialize(key_bytes, Name());
+        Serialize(key_bytes, version_);
+        HashInputs(key_bytes);
+        uint64_t key = xxh::hash64(key_bytes.data(), key_bytes.size());
+
+        // 缓存里的字节解不出 Out（截断、损坏）时按未命中处理，重新计算并覆盖
+        auto decode = [this](const string& value) {
+            ByteReader in(value);
+            Out output{};
+            if (!Deserialize(in, output) || !in.Done()) return false;
+            output_ = move(output);
+            return true;
+        };
+        if (cache_ && cache_->Get(key, decode))
+        {
+            from_cache_ = true;
+            SetSucc();
+            return;
+        }
+        Out output = Compute();
+        // 被取消时 Compute 可能只算了一半，不能写进缓存
+        if (StopRequested()) return;
+        output_ = move(output);
+        from_cache_ = false;
+        if (cache_)
+        {
+            string value;
+            Serialize(value, output_);
+            cache_->Put(key, value);
+        }
+        SetSucc();
+    }
+
+    const Out& Output() const { return output_; }
+    bool FromCache() const { return from_cache_; }
+
+protected:
+    // 把所有会影响输出的输入写进 out（包括上游模块的 Output()）
+    virtual void HashInputs(string& out) const = 0;
+    virtual Out Compute() = 0;
+
+private:
+    ResultCache* cache_;
+    uint32_t version_;
+    Out output_{};
+    bool from_cache_{false};
 };
 
 class ModuleA : public Module
@@ -231,56 +762,286 @@ private:
     bool is_end_{false};
 };
 
+// 计算失败的模块：抛出异常后，执行器会跳过依赖它的整个下游子图
+class ModuleFail : public Module
+{
+public:
+    ModuleFail(string name, vector<string> deps) : Module(name, deps) {}
+    void Execute() override
+    {
+        this_thread::sleep_for(std::chrono::milliseconds(100));
+        throw runtime_error("compute error");
+    }
+};
+
+// 耗时模块：分片计算，每片之间检查是否被取消
+class ModuleSlow : public Module
+{
+public:
+    ModuleSlow(string name, vector<string> deps) : Module(name, deps) {}
+    void Execute() override
+    {
+        for (int i = 0; i < 50; i++)
+        {
+            if (StopRequested()) return;
+            this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        SetSucc();
+        AsyncCommitLog();
+    }
+};
+
 class Executor
 {
 public:
+    using ModuleMap = unordered_map<string, Module*>;
+    using VisitedMap = unordered_map<string, bool, hash<string>, equal_to<string>, TaskAlloc<pair<const string, bool>>>;
+
+    // 注册表很少修改：复制一份、插入、整体替换，正在读旧版本的线程不受影响
     void AddModule(Module* module)
     {
-        _modules[module->Name()] = module;
+        _modules.Update([module](ModuleMap& modules) { modules[module->Name()] = module; });
     }
 
     void ExecuteAll(ThreadPool& tp)
     {
-        unordered_map<string, bool> visited;
-        for (auto& mod : _modules)
+        // 新的一轮：上一轮的输出整体释放，缓冲区留给本轮复用
+        EndRun();
+        _arena_fresh = true;
+        StartGroup(tp);
+        VisitedMap visited;
+        for (auto& mod : ModuleList())
+        {
+            if (visited[mod.first]) continue;
+            Execute(mod.second, tp, visited);
+        }
+    }
+
+    // 增量执行：只重新执行脏模块及其传递下游，其余模块保留上一轮的成功结果
+    // 不要在两轮之间调用 ClearState，干净模块的状态就是缓存
+    // 干净模块的输出留在 arena 里，脏模块每轮又在后面追加新输出，旧输出成了垃圾；
+    // 累积到上一次完整执行用量的 kCompactFactor 倍时，这一轮改为完整执行，重置 arena 回收垃圾
+    void ExecuteDirty(ThreadPool& tp)
+    {
+        if (_arena_fresh)
+        {
+            _full_run_bytes = _arena.BytesUsed();
+            _arena_fresh = false;
+        }
+        if (_arena.BytesUsed() > max(kCompactFactor * _full_run_bytes, kMinCompactBytes))
+        {
+            for (auto& mod : ModuleList()) mod.second->ClearState();
+            ExecuteAll(tp);
+            return;
+        }
+        unordered_set<string> affected = CollectAffected();
+        StartGroup(tp);
+        VisitedMap visited;
+        vector<pair<string, Module*>> modules = ModuleList();
+        for (auto& mod : modules)
+        {
+            if (affected.count(mod.first)) mod.second->ClearState();
+            else visited[mod.first] = true;
+        }
+        for (auto& mod : modules)
         {
             if (visited[mod.first]) continue;
             Execute(mod.second, tp, visited);
         }
     }
+
+    // 结束本轮：一次性释放所有模块输出，调用后不能再读取本轮的输出
+    // 增量执行不会重置，干净模块的输出要留给下一轮使用
+    void EndRun() { _arena.Reset(); }
+    RunArena& Arena() { return _arena; }
+
+    // 取消本轮剩余的模块：排队中的直接丢弃，未派发的全部跳过
+    // 可以在其他线程调用：在锁内拿到当前任务组并设置取消标志，不会与派发线程替换任务组竞争，
+    // 也不会在派发线程检查完谓词、还没睡下时通知，丢掉这次唤醒
+    void Cancel()
+    {
+        {
+            lock_guard<Mutex> lock(_mutex);
+            if (_group) _group->Cancel();
+        }
+        _cv.notify_all();
+    }
+
+    // 等待本轮所有任务结束，被丢弃而没有执行的模块标记为已取消
+    void Wait()
+    {
+        if (!_group) return;
+        _group->Wait();
+        auto modules = _modules.Read();
+        for (auto& mod : *modules)
+        {
+            if (!mod.second->CheckDone()) mod.second->SetCancelled();
+        }
+    }
       
 private:
-    void Execute(Module* mod, ThreadPool& tp, unordered_map<string, bool>& visited)
+    // 新的一轮换上新任务组；替换在锁内完成，旧任务组出锁后才析构（析构要等它的任务结束，任务结束时会来拿 _mutex）
+    void StartGroup(ThreadPool& tp)
+    {
+        shared_ptr<TaskGroup> group = make_shared<TaskGroup>(tp);
+        {
+            lock_guard<Mutex> lock(_mutex);
+            _group.swap(group);
+        }
+    }
+
+    void Execute(Module* mod, ThreadPool& tp, VisitedMap& visited)
     {
         visited[mod->Name()] = true;
         for (auto& dep : mod->Deps())
         {
             if (!visited[dep])
             {
-                Execute(_modules[dep], tp, visited);
+                Execute(Find(dep), tp, visited);
             }
         }
         
-        // 使用条件变量等待依赖完成
-        unique_lock<mutex> lock(_mutex);
-        _cv.wait(lock, [this, mod]() {
+        // 使用条件变量等待依赖完成（成功、失败或取消都算完成）
+        // 先不加锁检查一次：依赖通常已经完成，不必和正在通知的工作线程抢 _mutex
+        if (!DepsDone(mod))
+        {
+            unique_lock<Mutex> lock(_mutex);
+            _cv.wait(lock, [this, mod]() { return DepsDone(mod); });
+        }
+        bool deps_succ = true;
+        {
+            auto modules = _modules.Read();
             for (auto& dep : mod->Deps())
             {
-                if (!_modules[dep]->CheckSucc()) return false;
+                if (!modules->at(dep)->CheckSucc()) deps_succ = false;
+            }
+        }
+
+        // 依赖失败或本轮已取消：跳过该模块，它的下游也会因此被依次跳过
+        if (!deps_succ || _group->Cancelled())
+        {
+            mod->SetCancelled();
+            g_log_que.Push("Skip: " + mod->Name());
+            NotifyStateChanged();
+            return;
+        }
+
+        _group->Run([this, mod](StopToken token) {
+            // 无论从哪条路径离开都通知等待的线程，否则派发线程会一直等这个模块
+            struct NotifyOnExit
+            {
+                Executor* executor;
+                ~NotifyOnExit() { executor->NotifyStateChanged(); }
+            } notify_on_exit{this};
+
+            mod->SetStopToken(token);
+            mod->SetRunArena(&_arena);
+            try
+            {
+                mod->Execute();
+            }
+            catch (const exception& e)
+            {
+                g_log_que.Push("Module " + mod->Name() + " failed: " + e.what());
+                mod->SetFailed();
+            }
+            catch (...)
+            {
+                g_log_que.Push("Module " + mod->Name() + " failed: unknown exception");
+                mod->SetFailed();
+            }
+            if (mod->CheckSucc()) mod->CommitInputs();
+            // 没有调用 SetSucc 就返回：被取消的记为取消，否则视为失败，避免下游永远等待
+            if (!mod->CheckDone())
+            {
+                if (token.StopRequested()) mod->SetCancelled();
+                else mod->SetFailed();
             }
-            return true;
-        });
-        
-        tp.PutTask([this, mod]() {
-            mod->Execute();
-            // 执行完成后通知等待的线程
-            _cv.notify_all();
         });
     }
+
+    // 从脏模块出发沿反向依赖做 BFS，得到需要重新执行的模块集合
+    unordered_set<string> CollectAffected()
+    {
+        auto modules = _modules.Read();
+        unordered_map<string, vector<string>> dependents;
+        for (auto& mod : *modules)
+        {
+            for (auto& dep : mod.second->Deps())
+            {
+                dependents[dep].push_back(mod.first);
+            }
+        }
+
+        unordered_set<string> affected;
+        queue<string> que;
+        for (auto& mod : *modules)
+        {
+            if (mod.second->IsDirty() && affected.insert(mod.first).second)
+            {
+                que.push(mod.first);
+            }
+        }
+        while (!que.empty())
+        {
+            string name = move(que.front());
+            que.pop();
+            for (auto& next : dependents[name])
+            {
+                if (affected.insert(next).second) que.push(next);
+            }
+        }
+        return affected;
+    }
+
+    // 依赖是否都已完成；读注册表不加锁，模块状态本身是原子变量
+    bool DepsDone(Module* mod) const
+    {
+        if (_group->Cancelled()) return true;
+        auto modules = _modules.Read();
+        for (auto& dep : mod->Deps())
+        {
+            if (!modules->at(dep)->CheckDone()) return false;
+        }
+        return true;
+    }
+
+    Module* Find(const string& name) const
+    {
+        auto modules = _modules.Read();
+        return modules->at(name);
+    }
+
+    // 派发过程中会阻塞等待，不能一直持有读端临界区，先把注册表拷出来
+    vector<pair<string, Module*>> ModuleList() const
+    {
+        auto modules = _modules.Read();
+        return vector<pair<string, Module*>>(modules->begin(), modules->end());
+    }
+
+    // 先获取锁再通知，避免等待方检查谓词后、睡眠前错过通知
+    // 只有调用 ExecuteAll/ExecuteDirty 的派发线程会在 _cv 上等待，唤醒一个就够了，
+    // 不必每完成一个任务就把所有等待者叫起来重新检查谓词
+    void NotifyStateChanged()
+    {
+        {
+            lock_guard<Mutex> lock(_mutex);
+        }
+        _cv.notify_one();
+    }
+
 private:
-    unordered_map<string, Module*> _modules;
-    mutex _mutex;
-    condition_variable _cv;
+    Snapshot<ModuleMap> _modules;
+    Mutex _mutex;
+    CondVar _cv;
+    // 只有派发线程替换它（在 _mutex 内），派发线程自己读取不加锁；其他线程经 Cancel 在锁内取一份引用
+    shared_ptr<TaskGroup> _group;
+    RunArena _arena;
+    static constexpr size_t kCompactFactor = 2;
+    static constexpr size_t kMinCompactBytes = 64 * 1024;
+    // 上一次完整执行结束时 arena 的用量，下一次调用时才知道，_arena_fresh 表示还没记录
+    size_t _full_run_bytes = 0;
+    bool _arena_fresh = false;
 };
 
 void test()
@@ -316,7 +1077,7 @@ void test()
     {
         executor.ExecuteAll(tp);
         // 等待所有任务完成
-        this_thread::sleep_for(std::chrono::milliseconds(2000));
+        executor.Wait();
 
         a.ClearState();
         b.ClearState();
@@ -331,8 +1092,334 @@ void test()
     }
 }
 
+// 增量模式演示用的模块：记录执行次数
+class ModuleCount : public Module
+{
+public:
+    ModuleCount(string name, vector<string> deps) : Module(name, deps) {}
+    void Execute() override
+    {
+        this_thread::sleep_for(std::chrono::milliseconds(10));
+        run_times_++;
+        SetSucc();
+    }
+    int RunTimes() const { return run_times_; }
+private:
+    atomic<int> run_times_{0};
+};
+
+const char* StateName(ModuleState state)
+{
+    switch (state)
+    {
+    case ModuleState::kPending: return "Pending";
+    case ModuleState::kSucc: return "Succ";
+    case ModuleState::kFailed: return "Failed";
+    case ModuleState::kCancelled: return "Cancelled";
+    }
+    return "Unknown";
+}
+
+// 失败传播：C 失败后，D、E 被跳过，A、B、F 不受影响
+void test2()
+{
+    ModuleA a("A", {});
+    ModuleB b("B", {});
+    ModuleFail c("C", {"A", "B"});
+    ModuleD d("D", {"C"});
+    ModuleE e("E", {"C", "D"});
+    ModuleA f("F", {"A"});
+
+    Executor executor;
+    for (Module* mod : vector<Module*>{&a, &b, &c, &d, &e, &f})
+    {
+        executor.AddModule(mod);
+    }
+
+    ThreadPool tp(2);
+    executor.ExecuteAll(tp);
+    executor.Wait();
+
+    for (Module* mod : vector<Module*>{&a, &b, &c, &d, &e, &f})
+    {
+        cout << mod->Name() << ": " << StateName(mod->State()) << endl;
+        mod->ClearState();
+    }
+}
+
+// 任务组取消：排队中的任务被直接丢弃，正在执行的任务通过 StopToken 提前退出
+void test3()
+{
+    ThreadPool tp(2);
+    atomic<int> finished{0};
+    atomic<int> interrupted{0};
+    {
+        TaskGroup group(tp);
+        for (int i = 0; i < 100; i++)
+        {
+            group.Run([&finished, &interrupted](StopToken token) {
+                for (int step = 0; step < 10; step++)
+                {
+                    if (token.StopRequested())
+                    {
+                        interrupted++;
+                        return;
+                    }
+                    this_thread::sleep_for(std::chrono::milliseconds(5));
+                }
+                finished++;
+            });
+        }
+        this_thread::sleep_for(std::chrono::milliseconds(220));
+        group.Cancel();
+        group.Wait();
+    }
+    cout << "finished: " << finished << " interrupted: " << interrupted
+         << " dropped: " << 100 - finished - interrupted << endl;
+
+    // 执行器取消：慢模块被中断，下游全部跳过
+    ModuleSlow s("S", {});
+    ModuleA x("X", {"S"});
+    Executor executor;
+    executor.AddModule(&s);
+    executor.AddModule(&x);
+    thread canceller([&executor] {
+        this_thread::sleep_for(std::chrono::milliseconds(100));
+        executor.Cancel();
+    });
+    executor.ExecuteAll(tp);
+    canceller.join();
+    executor.Wait();
+    cout << "S: " << StateName(s.State()) << " X: " << StateName(x.State()) << endl;
+}
+
+// 增量执行：每帧只有少量输入变化，只重算受影响的模块
+//   pos -> A -> C -> D
+//   hp  -> B -> C
+//          E（独立）
+void test4()
+{
+    Versioned<int> pos(0);
+    Versioned<int> hp(100);
+
+    ModuleCount a("A", {});
+    ModuleCount b("B", {});
+    ModuleCount c("C", {"A", "B"});
+    ModuleCount d("D", {"C"});
+    ModuleCount e("E", {});
+    a.DeclareInput(&pos);
+    b.DeclareInput(&hp);
+
+    Executor executor;
+    vector<ModuleCount*> mods{&a, &b, &c, &d, &e};
+    for (Module* mod : mods)
+    {
+        executor.AddModule(mod);
+    }
+
+    ThreadPool tp(2);
+    auto run_frame = [&](const char* desc) {
+        executor.ExecuteDirty(tp);
+        executor.Wait();
+        cout << desc << " run times:";
+        for (ModuleCount* mod : mods)
+        {
+            cout << " " << mod->Name() << "=" << mod->RunTimes();
+        }
+        cout << endl;
+    };
+
+    run_frame("frame 1 (all)    ");
+    run_frame("frame 2 (nothing)");
+    hp.Set(90);
+    run_frame("frame 3 (hp)     ");
+    e.MarkDirty();
+    run_frame("frame 4 (E dirty)");
+}
+
+// 类型化数据流：生成 -> 缩放 -> 求和，数据都在 RunArena 上，按引用传递
+class ModuleGenerate : public Module
+{
+public:
+    ModuleGenerate(string name, int count) : Module(name, {}), count_(count) {}
+    void Execute() override
+    {
+        pmr::vector<int>& values = out.Emplace();
+        values.reserve(count_);
+        for (int i = 0; i < count_; i++) values.push_back(i);
+        SetSucc();
+    }
+    OutputPort<pmr::vector<int>> out{this};
+private:
+    int count_;
+};
+
+class ModuleScale : public Module
+{
+public:
+    ModuleScale(string name, const OutputPort<pmr::vector<int>>& source, int factor)
+        : Module(name, {}), in(this, source), factor_(factor) {}
+    void Execute() override
+    {
+        const pmr::vector<int>& source = in.Get();
+        pmr::vector<int>& values = out.Emplace();
+        values.reserve(source.size());
+        for (int v : source) values.push_back(v * factor_);
+        SetSucc();
+    }
+    InputPort<pmr::vector<int>> in;
+    OutputPort<pmr::vector<int>> out{this};
+private:
+    int factor_;
+};
+
+class ModuleSum : public Module
+{
+public:
+    ModuleSum(string name, const OutputPort<pmr::vector<int>>& lhs, const OutputPort<pmr::vector<int>>& rhs)
+        : Module(name, {}), left(this, lhs), right(this, rhs) {}
+    void Execute() override
+    {
+        int64_t sum = 0;
+        for (int v : left.Get()) sum += v;
+        for (int v : right.Get()) sum += v;
+        out.Emplace(sum);
+        SetSucc();
+    }
+    InputPort<pmr::vector<int>> left;
+    InputPort<pmr::vector<int>> right;
+    OutputPort<int64_t> out{this};
+};
+
+void test5()
+{
+    ModuleGenerate gen("Gen", 100000);
+    ModuleScale x2("X2", gen.out, 2);
+    ModuleScale x3("X3", gen.out, 3);
+    ModuleSum sum("Sum", x2.out, x3.out);
+
+    Executor executor;
+    for (Module* mod : vector<Module*>{&gen, &x2, &x3, &sum})
+    {
+        executor.AddModule(mod);
+    }
+
+    ThreadPool tp(2);
+    for (int run = 1; run <= 3; run++)
+    {
+        executor.ExecuteAll(tp);
+        executor.Wait();
+        cout << "run " << run << " sum=" << sum.out.Get()
+             << " arena used=" << executor.Arena().BytesUsed()
+             << " capacity=" << executor.Arena().Capacity()
+             << " upstream allocs=" << executor.Arena().UpstreamAllocs() << endl;
+        for (Module* mod : vector<Module*>{&gen, &x2, &x3, &sum})
+        {
+            mod->ClearState();
+        }
+    }
+
+    // 增量执行：每帧只有 X3 重算，旧输出不回收，累积到一定量后自动做一次完整执行
+    executor.ExecuteAll(tp);
+    executor.Wait();
+    size_t peak = 0;
+    for (int frame = 1; frame <= 100; frame++)
+    {
+        x3.MarkDirty();
+        executor.ExecuteDirty(tp);
+        executor.Wait();
+        peak = max(peak, executor.Arena().BytesUsed());
+    }
+    cout << "100 incremental frames sum=" << sum.out.Get() << " peak arena used=" << peak
+         << " capacity=" << executor.Arena().Capacity() << endl;
+    executor.EndRun();
+}
+
+// 记忆化演示：加载 -> 统计，两个模块都以输入内容为键缓存结果
+class ModuleLoad : public MemoModule<vector<int>>
+{
+public:
+    ModuleLoad(string name, ResultCache* cache, const string* source)
+        : MemoModule(name, {}, cache), source_(source) {}
+    int RunTimes() const { return run_times_; }
+protected:
+    void HashInputs(string& out) const override { Serialize(out, *source_); }
+    vector<int> Compute() override
+    {
+        run_times_++;
+        return vector<int>(source_->begin(), source_->end());
+    }
+private:
+    const string* source_;
+    atomic<int> run_times_{0};
+};
+
+class ModuleTotal : public MemoModule<int64_t>
+{
+public:
+    ModuleTotal(string name, ResultCache* cache, const ModuleLoad* load)
+        : MemoModule(name, {load->Name()}, cache), load_(load) {}
+    int RunTimes() const { return run_times_; }
+protected:
+    void HashInputs(string& out) const override { Serialize(out, load_->Output()); }
+    int64_t Compute() override
+    {
+        run_times_++;
+        int64_t total = 0;
+        for (int v : load_->Output()) total += v;
+        return total;
+    }
+private:
+    const ModuleLoad* load_;
+    atomic<int> run_times_{0};
+};
+
+void test6()
+{
+    string dir = (filesystem::temp_directory_path() / "dag_thread_pool_memo").string();
+    filesystem::remove_all(dir);
+    ResultCache cache(1 << 20, dir);
+
+    string source = "hello asset";
+    ModuleLoad load("Load", &cache, &source);
+    ModuleTotal total("Total", &cache, &load);
+    Executor executor;
+    executor.AddModule(&load);
+    executor.AddModule(&total);
+
+    ThreadPool tp(2);
+    auto run = [&](const char* desc) {
+        executor.ExecuteAll(tp);
+        executor.Wait();
+        cout << desc << " total=" << total.Output() << " computed: Load=" << load.RunTimes()
+             << " Total=" << total.RunTimes() << endl;
+        load.ClearState();
+        total.ClearState();
+    };
+    run("run 1 (cold)           ");
+    run("run 2 (same input)     ");
+    cache.ClearMemory();
+    run("run 3 (restart, disk)  ");
+    source = "hello world";
+    run("run 4 (input changed)  ");
+    cout << "hits=" << cache.Hits() << " disk_hits=" << cache.DiskHits() << " misses=" << cache.Misses() << endl;
+    executor.EndRun();
+    filesystem::remove_all(dir);
+}
+
+// processThreadPool.cpp 复用本文件的 Module/DAG 定义时会定义这个宏
+#ifndef DAG_THREAD_POOL_NO_MAIN
 int main()
 {
     test();
+    test2();
+    test3();
+    test4();
+    test5();
+    test6();
+#ifdef LOCK_PROFILING
+    LockProfiler::Print(cout);
+#endif
     return 0;
 }
+#endif
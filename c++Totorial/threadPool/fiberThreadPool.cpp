@@ -0,0 +1,864 @@
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+using namespace std;
+
+// 有栈协程（fiber）线程池，仅支持 Linux
+// 模块作为 fiber 运行，等待 I/O 或其他结果时只挂起 fiber 本身，工作线程转去执行其他 fiber
+// 上下文切换使用 ucontext；swapcontext 每次会额外做一次 sigprocmask 系统调用，
+// 对切换极其频繁的场景可以换成手写汇编的上下文切换，接口不变
+
+// 带保护页的栈：最低一页设为不可访问，栈溢出时直接段错误而不是悄悄踩坏相邻内存
+class FiberStack
+{
+public:
+    FiberStack() = default;
+    explicit FiberStack(size_t size)
+    {
+        _page = size_t(sysconf(_SC_PAGESIZE));
+        _size = (size + _page - 1) / _page * _page + _page;
+        void* mem = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+        if (mem == MAP_FAILED)
+        {
+            throw runtime_error("fiber stack mmap failed");
+        }
+        if (mprotect(mem, _page, PROT_NONE) != 0)
+        {
+            munmap(mem, _size);
+            throw runtime_error("fiber stack guard page failed");
+        }
+        _base = static_cast<char*>(mem);
+    }
+    ~FiberStack()
+    {
+        if (_base) munmap(_base, _size);
+    }
+    FiberStack(FiberStack&& other) noexcept { swap(other); }
+    FiberStack& operator=(FiberStack&& other) noexcept
+    {
+        swap(other);
+        return *this;
+    }
+
+    void* Bottom() const { return _base + _page; }
+    size_t Usable() const { return _size - _page; }
+    bool Valid() const { return _base != nullptr; }
+
+private:
+    void swap(FiberStack& other) noexcept
+    {
+        std::swap(_base, other._base);
+        std::swap(_size, other._size);
+        std::swap(_page, other._page);
+    }
+
+    char* _base = nullptr;
+    size_t _size = 0;
+    size_t _page = 0;
+};
+
+// 栈池：fiber 结束后栈回到空闲列表，避免反复 mmap/munmap
+class StackPool
+{
+public:
+    explicit StackPool(size_t stack_size) : _stack_size(stack_size) {}
+
+    FiberStack Acquire()
+    {
+        {
+            lock_guard<mutex> lock(_mutex);
+            if (!_free.empty())
+            {
+                FiberStack stack = move(_free.back());
+                _free.pop_back();
+                return stack;
+            }
+        }
+        return FiberStack(_stack_size);
+    }
+
+    void Release(FiberStack stack)
+    {
+        lock_guard<mutex> lock(_mutex);
+        _free.push_back(move(stack));
+    }
+
+private:
+    size_t _stack_size;
+    mutex _mutex;
+    vector<FiberStack> _free;
+};
+
+class FiberScheduler;
+
+struct Fiber
+{
+    ucontext_t ctx;
+    function<void()> func;
+    FiberStack stack;
+    FiberScheduler* sched = nullptr;
+    bool finished = false;
+};
+
+// 每个工作线程的调度上下文
+struct FiberWorker
+{
+    ucontext_t sched_ctx;
+    Fiber* current = nullptr;
+    // 切回调度上下文之后才执行的动作：
+    // fiber 挂起前把自己放进等待队列，但持有队列锁，直到真正切走后才由工作线程解锁，
+    // 这样唤醒方拿到锁时，fiber 一定已经完整地保存了上下文，不会被两个线程同时运行
+    mutex* unlock_after = nullptr;
+    bool requeue_after = false;
+};
+
+class FiberScheduler
+{
+public:
+    FiberScheduler(int num_workers, size_t stack_size = 64 * 1024)
+        : _stacks(stack_size)
+    {
+        _timer = thread([this]() { TimerLoop(); });
+        for (int i = 0; i < num_workers; i++)
+        {
+            _workers.emplace_back([this]() { WorkerLoop(); });
+        }
+    }
+
+    ~FiberScheduler()
+    {
+        WaitAll();
+        {
+            lock_guard<mutex> lock(_mutex);
+            _stop = true;
+        }
+        _cv.notify_all();
+        for (auto& t : _workers) t.join();
+        {
+            lock_guard<mutex> lock(_timer_mutex);
+            _timer_stop = true;
+        }
+        _timer_cv.notify_all();
+        _timer.join();
+    }
+
+    void Spawn(function<void()> func)
+    {
+        Fiber* fiber = new Fiber;
+        fiber->func = move(func);
+        fiber->sched = this;
+        fiber->stack = _stacks.Acquire();
+        getcontext(&fiber->ctx);
+        fiber->ctx.uc_stack.ss_sp = fiber->stack.Bottom();
+        fiber->ctx.uc_stack.ss_size = fiber->stack.Usable();
+        fiber->ctx.uc_link = nullptr;
+        makecontext(&fiber->ctx, &FiberScheduler::Entry, 0);
+        _live.fetch_add(1, memory_order_relaxed);
+        Ready(fiber);
+    }
+
+    // 等待所有 fiber 结束
+    void WaitAll()
+    {
+        unique_lock<mutex> lock(_mutex);
+        _done_cv.wait(lock, [this]() { return _live.load(memory_order_acquire) == 0; });
+    }
+
+    // 当前正在运行的 fiber，不在 fiber 中时返回 nullptr
+    static Fiber* Current()
+    {
+        FiberWorker* worker = CurrentWorker();
+        return worker ? worker->current : nullptr;
+    }
+
+    // 让出执行权，重新排到就绪队列末尾
+    static void Yield()
+    {
+        FiberWorker* worker = CurrentWorker();
+        if (!worker || !worker->current)
+        {
+            this_thread::yield();
+            return;
+        }
+        worker->requeue_after = true;
+        SwitchOut(worker);
+    }
+
+    // 挂起当前 fiber：调用方已持有 guard 并把 fiber 放进了等待队列，切走之后由工作线程解锁 guard
+    // 只能在 fiber 里调用；同步原语通过 FiberWaiter 等待，普通线程会退化为阻塞等待
+    static void Park(unique_lock<mutex>& guard)
+    {
+        FiberWorker* worker = CurrentWorker();
+        if (!worker || !worker->current)
+        {
+            throw logic_error("FiberScheduler::Park called outside a fiber");
+        }
+        worker->unlock_after = guard.release();
+        SwitchOut(worker);
+    }
+
+    // 唤醒一个挂起的 fiber
+    void Ready(Fiber* fiber)
+    {
+        {
+            lock_guard<mutex> lock(_mutex);
+            _ready.push_back(fiber);
+        }
+        _cv.notify_one();
+    }
+
+    // 模拟 I/O 等待：fiber 挂起到定时器上，不占用工作线程
+    static void SleepFor(chrono::milliseconds duration)
+    {
+        Fiber* fiber = Current();
+        if (!fiber)
+        {
+            this_thread::sleep_for(duration);
+            return;
+        }
+        FiberScheduler* sched = fiber->sched;
+        unique_lock<mutex> lock(sched->_timer_mutex);
+        sched->_timers.push(Timer{chrono::steady_clock::now() + duration, fiber});
+        sched->_timer_cv.notify_one();
+        Park(lock);
+    }
+
+private:
+    struct Timer
+    {
+        chrono::steady_clock::time_point deadline;
+        Fiber* fiber;
+        bool operator>(const Timer& other) const { return deadline > other.deadline; }
+    };
+
+    // fiber 可能在不同线程上恢复，thread_local 的地址不能跨切换缓存，每次都重新读取
+    static FiberWorker*& WorkerSlot()
+    {
+        static thread_local FiberWorker* worker = nullptr;
+        return worker;
+    }
+
+    __attribute__((noinline)) static FiberWorker* CurrentWorker()
+    {
+        FiberWorker* volatile worker = WorkerSlot();
+        return worker;
+    }
+
+    static void SwitchOut(FiberWorker* worker)
+    {
+        Fiber* fiber = worker->current;
+        swapcontext(&fiber->ctx, &worker->sched_ctx);
+        // 恢复后可能已经在另一个工作线程上，不能再使用 worker
+    }
+
+    static void Entry()
+    {
+        Fiber* fiber = CurrentWorker()->current;
+        try
+        {
+            fiber->func();
+        }
+        catch (const exception& e)
+        {
+            cerr << "Fiber exception: " << e.what() << endl;
+        }
+        catch (...)
+        {
+            cerr << "Unknown fiber exception" << endl;
+        }
+        fiber->finished = true;
+        SwitchOut(CurrentWorker());
+    }
+
+    void WorkerLoop()
+    {
+        FiberWorker worker;
+        WorkerSlot() = &worker;
+        while (true)
+        {
+            Fiber* fiber = nullptr;
+            {
+                unique_lock<mutex> lock(_mutex);
+                _cv.wait(lock, [this]() { return _stop || !_ready.empty(); });
+                if (_ready.empty()) break;
+                fiber = _ready.front();
+                _ready.pop_front();
+            }
+
+            worker.current = fiber;
+            swapcontext(&worker.sched_ctx, &fiber->ctx);
+            worker.current = nullptr;
+
+            if (fiber->finished)
+            {
+                _stacks.Release(move(fiber->stack));
+                delete fiber;
+                if (_live.fetch_sub(1, memory_order_acq_rel) == 1)
+                {
+                    lock_guard<mutex> lock(_mutex);
+                    _done_cv.notify_all();
+                }
+            }
+            else if (worker.requeue_after)
+            {
+                worker.requeue_after = false;
+                Ready(fiber);
+            }
+            if (worker.unlock_after)
+            {
+                worker.unlock_after->unlock();
+                worker.unlock_after = nullptr;
+            }
+        }
+        WorkerSlot() = nullptr;
+    }
+
+    void TimerLoop()
+    {
+        unique_lock<mutex> lock(_timer_mutex);
+        while (!_timer_stop)
+        {
+            if (_timers.empty())
+            {
+                _timer_cv.wait(lock);
+                continue;
+            }
+            auto deadline = _timers.top().deadline;
+            if (chrono::steady_clock::now() < deadline)
+            {
+                _timer_cv.wait_until(lock, deadline);
+                continue;
+            }
+            while (!_timers.empty() && _timers.top().deadline <= chrono::steady_clock::now())
+            {
+                Ready(_timers.top().fiber);
+                _timers.pop();
+            }
+        }
+    }
+
+private:
+    StackPool _stacks;
+    vector<thread> _workers;
+    deque<Fiber*> _ready;
+    mutex _mutex;
+    condition_variable _cv;
+    condition_variable _done_cv;
+    atomic<int> _live{0};
+    bool _stop = false;
+
+    thread _timer;
+    mutex _timer_mutex;
+    condition_variable _timer_cv;
+    priority_queue<Timer, vector<Timer>, greater<Timer>> _timers;
+    bool _timer_stop = false;
+};
+
+// 同步原语的等待者
+// 在 fiber 里等待时挂起 fiber，工作线程转去执行其他 fiber；
+// 在普通线程（例如主线程）里没有 fiber 可挂起，退化为在自己的条件变量上阻塞这个线程
+struct FiberWaiter
+{
+    Fiber* fiber = FiberScheduler::Current();
+    mutex mtx;
+    condition_variable cv;
+    bool woken = false;
+
+    // 调用方持有 guard 并已把 this 放进等待队列；返回时已被唤醒，guard 已释放
+    void Sleep(unique_lock<mutex>& guard)
+    {
+        if (fiber)
+        {
+            FiberScheduler::Park(guard);
+            return;
+        }
+        guard.unlock();
+        unique_lock<mutex> lock(mtx);
+        cv.wait(lock, [this]() { return woken; });
+    }
+
+    // 唤醒后等待方随时可能返回并销毁 this，之后不能再访问
+    void Wake()
+    {
+        if (Fiber* target = fiber)
+        {
+            target->sched->Ready(target);
+            return;
+        }
+        // 在锁内通知：等待方拿到锁返回前，这里已经不再使用 cv
+        lock_guard<mutex> lock(mtx);
+        woken = true;
+        cv.notify_one();
+    }
+};
+
+// fiber 版信号量：接口与 semaphore/Semaphore.cpp 一致，等待时挂起 fiber 而不是阻塞线程
+class FiberSemaphore
+{
+public:
+    FiberSemaphore(int count = 0) : _count(count) {}
+
+    void wait()
+    {
+        unique_lock<mutex> lock(_guard);
+        if (_count > 0)
+        {
+            _count--;
+            return;
+        }
+        FiberWaiter waiter;
+        _waiters.push_back(&waiter);
+        waiter.Sleep(lock);
+    }
+
+    // 有等待者时把资源直接交给它，否则计数加一
+    void signal()
+    {
+        FiberWaiter* waiter = nullptr;
+        {
+            lock_guard<mutex> lock(_guard);
+            if (_waiters.empty())
+            {
+                _count++;
+                return;
+            }
+            waiter = _waiters.front();
+            _waiters.pop_front();
+        }
+        waiter->Wake();
+    }
+
+private:
+    mutex _guard;
+    deque<FiberWaiter*> _waiters;
+    int _count;
+};
+
+// fiber 版互斥锁：满足 Lockable，可以配合 lock_guard/unique_lock 使用
+class FiberMutex
+{
+public:
+    void lock()
+    {
+        unique_lock<mutex> guard(_guard);
+        if (!_locked)
+        {
+            _locked = true;
+            return;
+        }
+        FiberWaiter waiter;
+        _waiters.push_back(&waiter);
+        waiter.Sleep(guard);
+        // 被唤醒时锁已经直接移交给当前 fiber
+    }
+
+    bool try_lock()
+    {
+        lock_guard<mutex> guard(_guard);
+        if (_locked) return false;
+        _locked = true;
+        return true;
+    }
+
+    void unlock()
+    {
+        FiberWaiter* waiter = nullptr;
+        {
+            lock_guard<mutex> guard(_guard);
+            if (_waiters.empty())
+            {
+                _locked = false;
+                return;
+            }
+            waiter = _waiters.front();
+            _waiters.pop_front();
+        }
+        waiter->Wake();
+    }
+
+private:
+    mutex _guard;
+    deque<FiberWaiter*> _waiters;
+    bool _locked = false;
+};
+
+// fiber 版条件变量
+class FiberCondVar
+{
+public:
+    void wait(unique_lock<FiberMutex>& lock)
+    {
+        FiberWaiter waiter;
+        unique_lock<mutex> guard(_guard);
+        // 先登记再释放用户锁，notify 需要拿 _guard，因此不会丢失通知
+        _waiters.push_back(&waiter);
+        lock.mutex()->unlock();
+        waiter.Sleep(guard);
+        lock.mutex()->lock();
+    }
+
+    template<typename Predicate>
+    void wait(unique_lock<FiberMutex>& lock, Predicate pred)
+    {
+        while (!pred()) wait(lock);
+    }
+
+    void notify_one()
+    {
+        FiberWaiter* waiter = nullptr;
+        {
+            lock_guard<mutex> guard(_guard);
+            if (_waiters.empty()) return;
+            waiter = _waiters.front();
+            _waiters.pop_front();
+        }
+        waiter->Wake();
+    }
+
+    void notify_all()
+    {
+        deque<FiberWaiter*> waiters;
+        {
+            lock_guard<mutex> guard(_guard);
+            waiters.swap(_waiters);
+        }
+        for (FiberWaiter* waiter : waiters) waiter->Wake();
+    }
+
+private:
+    mutex _guard;
+    deque<FiberWaiter*> _waiters;
+};
+
+// 一次性事件：用于模块之间等待依赖完成
+class FiberEvent
+{
+public:
+    void Wait()
+    {
+        unique_lock<mutex> guard(_guard);
+        if (_set) return;
+        FiberWaiter waiter;
+        _waiters.push_back(&waiter);
+        waiter.Sleep(guard);
+    }
+
+    void Set()
+    {
+        deque<FiberWaiter*> waiters;
+        {
+            lock_guard<mutex> guard(_guard);
+            _set = true;
+            waiters.swap(_waiters);
+        }
+        for (FiberWaiter* waiter : waiters) waiter->Wake();
+    }
+
+private:
+    mutex _guard;
+    deque<FiberWaiter*> _waiters;
+    bool _set = false;
+};
+
+enum class ModuleState : int
+{
+    kPending = 0,
+    kSucc,
+    kFailed,
+    kCancelled,
+};
+
+// 与 DAGThreadPool.cpp 相同的模块接口，Execute 运行在 fiber 上，可以挂起等待
+// Execute 正常返回且没有自己设置状态时，由执行器记为成功
+class Module
+{
+public:
+    Module(string name, vector<string> deps) : name_(name), deps_(deps) {}
+    virtual ~Module() = default;
+    virtual void Execute() = 0;
+    const string& Name() const { return name_; }
+    const vector<string>& Deps() const { return deps_; }
+    bool CheckSucc() const { return state_ == ModuleState::kSucc; }
+    ModuleState State() const { return state_; }
+    void SetSucc() { state_ = ModuleState::kSucc; }
+    void SetFailed() { state_ = ModuleState::kFailed; }
+    void SetCancelled() { state_ = ModuleState::kCancelled; }
+    void ClearState() { state_ = ModuleState::kPending; }
+
+private:
+    string name_;
+    vector<string> deps_;
+    // 只在模块自己的 fiber 里写，下游在完成事件之后读，事件内部的锁保证可见性
+    ModuleState state_ = ModuleState::kPending;
+};
+
+// fiber 执行器：所有模块一次性作为 fiber 启动，各自在依赖的事件上等待，
+// 等待期间不占用工作线程，不需要像 DAGThreadPool.cpp 的 Executor 那样由派发线程阻塞等待
+class FiberExecutor
+{
+public:
+    void AddModule(Module* module)
+    {
+        _modules[module->Name()] = module;
+    }
+
+    // 依赖不存在时在启动任何 fiber 之前抛出 invalid_argument
+    // 模块抛出异常记为失败，任一依赖没有成功则不执行、记为取消；无论哪种情况都会设置完成事件，下游不会永远等待
+    void ExecuteAll(FiberScheduler& sched)
+    {
+        for (auto& mod : _modules)
+        {
+            for (auto& dep : mod.second->Deps())
+            {
+                if (_modules.find(dep) == _modules.end())
+                {
+                    throw invalid_argument("Module " + mod.first + " depends on unknown module " + dep);
+                }
+            }
+        }
+        unordered_map<string, unique_ptr<FiberEvent>> done;
+        for (auto& mod : _modules)
+        {
+            mod.second->ClearState();
+            done[mod.first] = make_unique<FiberEvent>();
+        }
+        for (auto& mod : _modules)
+        {
+            Module* module = mod.second;
+            vector<pair<Module*, FiberEvent*>> deps;
+            for (auto& dep : module->Deps())
+            {
+                deps.emplace_back(_modules.at(dep), done.at(dep).get());
+            }
+            FiberEvent* finished = done.at(module->Name()).get();
+            sched.Spawn([module, deps, finished]() {
+                // 离开时总是设置完成事件
+                struct SetOnExit
+                {
+                    FiberEvent* event;
+                    ~SetOnExit() { event->Set(); }
+                } set_on_exit{finished};
+
+                bool deps_succ = true;
+                for (auto& dep : deps)
+                {
+                    dep.second->Wait();
+                    deps_succ = deps_succ && dep.first->CheckSucc();
+                }
+                if (!deps_succ)
+                {
+                    module->SetCancelled();
+                    return;
+                }
+                try
+                {
+                    module->Execute();
+                    if (module->State() == ModuleState::kPending) module->SetSucc();
+                }
+                catch (const exception& e)
+                {
+                    cerr << "Module " << module->Name() << " failed: " << e.what() << endl;
+                    module->SetFailed();
+                }
+                catch (...)
+                {
+                    cerr << "Module " << module->Name() << " failed: unknown exception" << endl;
+                    module->SetFailed();
+                }
+            });
+        }
+        sched.WaitAll();
+    }
+
+private:
+    unordered_map<string, Module*> _modules;
+};
+
+// 模拟等待 I/O 的模块
+class ModuleIO : public Module
+{
+public:
+    ModuleIO(string name, vector<string> deps, FiberMutex& log_mutex)
+        : Module(name, deps), log_mutex_(log_mutex) {}
+    void Execute() override
+    {
+        FiberScheduler::SleepFor(chrono::milliseconds(100));
+        lock_guard<FiberMutex> lock(log_mutex_);
+        cout << "Executing: " << Name() << " Tid: " << this_thread::get_id() << endl;
+    }
+private:
+    FiberMutex& log_mutex_;
+};
+
+// 抛出非标准异常的模块
+class ModuleFaulty : public Module
+{
+public:
+    ModuleFaulty(string name, vector<string> deps) : Module(name, deps) {}
+    void Execute() override
+    {
+        throw 42;
+    }
+};
+
+void test1()
+{
+    // 与 DAGThreadPool.cpp::test 相同的图，只用 2 个工作线程
+    FiberMutex log_mutex;
+    ModuleIO a("A", {}, log_mutex);
+    ModuleIO b("B", {}, log_mutex);
+    ModuleIO c("C", {"A", "B"}, log_mutex);
+    ModuleIO d("D", {"C"}, log_mutex);
+    ModuleIO e("E", {"C", "D"}, log_mutex);
+
+    FiberExecutor executor;
+    for (Module* mod : vector<Module*>{&a, &b, &c, &d, &e})
+    {
+        executor.AddModule(mod);
+    }
+    FiberScheduler sched(2);
+    executor.ExecuteAll(sched);
+
+    // 失败的模块：下游被取消而不是永远等待，依赖名写错在启动前就报错
+    ModuleFaulty f("F", {"A"});
+    ModuleIO g("G", {"F"}, log_mutex);
+    FiberExecutor faulty;
+    for (Module* mod : vector<Module*>{&a, &f, &g})
+    {
+        faulty.AddModule(mod);
+    }
+    faulty.ExecuteAll(sched);
+    cout << "F failed: " << (f.State() == ModuleState::kFailed)
+         << " G cancelled: " << (g.State() == ModuleState::kCancelled) << endl;
+    ModuleIO h("H", {"missing"}, log_mutex);
+    faulty.AddModule(&h);
+    try
+    {
+        faulty.ExecuteAll(sched);
+    }
+    catch (const invalid_argument& e)
+    {
+        cout << e.what() << endl;
+    }
+
+    // 生产者-消费者：条件变量 + 信号量限流
+    FiberMutex mtx;
+    FiberCondVar cv;
+    FiberSemaphore io_slots(4);
+    deque<int> items;
+    int consumed = 0;
+    atomic<int> max_in_io{0};
+    atomic<int> in_io{0};
+    for (int i = 0; i < 100; i++)
+    {
+        sched.Spawn([&, i]() {
+            io_slots.wait();
+            int now = ++in_io;
+            int prev = max_in_io.load();
+            while (now > prev && !max_in_io.compare_exchange_weak(prev, now)) {}
+            FiberScheduler::SleepFor(chrono::milliseconds(5));
+            --in_io;
+            io_slots.signal();
+
+            lock_guard<FiberMutex> lock(mtx);
+            items.push_back(i);
+            cv.notify_one();
+        });
+    }
+    sched.Spawn([&]() {
+        while (consumed < 100)
+        {
+            unique_lock<FiberMutex> lock(mtx);
+            cv.wait(lock, [&items]() { return !items.empty(); });
+            items.pop_front();
+            consumed++;
+        }
+    });
+    sched.WaitAll();
+    cout << "consumed: " << consumed << " max concurrent io: " << max_in_io << endl;
+
+    // 普通线程也能使用这些原语：主线程没有 fiber 可挂起，阻塞等待 fiber 设置事件、释放锁
+    FiberEvent ready;
+    FiberMutex shared;
+    sched.Spawn([&ready, &shared]() {
+        lock_guard<FiberMutex> lock(shared);
+        ready.Set();
+        FiberScheduler::SleepFor(chrono::milliseconds(20));
+    });
+    ready.Wait();
+    lock_guard<FiberMutex> lock(shared);
+    cout << "main thread got the fiber event and mutex" << endl;
+}
+
+// 基准：8 个工作线程上同时有 10000 个在等待的模块
+// 用法：fiberThreadPool [fiber 数] [工作线程数]
+void bench(int num_fibers, int num_workers)
+{
+    const auto io = chrono::milliseconds(10);
+    const int rounds = 5;
+    atomic<int> finished{0};
+    auto start = chrono::steady_clock::now();
+    {
+        FiberScheduler sched(num_workers);
+        for (int i = 0; i < num_fibers; i++)
+        {
+            sched.Spawn([&finished, io]() {
+                for (int r = 0; r < rounds; r++)
+                {
+                    FiberScheduler::SleepFor(io);
+                }
+                finished++;
+            });
+        }
+        sched.WaitAll();
+    }
+    double fiber_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "fibers:  " << finished << " modules x " << rounds << " waits on " << num_workers << " workers: "
+         << fiber_ms << " ms, " << finished * 1000.0 / fiber_ms << " modules/s" << endl;
+
+    // 对照：阻塞式线程池，只跑少量任务估算吞吐
+    const int blocking_tasks = num_workers * 10;
+    finished = 0;
+    start = chrono::steady_clock::now();
+    {
+        vector<thread> workers;
+        atomic<int> next{0};
+        for (int w = 0; w < num_workers; w++)
+        {
+            workers.emplace_back([&]() {
+                while (next++ < blocking_tasks)
+                {
+                    for (int r = 0; r < rounds; r++) this_thread::sleep_for(io);
+                    finished++;
+                }
+            });
+        }
+        for (auto& t : workers) t.join();
+    }
+    double thread_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "threads: " << finished << " modules x " << rounds << " waits on " << num_workers << " workers: "
+         << thread_ms << " ms, " << finished * 1000.0 / thread_ms << " modules/s" << endl;
+}
+
+int main(int argc, char** argv)
+{
+    test1();
+    int num_fibers = argc > 1 ? atoi(argv[1]) : 10000;
+    int num_workers = argc > 2 ? atoi(argv[2]) : 8;
+    bench(num_fibers, num_workers);
+    return 0;
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <chrono>
 #include <functional>
 #include <queue>
 #include <vector>
@@ -7,17 +9,22 @@
 #include <condition_variable>
 using namespace std;
 
+#include "../syncTypes/SyncTypes.h"
+#include "../semaphore/RateLimiter.h"
+
 class Task
 {
 public:
-    Task() : priority(0), task(nullptr) {}
-    Task(int priority, function<void()> task) : priority(priority), task(task) {}
+    Task() : priority(0) {}
+    Task(int priority, TaskFunc task, int64_t enqueued = 0) : priority(priority), task(move(task)), enqueued(enqueued) {}
     bool operator<(const Task& other) const { return priority < other.priority; }
     const int getPriority() const { return priority; }
-    const function<void()> getTask() const { return task; }
+    TaskFunc& getTask() { return task; }
+    int64_t getEnqueued() const { return enqueued; }
 private:
     int priority;
-    function<void()> task;
+    TaskFunc task;
+    int64_t enqueued;   // 入队时间（纳秒），用来算排队延迟
 };
 
 class ThreadPool
@@ -33,7 +40,7 @@ public:
     ~ThreadPool()
     {
         {
-            unique_lock<mutex> lock(_queue_mutex);
+            unique_lock<Mutex> lock(_queue_mutex);
             _stop = true;
         }
         _cv.notify_all();
@@ -53,15 +60,30 @@ public:
             while (true)
             {
                 Task task;
+                size_t wake = 0;
                 {
-                    unique_lock<mutex> lock(_queue_mutex);
-                    _cv.wait(lock, [this]() { return _stop || !_tasks.empty(); });
+                    unique_lock<Mutex> lock(_queue_mutex);
+                    size_t promoted = 0;
+                    while (true)
+                    {
+                        promoted += PromoteDelayed();
+                        if (_stop || !_tasks.empty()) break;
+                        _delayed.Wait(_cv, lock);
+                    }
                     if (_stop && _tasks.empty())
                     {
                         return;
                     }
-                    task = _tasks.top();
+                    // top() 只给出 const 引用，马上就要 pop，直接移走避免拷贝闭包
+                    task = move(const_cast<Task&>(_tasks.top()));
                     _tasks.pop();
+                    RecordWait(task.getEnqueued());
+                    wake = min(promoted, _tasks.size());
+                }
+                // 一次移过来多个到期任务时，叫醒别的线程一起执行
+                for (size_t i = 0; i < wake; ++i)
+                {
+                    _cv.notify_one();
                 }
                 try
                 {
@@ -85,19 +107,97 @@ public:
     {
         auto task = bind(forward<F>(f), forward<Args>(args)...);
         {
-            unique_lock<mutex> lock(_queue_mutex);
-            _tasks.emplace(priority, task);
+            unique_lock<Mutex> lock(_queue_mutex);
+            Enqueue(priority, move(task));
         }
         _cv.notify_one();
     }
+
+    // 延时任务：到点后才按 priority 进入优先级队列（见 semaphore/RateLimiter.h 的 DelayedQueue）；
+    // 线程池析构时剩余的延时任务立即执行
+    template<typename F>
+    void PutTaskAfter(chrono::nanoseconds delay, int priority, F&& f)
+    {
+        if (delay <= chrono::nanoseconds::zero())
+        {
+            PutTask(priority, forward<F>(f));
+            return;
+        }
+        bool earliest;
+        {
+            unique_lock<Mutex> lock(_queue_mutex);
+            earliest = _delayed.Push(delay, Task(priority, TaskFunc(forward<F>(f))));
+        }
+        if (earliest) _cv.notify_one();
+    }
+
+    // 准入控制只管 Submit 提交的任务，PutTask 不受影响
+    void SetAdmission(AdmissionHook hook) { _admission.Set(move(hook)); }
+
+    // 经过准入控制的提交，被拒绝时返回 false，任务不会执行
+    template<typename F>
+    bool Submit(int priority, F&& f, double cost = 1.0)
+    {
+        return _admission.Submit(QueueLatency(), cost,
+            [&]() { PutTask(priority, forward<F>(f)); },
+            [&](chrono::nanoseconds delay) { PutTaskAfter(delay, priority, forward<F>(f)); });
+    }
+
+    // 排队延迟的估计（队列为空时为 0）
+    // 堆顶是优先级最高的任务，它等了多久说明不了新任务要等多久：新任务可能插到它前面，也可能排在一串高优先级任务后面。
+    // 这里用最近出队的任务实际等待时间的滑动平均；工作线程都被占着、队列一直没有出队时，
+    // 再取队列非空以来没有出队的时长，两者中较大的一个
+    chrono::nanoseconds QueueLatency()
+    {
+        unique_lock<Mutex> lock(_queue_mutex);
+        if (_tasks.empty()) return chrono::nanoseconds::zero();
+        int64_t stalled = NowNs() - max(_last_dequeue_ns, _nonempty_since_ns);
+        return chrono::nanoseconds(max(_wait_avg_ns, stalled));
+    }
 private:
+    // 以下在 _queue_mutex 内调用
+    void Enqueue(int priority, TaskFunc func)
+    {
+        int64_t now = NowNs();
+        if (_tasks.empty()) _nonempty_since_ns = now;
+        _tasks.emplace(priority, move(func), now);
+    }
+
+    // 到期的延时任务按各自的优先级移到优先级队列
+    size_t PromoteDelayed()
+    {
+        return _delayed.Promote(_stop, [this](Task&& task) {
+            Enqueue(task.getPriority(), move(task.getTask()));
+        });
+    }
+
+    // 出队时记下实际等待时间，滑动平均的权重为 1/8
+    void RecordWait(int64_t enqueued_ns)
+    {
+        int64_t now = NowNs();
+        _wait_avg_ns += (now - enqueued_ns - _wait_avg_ns) / 8;
+        _last_dequeue_ns = now;
+    }
+
+    static int64_t NowNs()
+    {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
     priority_queue<Task> _tasks;
+    DelayedQueue<Task> _delayed;
     vector<thread> _threads;
-    mutex _queue_mutex;
-    condition_variable _cv;
+    Mutex _queue_mutex;
+    CondVar _cv;
     bool _stop;
+    int64_t _wait_avg_ns = 0;
+    int64_t _last_dequeue_ns = 0;
+    int64_t _nonempty_since_ns = 0;
+    AdmissionGate _admission;
 };
 
+// bench/ 下的基准复用本文件的优先级线程池时会定义这个宏
+#ifndef PRIORITY_THREAD_POOL_NO_MAIN
 void ThreadPoolTest() {
   std::cout << "------------ThreadPoolTest Start------------" << endl;
 
@@ -132,5 +232,9 @@ void ThreadPoolTest() {
 int main()
 {
     ThreadPoolTest();
+#ifdef LOCK_PROFILING
+    LockProfiler::Print(cout);
+#endif
     return 0;
 }
+#endif
@@ -0,0 +1,653 @@
+// 多进程执行器：工作线程换成子进程，容易崩溃或吃内存的插件模块不会拖垮主进程
+// Module 和 DAG 的定义直接复用 DAGThreadPool.cpp，只靠依赖和执行状态协作的模块不需要任何修改
+//
+// 任务和结果通过 memfd 共享内存里的无锁环形队列传递，空闲时用跨进程 futex（SharedEventCount）睡眠
+// 子进程崩溃后父进程通过 waitpid 发现，重新 fork 一个工作进程，并把丢失的任务重新派发
+//
+// 限制：模块在子进程中执行，父进程和其他子进程只拿到执行状态
+//      用 OutputPort / InputPort 传数据的模块和 MemoModule，下游会在另一个子进程里读到 fork 时的旧值，
+//      AddModule 直接拒绝；子进程里也没有 RunArena。其他需要跨进程传递的数据应放在共享内存中
+//
+// 编译：g++ -std=c++17 -O2 -pthread processThreadPool.cpp
+
+#define DAG_THREAD_POOL_NO_MAIN
+#include "DAGThreadPool.cpp"
+#include "../eventCount/EventCount.h"
+
+#include <csignal>
+#include <new>
+#include <type_traits>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// memfd 创建的共享内存，MAP_SHARED 映射后 fork 出来的子进程看到同一块物理内存
+class SharedRegion
+{
+public:
+    SharedRegion(const char* name, size_t bytes) : _size(bytes)
+    {
+        _fd = memfd_create(name, MFD_CLOEXEC);
+        if (_fd < 0)
+        {
+            throw runtime_error("memfd_create failed");
+        }
+        if (ftruncate(_fd, off_t(bytes)) != 0)
+        {
+            close(_fd);
+            throw runtime_error("ftruncate failed");
+        }
+        _addr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+        if (_addr == MAP_FAILED)
+        {
+            close(_fd);
+            throw runtime_error("mmap failed");
+        }
+    }
+
+    ~SharedRegion()
+    {
+        munmap(_addr, _size);
+        close(_fd);
+    }
+
+    SharedRegion(const SharedRegion&) = delete;
+    SharedRegion& operator=(const SharedRegion&) = delete;
+
+    void* Data() const { return _addr; }
+    size_t Size() const { return _size; }
+
+private:
+    int _fd = -1;
+    void* _addr = nullptr;
+    size_t _size = 0;
+};
+
+// 共享内存中的单生产者单消费者环形队列，元素必须可以按字节拷贝
+template<typename T, uint32_t N>
+struct ShmRing
+{
+    static_assert(is_trivially_copyable<T>::value, "ShmRing requires a trivially copyable element");
+    static_assert((N & (N - 1)) == 0, "ShmRing capacity must be a power of two");
+
+    alignas(64) atomic<uint32_t> head{0};  // 消费者推进
+    alignas(64) atomic<uint32_t> tail{0};  // 生产者推进
+    alignas(64) T slots[N];
+
+    bool TryPush(const T& value)
+    {
+        uint32_t t = tail.load(memory_order_relaxed);
+        if (t - head.load(memory_order_acquire) == N) return false;
+        slots[t & (N - 1)] = value;
+        tail.store(t + 1, memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& value)
+    {
+        uint32_t h = head.load(memory_order_relaxed);
+        if (h == tail.load(memory_order_acquire)) return false;
+        value = slots[h & (N - 1)];
+        head.store(h + 1, memory_order_release);
+        return true;
+    }
+
+    void Reset()
+    {
+        head.store(0, memory_order_relaxed);
+        tail.store(0, memory_order_relaxed);
+    }
+};
+
+struct TaskMsg
+{
+    uint32_t task;
+    uint32_t attempt;
+    int64_t sent_ns;
+};
+
+struct ResultMsg
+{
+    uint32_t task;
+    uint32_t attempt;
+    int32_t state;
+    int64_t sent_ns;
+};
+
+int64_t NowNs()
+{
+    // steady_clock 对应 CLOCK_MONOTONIC，父子进程读到的是同一个时钟
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 工作进程池：每个子进程一对任务/结果队列，父进程是唯一的派发者和结果消费者
+class ProcessPool
+{
+public:
+    static constexpr uint32_t kRingSize = 256;
+    static constexpr uint32_t kStopTask = UINT32_MAX;
+
+    // 子进程里执行任务的回调，返回值原样作为结果状态送回父进程
+    using Runner = function<int32_t(uint32_t task)>;
+
+    ProcessPool(int workers, Runner runner)
+        : _runner(move(runner)),
+          _region("process_pool", sizeof(Shared) + sizeof(Channel) * size_t(max(workers, 1)))
+    {
+        if (workers <= 0)
+        {
+            throw invalid_argument("ProcessPool needs at least one worker");
+        }
+        _shared = new (_region.Data()) Shared();
+        _channels = reinterpret_cast<Channel*>(static_cast<char*>(_region.Data()) + sizeof(Shared));
+        _pids.assign(workers, -1);
+        for (int i = 0; i < workers; ++i)
+        {
+            new (&_channels[i]) Channel();
+            Spawn(i);
+        }
+    }
+
+    ~ProcessPool()
+    {
+        for (size_t i = 0; i < _pids.size(); ++i)
+        {
+            TaskMsg stop{kStopTask, 0, 0};
+            while (!_channels[i].tasks.TryPush(stop))
+            {
+                if (waitpid(_pids[i], nullptr, WNOHANG) == _pids[i])
+                {
+                    _pids[i] = -1;
+                    break;
+                }
+                this_thread::yield();
+            }
+            _channels[i].task_ready.NotifyOne();
+        }
+        for (pid_t pid : _pids)
+        {
+            if (pid > 0) waitpid(pid, nullptr, 0);
+        }
+    }
+
+    ProcessPool(const ProcessPool&) = delete;
+    ProcessPool& operator=(const ProcessPool&) = delete;
+
+    int Workers() const { return int(_pids.size()); }
+    uint64_t Restarts() const { return _restarts; }
+
+    // 队列满时返回 false
+    bool Submit(int worker, uint32_t task, uint32_t attempt)
+    {
+        Channel& channel = _channels[worker];
+        if (!channel.tasks.TryPush(TaskMsg{task, attempt, NowNs()})) return false;
+        channel.task_ready.NotifyOne();
+        return true;
+    }
+
+    // 取出所有已完成的结果，on_result(worker, result)；没有结果时最多等待 timeout
+    template<typename F>
+    size_t Poll(F&& on_result, chrono::milliseconds timeout)
+    {
+        size_t n = Drain(on_result);
+        if (n > 0) return n;
+        SharedEventCount::Key key = _shared->result_ready.PrepareWait();
+        n = Drain(on_result);
+        if (n > 0)
+        {
+            _shared->result_ready.CancelWait();
+            return n;
+        }
+        _shared->result_ready.CommitWaitUntil(key, chrono::steady_clock::now() + timeout);
+        return Drain(on_result);
+    }
+
+    // 回收已经退出的子进程：先取走它留下的结果，再清空队列并重新 fork
+    // 返回崩溃的工作进程下标，派发给它但没有结果的任务由调用方重新派发
+    template<typename F>
+    vector<int> ReapCrashed(F&& on_result)
+    {
+        vector<int> crashed;
+        for (size_t i = 0; i < _pids.size(); ++i)
+        {
+            int status = 0;
+            if (waitpid(_pids[i], &status, WNOHANG) != _pids[i]) continue;
+            Channel& channel = _channels[i];
+            ResultMsg result;
+            while (channel.results.TryPop(result)) on_result(int(i), result);
+            channel.tasks.Reset();
+            channel.results.Reset();
+            new (&channel.task_ready) SharedEventCount();
+            _restarts++;
+            crashed.push_back(int(i));
+            Spawn(int(i));
+        }
+        return crashed;
+    }
+
+private:
+    struct Shared
+    {
+        SharedEventCount result_ready;  // 父进程在这里等待任意工作进程的结果
+    };
+
+    struct Channel
+    {
+        ShmRing<TaskMsg, kRingSize> tasks;
+        ShmRing<ResultMsg, kRingSize> results;
+        SharedEventCount task_ready;
+    };
+
+    void Spawn(int index)
+    {
+        // 先刷掉父进程的输出缓冲，否则子进程退出前刷新时会重复输出
+        cout.flush();
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            throw runtime_error("fork failed");
+        }
+        if (pid == 0)
+        {
+            WorkerMain(_channels[index]);
+        }
+        _pids[index] = pid;
+    }
+
+    // 子进程主循环，不会返回
+    [[noreturn]] void WorkerMain(Channel& channel)
+    {
+        while (true)
+        {
+            TaskMsg task;
+            if (!channel.tasks.TryPop(task))
+            {
+                SharedEventCount::Key key = channel.task_ready.PrepareWait();
+                if (channel.tasks.TryPop(task))
+                {
+                    channel.task_ready.CancelWait();
+                }
+                else
+                {
+                    channel.task_ready.CommitWait(key);
+                    continue;
+                }
+            }
+            if (task.task == kStopTask) break;
+
+            ResultMsg result{task.task, task.attempt, _runner(task.task), task.sent_ns};
+            while (!channel.results.TryPush(result)) this_thread::yield();
+            _shared->result_ready.NotifyOne();
+        }
+        // 不运行父进程继承来的全局析构函数
+        cout.flush();
+        _exit(0);
+    }
+
+    template<typename F>
+    size_t Drain(F& on_result)
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < _pids.size(); ++i)
+        {
+            ResultMsg result;
+            while (_channels[i].results.TryPop(result))
+            {
+                on_result(int(i), result);
+                ++n;
+            }
+        }
+        return n;
+    }
+
+    Runner _runner;
+    SharedRegion _region;
+    Shared* _shared = nullptr;
+    Channel* _channels = nullptr;
+    vector<pid_t> _pids;
+    uint64_t _restarts = 0;
+};
+
+// 与 Executor 相同的用法：AddModule 注册模块，ExecuteAll 按依赖执行整张图
+// 第一次 ExecuteAll 时才 fork 工作进程，子进程继承此时注册的所有模块；之后不能再添加模块
+// ExecuteAll 会阻塞到整张图结束（所以没有 Executor 的 Wait），崩溃的模块最多重试 kMaxRetries 次，之后记为失败，下游跳过
+class ProcessExecutor
+{
+public:
+    static constexpr int kMaxRetries = 2;
+
+    explicit ProcessExecutor(int workers) : _worker_count(workers) {}
+
+    void AddModule(Module* module)
+    {
+        if (_pool)
+        {
+            throw runtime_error("Cannot add module " + module->Name() + " after workers started");
+        }
+        if (module->HasInProcessOutput())
+        {
+            throw invalid_argument("Module " + module->Name() +
+                                   " passes results through in-process ports, which do not cross worker processes");
+        }
+        _index[module->Name()] = uint32_t(_modules.size());
+        _modules.push_back(module);
+    }
+
+    void ExecuteAll()
+    {
+        if (!_pool) Start();
+
+        size_t n = _modules.size();
+        vector<int> indegree(n, 0);
+        vector<bool> blocked(n, false);
+        vector<int> attempts(n, 0);
+        vector<vector<uint32_t>> inflight(_pool->Workers());
+        deque<uint32_t> ready;
+        size_t done = 0;
+
+        for (uint32_t id = 0; id < n; ++id)
+        {
+            _modules[id]->ClearState();
+            indegree[id] = int(_modules[id]->Deps().size());
+            if (indegree[id] == 0) ready.push_back(id);
+        }
+
+        // 模块结束：成功则解锁下游，失败或取消则下游全部跳过
+        function<void(uint32_t, ModuleState)> finish = [&](uint32_t id, ModuleState state) {
+            Module* mod = _modules[id];
+            if (state == ModuleState::kSucc) mod->SetSucc();
+            else if (state == ModuleState::kCancelled) mod->SetCancelled();
+            else mod->SetFailed();
+            done++;
+            for (uint32_t next : _dependents[id])
+            {
+                if (state != ModuleState::kSucc) blocked[next] = true;
+                if (--indegree[next] > 0) continue;
+                if (blocked[next])
+                {
+                    cout << "Skip: " << _modules[next]->Name() << endl;
+                    finish(next, ModuleState::kCancelled);
+                }
+                else
+                {
+                    ready.push_back(next);
+                }
+            }
+        };
+
+        // 结果来自共享内存，先核对再使用：
+        //   attempt 与当前派发次数不同的是过期结果，任务已经因崩溃被重新派发，以新一次的结果为准
+        //   不在该工作进程在途列表里的任务（已经结束或从没派发给它）直接丢弃，不能重复 finish
+        auto on_result = [&](int worker, const ResultMsg& result) {
+            if (result.task >= n || result.attempt != uint32_t(attempts[result.task])) return;
+            auto& list = inflight[worker];
+            auto it = find(list.begin(), list.end(), result.task);
+            if (it == list.end()) return;
+            list.erase(it);
+            finish(result.task, ModuleState(result.state));
+        };
+
+        while (done < n)
+        {
+            // 派发给在途任务最少的工作进程
+            while (!ready.empty())
+            {
+                int worker = 0;
+                for (int w = 1; w < _pool->Workers(); ++w)
+                {
+                    if (inflight[w].size() < inflight[worker].size()) worker = w;
+                }
+                uint32_t id = ready.front();
+                if (!_pool->Submit(worker, id, uint32_t(attempts[id]))) break;
+                inflight[worker].push_back(id);
+                ready.pop_front();
+            }
+
+            _pool->Poll(on_result, chrono::milliseconds(10));
+
+            for (int worker : _pool->ReapCrashed(on_result))
+            {
+                for (uint32_t id : inflight[worker])
+                {
+                    if (++attempts[id] > kMaxRetries)
+                    {
+                        cout << "Module " << _modules[id]->Name() << " crashed " << attempts[id] << " times, giving up" << endl;
+                        finish(id, ModuleState::kFailed);
+                    }
+                    else
+                    {
+                        cout << "Worker " << worker << " crashed, rescheduling " << _modules[id]->Name() << endl;
+                        ready.push_front(id);
+                    }
+                }
+                inflight[worker].clear();
+            }
+        }
+    }
+
+    uint64_t Restarts() const { return _pool ? _pool->Restarts() : 0; }
+
+private:
+    void Start()
+    {
+        _dependents.assign(_modules.size(), {});
+        for (uint32_t id = 0; id < _modules.size(); ++id)
+        {
+            for (auto& dep : _modules[id]->Deps())
+            {
+                auto it = _index.find(dep);
+                if (it == _index.end())
+                {
+                    throw runtime_error("Module " + _modules[id]->Name() + " depends on unknown module " + dep);
+                }
+                _dependents[it->second].push_back(id);
+            }
+        }
+        _pool = make_unique<ProcessPool>(_worker_count, [this](uint32_t id) { return RunInChild(id); });
+    }
+
+    // 在子进程里执行：与 Executor 的规则相同，抛异常或没有 SetSucc 就返回都算失败
+    int32_t RunInChild(uint32_t id)
+    {
+        Module* mod = _modules[id];
+        mod->ClearState();
+        try
+        {
+            mod->Execute();
+        }
+        catch (const exception& e)
+        {
+            cout << "Module " << mod->Name() << " failed: " << e.what() << endl;
+            mod->SetFailed();
+        }
+        catch (...)
+        {
+            // 不能让它逃出去终止子进程，否则会被当成崩溃重试
+            cout << "Module " << mod->Name() << " failed: unknown exception" << endl;
+            mod->SetFailed();
+        }
+        if (!mod->CheckDone()) mod->SetFailed();
+        return int32_t(mod->State());
+    }
+
+    int _worker_count;
+    vector<Module*> _modules;
+    unordered_map<string, uint32_t> _index;
+    vector<vector<uint32_t>> _dependents;
+    unique_ptr<ProcessPool> _pool;
+};
+
+// 模拟会崩溃的插件：前 crashes 次执行直接杀死所在进程
+// 剩余崩溃次数放在 MAP_SHARED 匿名映射里，fork 出来的所有子进程共享同一个计数
+class ModuleCrashy : public Module
+{
+public:
+    ModuleCrashy(string name, vector<string> deps, int crashes) : Module(name, deps)
+    {
+        void* mem = mmap(nullptr, sizeof(atomic<int>), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED)
+        {
+            throw runtime_error("mmap failed");
+        }
+        _crashes_left = new (mem) atomic<int>(crashes);
+    }
+    ~ModuleCrashy() override { munmap(_crashes_left, sizeof(atomic<int>)); }
+
+    void Execute() override
+    {
+        if (_crashes_left->fetch_sub(1) > 0) raise(SIGKILL);
+        SetSucc();
+    }
+
+private:
+    atomic<int>* _crashes_left;
+};
+
+class ModuleNoop : public Module
+{
+public:
+    ModuleNoop(string name, vector<string> deps) : Module(name, deps) {}
+    void Execute() override { SetSucc(); }
+};
+
+// 与 DAGThreadPool.cpp::test 相同的模块和依赖，换成多进程执行
+void testProcess()
+{
+    ModuleA a("A", {});
+    ModuleB b("B", {});
+    ModuleC c("C", {"A", "B"});
+    ModuleD d("D", {"C"});
+    ModuleE e("E", {"C", "D"});
+
+    ProcessExecutor executor(4);
+    executor.AddModule(&a);
+    executor.AddModule(&b);
+    executor.AddModule(&c);
+    executor.AddModule(&d);
+    executor.AddModule(&e);
+
+    auto start = chrono::steady_clock::now();
+    executor.ExecuteAll();
+    cout << "process executor: "
+         << chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count() << " ms";
+    for (Module* mod : {static_cast<Module*>(&a), static_cast<Module*>(&b), static_cast<Module*>(&c),
+                        static_cast<Module*>(&d), static_cast<Module*>(&e)})
+    {
+        cout << " " << mod->Name() << "=" << StateName(mod->State());
+    }
+    cout << endl;
+}
+
+// 抛出非标准异常：记为失败，不当作崩溃重试
+class ModuleThrows : public Module
+{
+public:
+    ModuleThrows(string name, vector<string> deps) : Module(name, deps) {}
+    void Execute() override { throw 42; }
+};
+
+// 用端口传数据的模块
+class ModulePorts : public Module
+{
+public:
+    ModulePorts(string name, vector<string> deps) : Module(name, deps) {}
+    void Execute() override
+    {
+        out.Emplace(1);
+        SetSucc();
+    }
+    OutputPort<int> out{this};
+};
+
+// X 崩溃一次后重试成功；Y 每次都崩溃，重试用完后失败，依赖它的 Z 被跳过
+// T 抛出非标准异常，直接失败；带端口的 P 在 AddModule 时被拒绝
+void testCrash()
+{
+    ModuleCrashy x("X", {}, 1);
+    ModuleCrashy y("Y", {}, 100);
+    ModuleNoop z("Z", {"Y"});
+    ModuleNoop w("W", {"X"});
+
+    ProcessExecutor executor(2);
+    executor.AddModule(&x);
+    executor.AddModule(&y);
+    executor.AddModule(&z);
+    executor.AddModule(&w);
+    ModuleThrows t("T", {});
+    executor.AddModule(&t);
+    ModulePorts p("P", {});
+    try
+    {
+        executor.AddModule(&p);
+    }
+    catch (const invalid_argument& e)
+    {
+        cout << e.what() << endl;
+    }
+    executor.ExecuteAll();
+    cout << "X=" << StateName(x.State()) << " Y=" << StateName(y.State()) << " Z=" << StateName(z.State())
+         << " W=" << StateName(w.State()) << " T=" << StateName(t.State())
+         << " worker restarts=" << executor.Restarts() << endl;
+}
+
+void PrintLatency(const string& name, vector<double>& us)
+{
+    sort(us.begin(), us.end());
+    double sum = 0;
+    for (double v : us) sum += v;
+    cout << name << ": avg " << sum / us.size() << " us, p50 " << us[us.size() / 2] << " us, p99 "
+         << us[us.size() * 99 / 100] << " us" << endl;
+}
+
+// 往返延迟：提交一个空任务，等它的结果回来再提交下一个
+void benchLatency(int rounds)
+{
+    vector<double> in_process;
+    {
+        ThreadPool tp(1);
+        mutex mtx;
+        CondVar cv;
+        bool finished = false;
+        for (int i = 0; i < rounds; ++i)
+        {
+            auto start = chrono::steady_clock::now();
+            tp.PutTask([&]() {
+                lock_guard<mutex> lock(mtx);
+                finished = true;
+                cv.notify_one();
+            });
+            unique_lock<mutex> lock(mtx);
+            cv.wait(lock, [&]() { return finished; });
+            finished = false;
+            in_process.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+        }
+    }
+
+    vector<double> cross_process;
+    {
+        ProcessPool pool(1, [](uint32_t) { return int32_t(ModuleState::kSucc); });
+        for (int i = 0; i < rounds; ++i)
+        {
+            int64_t start = NowNs();
+            pool.Submit(0, uint32_t(i), 0);
+            bool got = false;
+            while (!got)
+            {
+                pool.Poll([&](int, const ResultMsg&) { got = true; }, chrono::milliseconds(100));
+            }
+            cross_process.push_back((NowNs() - start) / 1000.0);
+        }
+    }
+
+    PrintLatency("in-process ThreadPool ", in_process);
+    PrintLatency("ProcessPool (shm ring)", cross_process);
+}
+
+int main(int argc, char** argv)
+{
+    int rounds = argc > 1 ? atoi(argv[1]) : 20000;
+    testProcess();
+    testCrash();
+    benchLatency(rounds);
+    return 0;
+}
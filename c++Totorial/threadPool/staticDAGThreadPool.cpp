@@ -0,0 +1,458 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+using namespace std;
+
+class ThreadPool
+{
+public:
+    ThreadPool(int numThreads) : _stop(false)
+    {
+        for (int i = 0; i < numThreads; i++)
+        {
+            AddThread();
+        }
+    }
+    ~ThreadPool()
+    {
+        {
+            unique_lock<mutex> lock(_mutex);
+            _stop = true;
+        }
+        _cv.notify_all();
+        for (auto &thread : _pool)
+        {
+            if (thread.joinable())
+            {
+                thread.join();
+            }
+        }
+    }
+
+    void AddThread()
+    {
+        _pool.emplace_back([this]()
+        {
+            while (true)
+            {
+                Task task;
+                {
+                    unique_lock<mutex> lock(_mutex);
+                    _cv.wait(lock, [this]() { return _stop || !_tasks.empty(); });
+                    if (_stop && _tasks.empty())
+                    {
+                        return;
+                    }
+                    task = move(_tasks.front());
+                    _tasks.pop_front();
+                }
+                if (task.raw) task.raw(task.arg);
+                else task.func();
+            }
+        });
+    }
+
+    template<typename F, typename... Args>
+    void PutTask(F &&f, Args &&...args)
+    {
+        auto func = bind(forward<F>(f), forward<Args>(args)...);
+        {
+            unique_lock<mutex> lck(_mutex);
+            _tasks.push_back(Task{func, nullptr, nullptr});
+        }
+        _cv.notify_one();
+    }
+
+    // 只有函数指针和参数的任务，不经过 function 包装，入队时不为闭包分配内存
+    void PutRawTask(void (*fn)(void*), void* arg)
+    {
+        {
+            unique_lock<mutex> lck(_mutex);
+            _tasks.push_back(Task{nullptr, fn, arg});
+        }
+        _cv.notify_one();
+    }
+private:
+    struct Task
+    {
+        function<void()> func;
+        void (*raw)(void*) = nullptr;
+        void* arg = nullptr;
+    };
+
+    deque<Task> _tasks;
+    vector<thread> _pool;
+    mutex _mutex;
+    condition_variable _cv;
+    bool _stop;
+};
+
+// 编译期静态 DAG：模块和边都用类型声明
+// 拓扑序、分层和环检测都在编译期算好，有环直接编译失败
+// 执行时按拓扑序展开成直接调用，没有虚函数、没有按名字查表、没有内存分配
+template<typename... Ts>
+struct TypeList {};
+
+template<typename From, typename To>
+struct Edge
+{
+    using from = From;
+    using to = To;
+};
+
+// 类型在列表中的下标，不在列表中时返回列表长度
+template<typename T, typename... Ts>
+constexpr size_t IndexOf()
+{
+    constexpr bool matches[] = {is_same<T, Ts>::value..., false};
+    for (size_t i = 0; i < sizeof...(Ts); ++i)
+    {
+        if (matches[i]) return i;
+    }
+    return sizeof...(Ts);
+}
+
+template<typename ModuleList, typename EdgeList>
+class StaticDAG;
+
+template<typename... Modules, typename... Edges>
+class StaticDAG<TypeList<Modules...>, TypeList<Edges...>>
+{
+public:
+    static constexpr size_t kNodeCount = sizeof...(Modules);
+    static constexpr size_t kEdgeCount = sizeof...(Edges);
+
+    struct TopoResult
+    {
+        array<size_t, kNodeCount> order{};           // 拓扑序，同一层的节点连续存放
+        array<size_t, kNodeCount + 1> level_begin{}; // 第 L 层在 order 中的区间 [level_begin[L], level_begin[L+1])
+        size_t count = 0;                            // 排好的节点数，小于 kNodeCount 说明有环
+        size_t levels = 0;
+    };
+
+private:
+    static constexpr size_t kFrom[kEdgeCount + 1] = {IndexOf<typename Edges::from, Modules...>()..., 0};
+    static constexpr size_t kTo[kEdgeCount + 1] = {IndexOf<typename Edges::to, Modules...>()..., 0};
+
+    static constexpr bool EdgesValid()
+    {
+        for (size_t e = 0; e < kEdgeCount; ++e)
+        {
+            if (kFrom[e] >= kNodeCount || kTo[e] >= kNodeCount) return false;
+        }
+        return true;
+    }
+
+    // 编译期分层 Kahn：每轮取出所有入度为 0 的节点作为一层
+    static constexpr TopoResult Compute()
+    {
+        TopoResult result{};
+        array<size_t, kNodeCount> indegree{};
+        array<bool, kNodeCount> done{};
+        for (size_t e = 0; e < kEdgeCount; ++e) indegree[kTo[e]]++;
+
+        while (true)
+        {
+            array<bool, kNodeCount> ready{};
+            bool any = false;
+            for (size_t i = 0; i < kNodeCount; ++i)
+            {
+                if (!done[i] && indegree[i] == 0)
+                {
+                    ready[i] = true;
+                    any = true;
+                }
+            }
+            if (!any) break;
+
+            result.level_begin[result.levels] = result.count;
+            for (size_t i = 0; i < kNodeCount; ++i)
+            {
+                if (!ready[i]) continue;
+                done[i] = true;
+                result.order[result.count++] = i;
+                for (size_t e = 0; e < kEdgeCount; ++e)
+                {
+                    if (kFrom[e] == i) indegree[kTo[e]]--;
+                }
+            }
+            result.levels++;
+        }
+        result.level_begin[result.levels] = result.count;
+        return result;
+    }
+
+    static_assert(EdgesValid(), "StaticDAG: edge refers to a module that is not in the module list");
+
+public:
+    static constexpr TopoResult kTopo = Compute();
+    static_assert(kTopo.count == kNodeCount, "StaticDAG: dependency cycle detected");
+
+    using Storage = tuple<Modules...>;
+
+    // 串行执行：按编译期拓扑序展开成一串直接调用
+    static void RunSerial(Storage& modules)
+    {
+        RunSerialImpl(modules, make_index_sequence<kNodeCount>());
+    }
+
+    // 在线程池上按层并行执行：层内并行，层间等待
+    // 调用线程执行每层的最后一个模块，其余交给线程池；派发的是编译期生成的按节点跳板函数，不分配内存
+    // 模块抛出的异常在本层所有模块结束后重新抛出（有多个时取第一个），后面的层不再执行
+    static void RunParallel(Storage& modules, ThreadPool& tp)
+    {
+        for (size_t level = 0; level < kTopo.levels; ++level)
+        {
+            size_t begin = kTopo.level_begin[level];
+            size_t end = kTopo.level_begin[level + 1];
+            if (end - begin == 1)
+            {
+                kDispatch[kTopo.order[begin]](modules);
+                continue;
+            }
+
+            LevelJoin join(modules);
+            exception_ptr error;
+            try
+            {
+                for (size_t i = begin; i + 1 < end; ++i)
+                {
+                    join.Add();
+                    try
+                    {
+                        tp.PutRawTask(kRemoteDispatch[kTopo.order[i]], &join);
+                    }
+                    catch (...)
+                    {
+                        join.Done(nullptr);
+                        throw;
+                    }
+                }
+                kDispatch[kTopo.order[end - 1]](modules);
+            }
+            catch (...)
+            {
+                error = current_exception();
+            }
+            // 出错时也要等：已派发的任务引用着栈上的 join
+            join.Wait();
+            if (!error) error = join.error;
+            if (error) rethrow_exception(error);
+        }
+    }
+
+    static const char* Name(size_t index) { return kNames[index]; }
+
+private:
+    // 一层里派发到线程池的模块的汇合点，放在 RunParallel 的栈上
+    struct LevelJoin
+    {
+        explicit LevelJoin(Storage& storage) : modules(&storage) {}
+
+        void Add()
+        {
+            lock_guard<mutex> lock(mtx);
+            ++pending;
+        }
+        // 在锁内通知：等待方拿到锁返回后 join 就会析构
+        void Done(exception_ptr e)
+        {
+            lock_guard<mutex> lock(mtx);
+            if (e && !error) error = e;
+            if (--pending == 0) cv.notify_one();
+        }
+        void Wait()
+        {
+            unique_lock<mutex> lock(mtx);
+            cv.wait(lock, [this]() { return pending == 0; });
+        }
+
+        Storage* modules;
+        mutex mtx;
+        condition_variable cv;
+        size_t pending = 0;
+        exception_ptr error;
+    };
+
+    template<size_t... I>
+    static void RunSerialImpl(Storage& modules, index_sequence<I...>)
+    {
+        (get<kTopo.order[I]>(modules).Execute(), ...);
+    }
+
+    template<size_t I>
+    static void Call(Storage& modules)
+    {
+        get<I>(modules).Execute();
+    }
+
+    template<size_t... I>
+    static constexpr array<void (*)(Storage&), kNodeCount> MakeDispatch(index_sequence<I...>)
+    {
+        return {{&Call<I>...}};
+    }
+
+    // 线程池上的跳板：执行模块，把异常交给 LevelJoin，工作线程里不会有异常逃出去
+    template<size_t I>
+    static void CallRemote(void* arg)
+    {
+        LevelJoin* join = static_cast<LevelJoin*>(arg);
+        exception_ptr error;
+        try
+        {
+            get<I>(*join->modules).Execute();
+        }
+        catch (...)
+        {
+            error = current_exception();
+        }
+        join->Done(error);
+    }
+
+    template<size_t... I>
+    static constexpr array<void (*)(void*), kNodeCount> MakeRemoteDispatch(index_sequence<I...>)
+    {
+        return {{&CallRemote<I>...}};
+    }
+
+    // 编译期生成的跳转表：下标 -> 对应模块的 Execute，用于线程池按下标派发
+    static constexpr array<void (*)(Storage&), kNodeCount> kDispatch = MakeDispatch(make_index_sequence<kNodeCount>());
+    static constexpr array<void (*)(void*), kNodeCount> kRemoteDispatch =
+        MakeRemoteDispatch(make_index_sequence<kNodeCount>());
+    static constexpr const char* kNames[kNodeCount] = {Modules::kName...};
+};
+
+// 示例模块：普通结构体，只需要 kName 和 Execute()
+atomic<int> g_counter{0};
+
+template<char Id>
+struct StaticModule
+{
+    static constexpr char kName[2] = {Id, '\0'};
+    void Execute() { g_counter.fetch_add(1, memory_order_relaxed); }
+};
+
+using A = StaticModule<'A'>;
+using B = StaticModule<'B'>;
+using C = StaticModule<'C'>;
+using D = StaticModule<'D'>;
+using E = StaticModule<'E'>;
+
+// 与 DAGThreadPool.cpp::test 相同的图：C 依赖 A、B，D 依赖 C，E 依赖 C、D
+using FrameGraph = StaticDAG<TypeList<A, B, C, D, E>,
+                             TypeList<Edge<A, C>, Edge<B, C>, Edge<C, D>, Edge<C, E>, Edge<D, E>>>;
+
+// 有环的图无法通过编译：
+// using BadGraph = StaticDAG<TypeList<A, B>, TypeList<Edge<A, B>, Edge<B, A>>>;
+// static_assert(BadGraph::kNodeCount == 2, "");  // error: StaticDAG: dependency cycle detected
+
+// 计算失败的模块：并行执行时异常在本层结束后抛给调用方，下一层不再执行
+struct Faulty
+{
+    static constexpr char kName[2] = {'F', '\0'};
+    void Execute() { throw runtime_error("compute error"); }
+};
+using FaultyGraph = StaticDAG<TypeList<Faulty, A, B>, TypeList<Edge<Faulty, B>, Edge<A, B>>>;
+
+// 编译期就能检查调度结果
+static_assert(FrameGraph::kTopo.levels == 4, "A,B | C | D | E");
+static_assert(FrameGraph::kTopo.order[FrameGraph::kNodeCount - 1] == 4, "E runs last");
+
+// 对照组：虚函数 + 按名字查表的动态执行方式
+class DynModule
+{
+public:
+    virtual ~DynModule() = default;
+    virtual void Execute() = 0;
+};
+
+class DynCounter : public DynModule
+{
+public:
+    void Execute() override { g_counter.fetch_add(1, memory_order_relaxed); }
+};
+
+void test1()
+{
+    cout << "拓扑序:";
+    for (size_t level = 0; level < FrameGraph::kTopo.levels; ++level)
+    {
+        cout << " [";
+        for (size_t i = FrameGraph::kTopo.level_begin[level]; i < FrameGraph::kTopo.level_begin[level + 1]; ++i)
+        {
+            cout << (i == FrameGraph::kTopo.level_begin[level] ? "" : " ")
+                 << FrameGraph::Name(FrameGraph::kTopo.order[i]);
+        }
+        cout << "]";
+    }
+    cout << endl;
+
+    FrameGraph::Storage modules;
+    FrameGraph::RunSerial(modules);
+    ThreadPool tp(2);
+    FrameGraph::RunParallel(modules, tp);
+    cout << "executed: " << g_counter << endl;
+
+    // F 在线程池上执行，A 在调用线程上执行，B 依赖两者
+    FaultyGraph::Storage faulty;
+    int before = g_counter;
+    try
+    {
+        FaultyGraph::RunParallel(faulty, tp);
+    }
+    catch (const exception& e)
+    {
+        cout << "caught: " << e.what() << ", executed after F: " << g_counter - before << " (A only)" << endl;
+    }
+}
+
+// 每帧调度开销：静态展开 vs 虚函数 + 名字查表
+void bench()
+{
+    const int frames = 1000000;
+    FrameGraph::Storage modules;
+    g_counter = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i)
+    {
+        FrameGraph::RunSerial(modules);
+    }
+    double static_ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / frames;
+
+    unordered_map<string, unique_ptr<DynModule>> dyn_modules;
+    vector<string> order = {"A", "B", "C", "D", "E"};
+    for (auto& name : order) dyn_modules[name] = make_unique<DynCounter>();
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i)
+    {
+        for (auto& name : order) dyn_modules[name]->Execute();
+    }
+    double dynamic_ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / frames;
+
+    cout << "static dispatch:  " << static_ns << " ns/frame" << endl;
+    cout << "dynamic dispatch: " << dynamic_ns << " ns/frame" << endl;
+    cout << "executed: " << g_counter << endl;
+}
+
+int main()
+{
+    test1();
+    bench();
+    return 0;
+}
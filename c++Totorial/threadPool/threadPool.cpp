@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <iostream>
@@ -7,6 +9,9 @@
 #include <vector>
 using namespace std;
 
+#include "../syncTypes/SyncTypes.h"
+#include "../semaphore/RateLimiter.h"
+
 class threadPool
 {
 public:
@@ -21,7 +26,7 @@ public:
     ~threadPool()
     {
         {
-            unique_lock<mutex> lock(_mutex);
+            unique_lock<Mutex> lock(_mutex);
             _stop = true;
         }
 
@@ -43,18 +48,32 @@ public:
         {
             while (true)
             {
-                function<void()> task;
+                TaskFunc task;
+                size_t wake = 0;
                 {
-                    unique_lock<mutex> lock(_mutex);
-                    _cv.wait(lock, [this]() { return !_task.empty() || _stop; });
+                    unique_lock<Mutex> lock(_mutex);
+                    size_t promoted = 0;
+                    while (true)
+                    {
+                        promoted += PromoteDelayed();
+                        if (!_task.empty() || _stop) break;
+                        _delayed.Wait(_cv, lock);
+                    }
                     
                     if (_stop && _task.empty())
                     {
                         return; // 停止线程
                     }
                     
-                    task = std::move(_task.front()); // 取出任务
+                    task = std::move(_task.front().task); // 取出任务
                     _task.pop();
+                    wake = min(promoted, _task.size());
+                }
+
+                // 一次移过来多个到期任务时，叫醒别的线程一起执行
+                for (size_t i = 0; i < wake; ++i)
+                {
+                    _cv.notify_one();
                 }
 
                 task();
@@ -68,21 +87,81 @@ public:
     {
         auto task = bind(std::forward<F>(f), std::forward<Args>(args)...);
         {
-            unique_lock<mutex> lock(_mutex);
-            _task.emplace(task);  // 添加任务到队列
+            unique_lock<Mutex> lock(_mutex);
+            _task.push(QueuedTask{std::move(task), NowNs()});  // 添加任务到队列
         }
 
         _cv.notify_one();  // 唤醒一个线程执行任务
     }
 
+    // 延时提交（见 semaphore/RateLimiter.h 的 DelayedQueue）；线程池析构时剩余的延时任务立即执行
+    template <typename F>
+    void CommitAfter(chrono::nanoseconds delay, F &&f)
+    {
+        if (delay <= chrono::nanoseconds::zero())
+        {
+            Commit(std::forward<F>(f));
+            return;
+        }
+        bool earliest;
+        {
+            unique_lock<Mutex> lock(_mutex);
+            earliest = _delayed.Push(delay, TaskFunc(std::forward<F>(f)));
+        }
+        if (earliest) _cv.notify_one();
+    }
+
+    // 准入控制只管 Submit 提交的任务，Commit 不受影响
+    void SetAdmission(AdmissionHook hook) { _admission.Set(std::move(hook)); }
+
+    // 经过准入控制的提交，被拒绝时返回 false，任务不会执行
+    template <typename F>
+    bool Submit(F &&f, double cost = 1.0)
+    {
+        return _admission.Submit(QueueLatency(), cost,
+            [&]() { Commit(std::forward<F>(f)); },
+            [&](chrono::nanoseconds delay) { CommitAfter(delay, std::forward<F>(f)); });
+    }
+
+    // 排队延迟：队首任务已经等了多久（队列为空时为 0）
+    chrono::nanoseconds QueueLatency()
+    {
+        unique_lock<Mutex> lock(_mutex);
+        if (_task.empty()) return chrono::nanoseconds::zero();
+        return chrono::nanoseconds(NowNs() - _task.front().enqueued_ns);
+    }
+
 private:
+    struct QueuedTask
+    {
+        TaskFunc task;
+        int64_t enqueued_ns;       // 入队时间，用来算排队延迟
+    };
+
+    // 到期的延时任务移到任务队列
+    size_t PromoteDelayed()
+    {
+        return _delayed.Promote(_stop, [this](TaskFunc&& task) {
+            _task.push(QueuedTask{std::move(task), NowNs()});
+        });
+    }
+
+    static int64_t NowNs()
+    {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
     vector<thread> _pool;          // 线程池
-    queue<function<void()>> _task; // 任务队列
-    mutex _mutex;                  // 互斥锁
-    condition_variable _cv;        // 条件变量
+    queue<QueuedTask> _task;       // 任务队列
+    DelayedQueue<TaskFunc> _delayed;  // 延时任务，按到期时间排序
+    Mutex _mutex;                  // 互斥锁
+    CondVar _cv;                   // 条件变量
     bool _stop = false;           // 停止标记位
+    AdmissionGate _admission;      // 准入控制，没有设置钩子时全部接受
 };
 
+// bench/ 下的基准复用本文件的线程池时会定义这个宏
+#ifndef THREAD_POOL_NO_MAIN
 // 打印函数
 void Print(int num)
 {
@@ -92,11 +171,17 @@ void Print(int num)
 // 主函数
 int main()
 {
-    threadPool pool(4);  // 创建线程池，容量为4
+    {
+        threadPool pool(4);  // 创建线程池，容量为4
 
-    // 提交8个任务
-    for (int i = 0; i < 8; i++) {
-        pool.Commit(Print, i);
+        // 提交8个任务
+        for (int i = 0; i < 8; i++) {
+            pool.Commit(Print, i);
+        }
     }
+#ifdef LOCK_PROFILING
+    LockProfiler::Print(cout);
+#endif
     return 0;
 }
+#endif